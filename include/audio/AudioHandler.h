@@ -10,19 +10,53 @@
 #define DICTA_AUDIOHANDLER_H
 
 #include <iostream>
+#include <algorithm>
 #include <array>
-#include <boost/circular_buffer.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <soundio/soundio.h>
 #include "SoundIoException.h"
+#include "AudioSource.h"
+#include "RingBuffer.hpp"
+#include "SampleConversion.h"
 
 namespace Dicta
 {
-    class AudioHandler
+    struct DeviceOptions
+    {
+        // Index on libsoundio's input device list, -1 for the default input device
+        int deviceIndex = -1;
+        // Keeps every channel on its own ring buffer instead of downmixing them to mono
+        bool splitChannels = false;
+        // Capture format, SoundIoFormatInvalid picking the device's first format among the signed 16, 24 and
+        // 32 bit and float ones, which the callback converts itself instead of leaving it to the driver
+        SoundIoFormat format = SoundIoFormatInvalid;
+        // Seconds of audio the backend gathers before each callback, zero leaving it to the backend
+        double softwareLatency = 0;
+        // Capture the ring buffers hold. A small one keeps a slow consumer from building a backlog that
+        // hides how late it is, the device's newest samples being dropped once it's full.
+        double ringBufferSeconds = 30;
+        // Locks the ring buffers and the callback's state in memory, so the callback never waits on the pager.
+        // Limited by RLIMIT_MEMLOCK, the constructor throws if the lock is refused.
+        bool lockMemory = false;
+        
+        // Short callbacks and a ring of a few of them, for interactive use
+        static DeviceOptions lowLatency(double softwareLatency = 0.005)
+        {
+            DeviceOptions options;
+            options.softwareLatency = softwareLatency;
+            options.ringBufferSeconds = std::max(20 * softwareLatency, 0.1);
+            return options;
+        }
+    };
+    
+    class AudioHandler : public AudioSource
     {
         friend std::ostream& operator<<(std::ostream& out, const AudioHandler& o);
         
         public:
-        AudioHandler();
+        AudioHandler(const DeviceOptions& options = {});
         ~AudioHandler() noexcept;
         
         // Deleted copy and move constructors and operators
@@ -35,29 +69,112 @@ namespace Dicta
         SoundIo* soundIo = nullptr;
         SoundIoDevice* device = nullptr;
         SoundIoInStream* inStream = nullptr;
-        boost::circular_buffer<float>* circularBuffer = nullptr;
-        SoundIoFormat format = SoundIoFormatFloat32NE;
+        // A single downmixed ring buffer, or one per channel when split
+        std::vector<std::unique_ptr<RingBuffer<float>>> ringBuffers;
+        DeviceOptions options;
+        SoundIoFormat format = SoundIoFormatInvalid;
+        SampleFormat sampleFormat = SampleFormat::Float32;
         int sampleRate = 0;
-        const int circularBufferDuration = 30;
+        std::atomic<bool> started{false};
+        // First error of the stream, set from the callbacks and thrown by the next read
+        std::atomic<int> streamError{0};
+        bool memoryLocked = false;
+        
+        // Where the first ring buffer's head was at the end of each of the latest callbacks and when that
+        // callback ran, a seqlock each: the callback zeroes endSample, writes time, then the new endSample
+        struct CaptureAnchor
+        {
+            std::atomic<std::uint64_t> endSample{0};
+            std::atomic<std::int64_t> time{0};
+        };
+        static constexpr std::size_t anchorCount = 64;
+        std::array<CaptureAnchor, anchorCount> anchors;
+        std::atomic<std::uint64_t> anchorsWritten{0};
         
         void initializeSoundIoContext();
         void initializeDevice();
         void selectSampleRate();
-        void checkSupportedFormat();
+        void selectFormat();
         void initializeInputStream();
         void openInputStream();
-        void initializeCircularBuffer();
+        void initializeRingBuffer();
+        
+        void lockMemory();
         
+        // libsoundio's callbacks, run on its realtime thread: they never throw, block nor allocate
         static void readCallback(SoundIoInStream* inStream, int frameCountMin, int frameCountMax);
+        static void overflowCallback(SoundIoInStream* inStream);
+        static void errorCallback(SoundIoInStream* inStream, int error);
+        
+        // Keeps the first error for the reader to throw, the stream is of no use past it
+        void failStream(int error);
+        
+        void print(std::ostream& out) const override;
         
         public:
-        auto getCircularBuffer() const
-        { return this->circularBuffer; }
+        auto getRingBuffer(int channel = 0) const
+        { return this->ringBuffers[channel].get(); }
+        
+        // Ring buffers kept, the device's channel count when split, otherwise 1
+        int getChannelCount() const
+        { return static_cast<int>(this->ringBuffers.size()); }
         
-        auto getSampleRate() const
+        int getSampleRate() const override
         { return this->sampleRate; }
         
+        // Starts capturing, later calls do nothing
         void startInputStream();
+        
+        void start() override
+        { this->startInputStream(); }
+        
+        // Reads the downmix, or the first channel when split
+        std::size_t read(float* destination, std::size_t count) override
+        { return this->readChannel(0, destination, count); }
+        
+        // Throws once the stream failed, instead of waiting for samples that won't come
+        std::size_t readChannel(int channel, float* destination, std::size_t count);
+        
+        std::size_t availableSamples() const override
+        { return this->ringBuffers[0]->availableToRead(); }
+        
+        std::int64_t getCaptureTime() const override
+        { return this->getChannelCaptureTime(0); }
+        
+        // When the callback that delivered the latest sample read from channel ran, zero before any read.
+        // Positions are counted on the first ring buffer, which the others match unless samples were dropped.
+        std::int64_t getChannelCaptureTime(int channel) const;
+        
+        // Every ring buffer of the handler as a source of its own, for per channel extraction
+        static std::vector<std::unique_ptr<AudioSource>> openChannels(const std::shared_ptr<AudioHandler>& handler);
+    };
+    
+    // One channel of an AudioHandler, sharing its ownership so the device outlives every channel
+    class AudioChannel : public AudioSource
+    {
+        private:
+        std::shared_ptr<AudioHandler> handler;
+        int channel;
+        
+        void print(std::ostream& out) const override;
+        
+        public:
+        AudioChannel(std::shared_ptr<AudioHandler> handler, int channel);
+        
+        int getSampleRate() const override
+        { return this->handler->getSampleRate(); }
+        
+        void start() override
+        { this->handler->startInputStream(); }
+        
+        std::size_t read(float* destination, std::size_t count) override
+        { return this->handler->readChannel(this->channel, destination, count); }
+        
+        std::size_t availableSamples() const override
+        { return this->handler->getRingBuffer(this->channel)->availableToRead(); }
+        
+        std::int64_t getCaptureTime() const override
+        { return this->handler->getChannelCaptureTime(this->channel); }
     };
     
     std::ostream& operator<<(std::ostream& out, const AudioHandler& audioHandler);
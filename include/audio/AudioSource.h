@@ -0,0 +1,56 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_AUDIOSOURCE_H
+#define DICTA_AUDIOSOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+namespace Dicta
+{
+    // Anything that can feed mono float samples in [-1, 1] to the PreProcessor
+    class AudioSource
+    {
+        friend std::ostream& operator<<(std::ostream& out, const AudioSource& audioSource);
+        
+        public:
+        virtual ~AudioSource() = default;
+        
+        virtual int getSampleRate() const = 0;
+        
+        virtual void start() = 0;
+        
+        // Copies exactly count samples to destination, waiting for them if needed.
+        // Returns less than count only when the source has ended.
+        virtual std::size_t read(float* destination, std::size_t count) = 0;
+        
+        // Samples read() can deliver right now without waiting. Sources that never make the reader wait,
+        // like files, report the maximum, their read() returning less only once they've ended.
+        virtual std::size_t availableSamples() const
+        { return std::numeric_limits<std::size_t>::max(); }
+        
+        // Steady clock nanoseconds at which the latest sample read() returned was captured, zero for
+        // sources that don't know, like files
+        virtual std::int64_t getCaptureTime() const
+        { return 0; }
+        
+        private:
+        virtual void print(std::ostream& out) const = 0;
+    };
+    
+    inline std::ostream& operator<<(std::ostream& out, const AudioSource& audioSource)
+    {
+        audioSource.print(out);
+        return out;
+    }
+}
+
+#endif //DICTA_AUDIOSOURCE_H
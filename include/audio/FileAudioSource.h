@@ -0,0 +1,86 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FILEAUDIOSOURCE_H
+#define DICTA_FILEAUDIOSOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "AudioSource.h"
+#include "SampleConversion.h"
+
+namespace Dicta
+{
+    // Layout of headerless PCM files, which can't describe themselves
+    struct RawAudioFormat
+    {
+        int sampleRate;
+        int channelCount;
+        SampleFormat sampleFormat;
+    };
+    
+    // Memory maps a WAV or raw PCM file and converts samples straight from the mapped pages,
+    // so a whole file is delivered as fast as the consumer can take it, not at wall-clock rate
+    class FileAudioSource : public AudioSource
+    {
+        friend std::ostream& operator<<(std::ostream& out, const FileAudioSource& fileAudioSource);
+        
+        public:
+        FileAudioSource(const std::string& fileName);
+        FileAudioSource(const std::string& fileName, RawAudioFormat rawAudioFormat);
+        ~FileAudioSource() noexcept;
+        
+        // Deleted copy and move constructors and operators
+        FileAudioSource(const FileAudioSource&) = delete;
+        FileAudioSource& operator=(const FileAudioSource&) = delete;
+        FileAudioSource(FileAudioSource&&) = delete;
+        FileAudioSource& operator=(FileAudioSource&&) = delete;
+        
+        private:
+        std::string fileName;
+        const std::uint8_t* mappedFile = nullptr;
+        std::size_t mappedSize = 0;
+        const std::uint8_t* samples = nullptr;
+        std::size_t frameCount = 0;
+        std::size_t currentFrame = 0;
+        int sampleRate = 0;
+        int channelCount = 0;
+        int selectedChannel = -1;
+        SampleFormat sampleFormat = SampleFormat::Signed16;
+        std::size_t bytesPerSample = 0;
+        
+        void mapFile();
+        void parseWaveHeader();
+        void setSampleData(const std::uint8_t* begin, std::size_t size);
+        
+        void print(std::ostream& out) const override;
+        
+        public:
+        int getSampleRate() const override
+        { return this->sampleRate; }
+        
+        auto getFrameCount() const
+        { return this->frameCount; }
+        
+        auto getChannelCount() const
+        { return this->channelCount; }
+        
+        // Reads a single channel instead of the downmix of all of them, -1 goes back to the downmix
+        void selectChannel(int channel);
+        
+        void start() override
+        {}
+        
+        std::size_t read(float* destination, std::size_t count) override;
+    };
+    
+    std::ostream& operator<<(std::ostream& out, const FileAudioSource& fileAudioSource);
+}
+
+#endif //DICTA_FILEAUDIOSOURCE_H
@@ -0,0 +1,119 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_RESAMPLER_H
+#define DICTA_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "AudioSource.h"
+
+namespace Dicta
+{
+    // Streaming rational resampler, by up / down = outputRate / inputRate in lowest terms. The Kaiser windowed
+    // sinc low pass is split in up phases of tapsPerPhase taps each, stored reversed, so every output sample is
+    // one vectorized dot product between a phase and the latest input samples, and the up - 1 zeros a textbook
+    // interpolator would insert are never multiplied. The filter's delay is compensated, so output sample n
+    // lines up with input time n * down / up.
+    class PolyphaseResampler
+    {
+        private:
+        std::size_t inputRate;
+        std::size_t outputRate;
+        std::size_t up;
+        std::size_t down;
+        std::size_t tapsPerPhase;
+        // Filter delay, in samples at inputRate * up
+        std::size_t delay;
+        std::vector<float> phases;
+        
+        // Input samples still needed, input[bufferStart] on, the first ones being zeros before the stream
+        std::vector<float> buffer;
+        std::int64_t bufferStart;
+        std::uint64_t nextOutput = 0;
+        std::uint64_t outputLimit = std::numeric_limits<std::uint64_t>::max();
+        
+        // Latest input sample output n needs
+        std::int64_t lastInputFor(std::uint64_t output) const
+        { return static_cast<std::int64_t>((output * this->down + this->delay) / this->up); }
+        
+        std::int64_t bufferEnd() const
+        { return this->bufferStart + static_cast<std::int64_t>(this->buffer.size()); }
+        
+        public:
+        // passband is the share of the lower Nyquist frequency kept flat, the transition band ending right at
+        // it with attenuation dB of rejection
+        PolyphaseResampler(std::size_t inputRate, std::size_t outputRate, double passband = 0.8, double attenuation = 70);
+        
+        auto getInputRate() const
+        { return this->inputRate; }
+        
+        auto getOutputRate() const
+        { return this->outputRate; }
+        
+        auto getTapsPerPhase() const
+        { return this->tapsPerPhase; }
+        
+        auto getPhaseCount() const
+        { return this->up; }
+        
+        void push(const float* input, std::size_t count);
+        
+        // Marks the end of the input, making the outputs up to its last sample available
+        void finish();
+        
+        // Writes up to count output samples the input pushed so far allows, returning how many
+        std::size_t pull(float* output, std::size_t count);
+        
+        // Outputs pull() would give after count more input samples
+        std::size_t availableWith(std::size_t count) const;
+        
+        // Input samples to push before count more outputs are available
+        std::size_t inputNeeded(std::size_t count) const;
+    };
+    
+    // Resamples another source on the fly, so framing and features run at the rate they were tuned for
+    // whatever rate the device or file has
+    class ResamplingAudioSource : public AudioSource
+    {
+        private:
+        static constexpr std::size_t chunkSize = 4096;
+        
+        std::unique_ptr<AudioSource> source;
+        PolyphaseResampler resampler;
+        std::vector<float> chunk;
+        bool ended = false;
+        
+        void print(std::ostream& out) const override;
+        
+        public:
+        ResamplingAudioSource(std::unique_ptr<AudioSource> source, int sampleRate);
+        
+        int getSampleRate() const override
+        { return static_cast<int>(this->resampler.getOutputRate()); }
+        
+        void start() override
+        { this->source->start(); }
+        
+        std::size_t read(float* destination, std::size_t count) override;
+        
+        std::size_t availableSamples() const override;
+        
+        // The inner source's, a few samples past the latest output because of the filter's delay
+        std::int64_t getCaptureTime() const override
+        { return this->source->getCaptureTime(); }
+        
+        AudioSource& getSource()
+        { return *this->source; }
+    };
+}
+
+#endif //DICTA_RESAMPLER_H
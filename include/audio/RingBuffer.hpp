@@ -0,0 +1,175 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_RINGBUFFER_H
+#define DICTA_RINGBUFFER_H
+
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+#include <sys/mman.h>
+
+namespace Dicta
+{
+    // Lock-free single producer / single consumer ring buffer. The producer (audio callback) only
+    // touches head and the consumer (framing thread) only touches tail, each on its own cache line.
+    template <class T>
+    class RingBuffer
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "RingBuffer only holds trivially copyable types");
+        
+        private:
+        static constexpr std::size_t cacheLineSize = 64;
+        
+        std::size_t bufferCapacity;
+        std::size_t mask;
+        T* buffer;
+        bool locked = false;
+        
+        alignas(cacheLineSize) std::atomic<std::size_t> head{0};
+        alignas(cacheLineSize) std::atomic<std::size_t> tail{0};
+        
+        public:
+        // The buffer is zeroed, so its pages are mapped before the producer first writes to them
+        RingBuffer(std::size_t minimumCapacity) :
+                bufferCapacity(getNextPowerOf2(minimumCapacity)),
+                mask(bufferCapacity - 1),
+                buffer(new T[bufferCapacity]())
+        {}
+        
+        ~RingBuffer()
+        {
+            if (this->locked)
+                munlock(this->buffer, this->bufferCapacity * sizeof(T));
+            delete[] this->buffer;
+        }
+        
+        // Deleted copy and move constructors and operators
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+        RingBuffer(RingBuffer&&) = delete;
+        RingBuffer& operator=(RingBuffer&&) = delete;
+        
+        // Producer side, never blocks nor allocates. Returns how many items were actually written,
+        // which is less than count only when the buffer is full.
+        std::size_t write(const T* data, std::size_t count)
+        {
+            auto currentHead = this->head.load(std::memory_order_relaxed);
+            auto currentTail = this->tail.load(std::memory_order_acquire);
+            
+            count = std::min(count, this->bufferCapacity - (currentHead - currentTail));
+            this->copyIn(currentHead, data, count);
+            
+            this->head.store(currentHead + count, std::memory_order_release);
+            return count;
+        }
+        
+        // Producer side, lets convert(destination, offset, count) write items [offset, offset + count) of
+        // the next count straight into the buffer, in at most two contiguous parts, and publishes them at once.
+        // Returns how many items were actually written, which is less than count only when the buffer is full.
+        template <class Convert>
+        std::size_t produce(std::size_t count, Convert&& convert)
+        {
+            auto currentHead = this->head.load(std::memory_order_relaxed);
+            auto currentTail = this->tail.load(std::memory_order_acquire);
+            
+            count = std::min(count, this->bufferCapacity - (currentHead - currentTail));
+            auto index = currentHead & this->mask;
+            auto firstPart = std::min(count, this->bufferCapacity - index);
+            if (firstPart)
+                convert(this->buffer + index, std::size_t{0}, firstPart);
+            if (count != firstPart)
+                convert(this->buffer, firstPart, count - firstPart);
+            
+            this->head.store(currentHead + count, std::memory_order_release);
+            return count;
+        }
+        
+        // Producer side, writes count copies of value (used to fill holes with silence)
+        std::size_t fill(const T& value, std::size_t count)
+        {
+            auto currentHead = this->head.load(std::memory_order_relaxed);
+            auto currentTail = this->tail.load(std::memory_order_acquire);
+            
+            count = std::min(count, this->bufferCapacity - (currentHead - currentTail));
+            for (std::size_t pos = 0; pos != count; ++pos)
+                this->buffer[(currentHead + pos) & this->mask] = value;
+            
+            this->head.store(currentHead + count, std::memory_order_release);
+            return count;
+        }
+        
+        // Consumer side, reads up to count items. Returns how many items were actually read.
+        std::size_t read(T* data, std::size_t count)
+        {
+            auto currentTail = this->tail.load(std::memory_order_relaxed);
+            auto currentHead = this->head.load(std::memory_order_acquire);
+            
+            count = std::min(count, currentHead - currentTail);
+            this->copyOut(currentTail, data, count);
+            
+            this->tail.store(currentTail + count, std::memory_order_release);
+            return count;
+        }
+        
+        std::size_t availableToRead() const
+        { return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire); }
+        
+        std::size_t availableToWrite() const
+        { return this->bufferCapacity - this->availableToRead(); }
+        
+        std::size_t capacity() const
+        { return this->bufferCapacity; }
+        
+        // Keeps the buffer in RAM until destroyed, throwing std::system_error if the system refuses
+        void lockInMemory()
+        {
+            if (!this->locked && mlock(this->buffer, this->bufferCapacity * sizeof(T)))
+                throw std::system_error(errno, std::generic_category(), "RingBuffer error: Unable to lock buffer in memory");
+            this->locked = true;
+        }
+        
+        // Items ever written and read, positions on the stream the buffer carries
+        std::size_t totalWritten() const
+        { return this->head.load(std::memory_order_acquire); }
+        
+        std::size_t totalRead() const
+        { return this->tail.load(std::memory_order_acquire); }
+        
+        private:
+        void copyIn(std::size_t position, const T* data, std::size_t count)
+        {
+            auto index = position & this->mask;
+            auto firstPart = std::min(count, this->bufferCapacity - index);
+            std::memcpy(this->buffer + index, data, firstPart * sizeof(T));
+            std::memcpy(this->buffer, data + firstPart, (count - firstPart) * sizeof(T));
+        }
+        
+        void copyOut(std::size_t position, T* data, std::size_t count)
+        {
+            auto index = position & this->mask;
+            auto firstPart = std::min(count, this->bufferCapacity - index);
+            std::memcpy(data, this->buffer + index, firstPart * sizeof(T));
+            std::memcpy(data + firstPart, this->buffer, (count - firstPart) * sizeof(T));
+        }
+        
+        static std::size_t getNextPowerOf2(std::size_t num)
+        {
+            std::size_t base2 = 1;
+            while (base2 < num)
+                base2 <<= 1;
+            return base2;
+        }
+    };
+}
+
+#endif //DICTA_RINGBUFFER_H
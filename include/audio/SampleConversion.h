@@ -0,0 +1,60 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_SAMPLECONVERSION_H
+#define DICTA_SAMPLECONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Dicta
+{
+    // Little endian PCM sample layouts, both for files and for capture devices
+    enum class SampleFormat
+    {
+        Unsigned8,
+        Signed16,
+        // Three bytes per sample, as in WAV files
+        Signed24,
+        // The low three bytes of a 32 bit word, as capture devices deliver 24 bit audio
+        Signed24In32,
+        Signed32,
+        Float32
+    };
+    
+    std::size_t getBytesPerSample(SampleFormat sampleFormat);
+    
+    const char* getSampleFormatName(SampleFormat sampleFormat);
+    
+    // Converts count samples of one channel, stride bytes apart, to floats in [-1, 1).
+    // Contiguous samples of the common formats take a vectorized path.
+    void convertSamples(SampleFormat sampleFormat,
+                        const std::uint8_t* source,
+                        std::size_t stride,
+                        std::size_t count,
+                        float* destination);
+    
+    // Converts count interleaved frames of channelCount samples, averaging each frame's channels.
+    // Mono and stereo frames of the common formats take a vectorized path.
+    void downmixSamples(SampleFormat sampleFormat,
+                        const std::uint8_t* source,
+                        int channelCount,
+                        std::size_t count,
+                        float* destination);
+    
+    // Averages channelCount channels stored apart from each other, channel c's samples strides[c] bytes
+    // apart from sources[c] on
+    void downmixSamples(SampleFormat sampleFormat,
+                        const std::uint8_t* const* sources,
+                        const std::size_t* strides,
+                        int channelCount,
+                        std::size_t count,
+                        float* destination);
+}
+
+#endif //DICTA_SAMPLECONVERSION_H
@@ -10,11 +10,13 @@
 #define DICTA_SOUNDIOEXCEPTION_H
 
 #include <stdexcept>
+#include <string>
 #include <soundio/soundio.h>
 
 class SoundIoException : public std::runtime_error
 {
-    const std::string messageHeader{"LibSoundIo error:"};
+    // Static, the base class is built before any member would be
+    static constexpr const char* messageHeader = "LibSoundIo error: ";
     
     public:
     SoundIoException(const std::string& message) : std::runtime_error(messageHeader + message)
@@ -23,11 +25,8 @@ class SoundIoException : public std::runtime_error
             messageHeader + message + ", " + soundio_strerror(error))
     {}
     
-    static SoundIoException&& OutOfMemory(const std::string& thing)
-    {
-        SoundIoException e("Unable to allocate memory to " + thing);
-        return std::move(e);
-    }
+    static SoundIoException OutOfMemory(const std::string& thing)
+    { return SoundIoException("Unable to allocate memory to " + thing); }
 };
 
 #endif //DICTA_SOUNDIOEXCEPTION_H
@@ -0,0 +1,114 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FEATURECACHE_H
+#define DICTA_FEATURECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "FeatureFormat.h"
+#include "FeatureReader.h"
+#include "FeatureWriter.h"
+#include "../preprocessor/Framer.h"
+#include "../util/ContentHash.h"
+
+namespace Dicta
+{
+    // Everything features depend on besides the audio itself
+    struct FeatureConfiguration
+    {
+        // Bumped whenever the pipeline's output changes for the same configuration, leaving old entries behind
+        static constexpr std::uint32_t pipelineVersion = 1;
+        
+        std::size_t sampleRate;
+        std::size_t frameLength;
+        std::size_t hopLength;
+        std::size_t fftSize;
+        std::size_t filterBankCount;
+        WindowType windowType;
+        std::size_t deltaWidth;
+        FeatureEncoding encoding;
+        
+        // e.g. "dicta-features v1 rate=16000 frame=256 hop=128 fft=256 filters=26 window=hann deltas=0 encoding=f32"
+        std::string describe() const;
+        
+        std::uint64_t hash() const
+        { return contentHash(this->describe()); }
+    };
+    
+    // Content addressed store of binary feature streams. An entry holds the features of some audio, named
+    // after the hash of its bytes, under some configuration, named after the hash of its description:
+    //
+    //   directory/<configuration hash>/configuration                 the configuration's description
+    //   directory/<configuration hash>/<ab>/<audio hash>.features     ab being the audio hash's first 2 digits
+    //
+    // Entries are written to a temporary file and renamed into place, so readers and concurrent writers
+    // only ever see whole ones, and are read by memory mapping them with FeatureReader.
+    class FeatureCache
+    {
+        private:
+        std::string directory;
+        
+        // Creates the entry's directories and configuration file, returning a temporary path beside the entry
+        std::string prepare(const std::string& path, const FeatureConfiguration& configuration) const;
+        
+        public:
+        // Empty directory means $DICTA_CACHE_DIR, then $XDG_CACHE_HOME/dicta/features, then ~/.cache/dicta/features
+        explicit FeatureCache(const std::string& directory = "");
+        
+        auto& getDirectory() const
+        { return this->directory; }
+        
+        std::string entryPath(std::uint64_t audioHash, const FeatureConfiguration& configuration) const;
+        
+        bool contains(std::uint64_t audioHash, const FeatureConfiguration& configuration) const;
+        
+        // Maps an entry, null when there's none
+        std::unique_ptr<FeatureReader> open(std::uint64_t audioHash, const FeatureConfiguration& configuration) const;
+        
+        // Creates an entry, replacing any already there, from the frames writeFeatures(FeatureWriter&) writes.
+        // Returns its path.
+        template <class WriteFeatures>
+        std::string store(std::uint64_t audioHash,
+                          const FeatureConfiguration& configuration,
+                          const FeatureHeader& header,
+                          WriteFeatures&& writeFeatures) const;
+    };
+    
+    template <class WriteFeatures>
+    std::string FeatureCache::store(std::uint64_t audioHash,
+                                    const FeatureConfiguration& configuration,
+                                    const FeatureHeader& header,
+                                    WriteFeatures&& writeFeatures) const
+    {
+        auto path = this->entryPath(audioHash, configuration);
+        auto temporaryPath = this->prepare(path, configuration);
+        
+        try {
+            {
+                FeatureWriter writer(temporaryPath, header);
+                writeFeatures(writer);
+                writer.flush();
+            }
+            if (std::rename(temporaryPath.c_str(), path.c_str()))
+                throw std::runtime_error("FeatureCache error: Couldn't store " + path);
+        }
+        catch (...) {
+            std::remove(temporaryPath.c_str());
+            throw;
+        }
+        
+        return path;
+    }
+}
+
+#endif //DICTA_FEATURECACHE_H
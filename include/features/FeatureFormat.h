@@ -0,0 +1,129 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FEATUREFORMAT_H
+#define DICTA_FEATUREFORMAT_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Binary feature stream layout, all fields little endian:
+//
+//   FeatureHeader, headerSize bytes
+//   records, recordSize bytes each: RecordPrefix then coefficientCount coefficients, zero padded to 8 bytes
+//
+// Records have a fixed stride, so record i starts at headerSize + i * recordSize and a file being
+// appended to can be read up to its last whole record.
+//
+// Int8 streams are split in segments, an utterance or up to the writer's buffered records each, and every
+// segment starts with scaleRecordCount() scale records, marked scaleRecordMarker, holding for the records up
+// to the next ones. The first scale record's coefficients are one int8 scale exponent per coefficient, the
+// following ones carry one float32 offset per coefficient, packed back to back across their coefficients.
+namespace Dicta
+{
+    // How coefficients are stored on each record
+    enum class FeatureEncoding : std::uint32_t
+    {
+        Float32 = 0,
+        // IEEE half precision, about 3 significant digits up to +-65504
+        Float16 = 1,
+        // Coefficient k of a segment is q * 2^(s_k / 8) + o_k, q in [-127, 127], s_k its scale exponent and
+        // o_k its offset, the middle of the segment's range, so q spans the range rather than the magnitude
+        Int8 = 2
+    };
+    
+    struct FeatureHeader
+    {
+        static constexpr char expectedMagic[8] = {'D', 'I', 'C', 'T', 'A', 'F', 'T', 'S'};
+        static constexpr std::uint32_t currentVersion = 1;
+        
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint32_t sampleRate;
+        std::uint32_t frameLength;
+        std::uint32_t hopLength;
+        std::uint32_t coefficientCount;
+        FeatureEncoding encoding;
+        std::uint32_t recordSize;
+        std::uint8_t reserved[24];
+        
+        static FeatureHeader make(std::uint32_t sampleRate,
+                                  std::uint32_t frameLength,
+                                  std::uint32_t hopLength,
+                                  std::uint32_t coefficientCount,
+                                  FeatureEncoding encoding = FeatureEncoding::Float32);
+        
+        // Throws if the header isn't one this build can read
+        void validate() const;
+    };
+    
+    static_assert(sizeof(FeatureHeader) == 64, "FeatureHeader must keep its on disk size");
+    
+    struct RecordPrefix
+    {
+        std::uint64_t sequence;
+        // Nanoseconds from the start of the stream to the frame's first sample
+        std::int64_t timestamp;
+        // A FrameMarker, records with a marker carry zeroed coefficients
+        std::uint32_t marker;
+        std::uint32_t reserved;
+    };
+    
+    static_assert(sizeof(RecordPrefix) == 24, "RecordPrefix must keep its on disk size");
+    
+    // Marks the scale records of Int8 streams, never a FrameMarker
+    constexpr std::uint32_t scaleRecordMarker = 0xffffffff;
+    
+    std::size_t bytesPerCoefficient(FeatureEncoding encoding);
+    
+    // Smallest Int8 scale exponent whose scale takes magnitudes up to maximumMagnitude to [-127, 127],
+    // half the range of a coefficient around its offset
+    std::int8_t scaleExponent(float maximumMagnitude);
+    
+    inline float scaleOf(std::int8_t exponent)
+    { return std::exp2(exponent / 8.0f); }
+    
+    // Stores count coefficients as encoding at output. For Int8, offsets and inverseScales are each
+    // coefficient's offset and 1 / scale.
+    void encodeCoefficients(FeatureEncoding encoding,
+                            const float* coefficients,
+                            std::size_t count,
+                            const float* offsets,
+                            const float* inverseScales,
+                            void* output);
+    
+    // Reads count coefficients stored as encoding at input. For Int8, scales and offsets are each
+    // coefficient's scale and offset.
+    void decodeCoefficients(FeatureEncoding encoding,
+                            const void* input,
+                            std::size_t count,
+                            const float* scales,
+                            const float* offsets,
+                            float* output);
+    
+    // Prefix plus coefficients, rounded up to keep every record 8 byte aligned
+    inline std::size_t recordSize(std::size_t coefficientCount, FeatureEncoding encoding)
+    { return (sizeof(RecordPrefix) + coefficientCount * bytesPerCoefficient(encoding) + 7) / 8 * 8; }
+    
+    // Records at the start of every Int8 segment: the exponents, then as many as the offsets take
+    inline std::size_t scaleRecordCount(std::size_t coefficientCount)
+    {
+        auto payloadSize = recordSize(coefficientCount, FeatureEncoding::Int8) - sizeof(RecordPrefix);
+        return 1 + (coefficientCount * sizeof(float) + payloadSize - 1) / payloadSize;
+    }
+    
+    // Writes the scaleRecordCount() scale records of a segment at output, zeroing their padding
+    void encodeScaleRecords(const std::int8_t* exponents, const float* offsets, std::size_t coefficientCount, void* output);
+    
+    // Reads the scale records at input back into each coefficient's scale and offset
+    void decodeScaleRecords(const void* input, std::size_t coefficientCount, float* scales, float* offsets);
+}
+
+#endif //DICTA_FEATUREFORMAT_H
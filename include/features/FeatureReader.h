@@ -0,0 +1,116 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FEATUREREADER_H
+#define DICTA_FEATUREREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FeatureFormat.h"
+#include "../preprocessor/Frame.hpp"
+
+namespace Dicta
+{
+    // One record of a mapped feature stream, its coefficients pointing straight into the mapping,
+    // still in the stream's encoding
+    struct FeatureRecord
+    {
+        std::uint64_t sequence;
+        std::int64_t timestamp;
+        FrameMarker marker;
+        FeatureEncoding encoding;
+        const void* payload;
+        std::size_t coefficientCount;
+        // Int8 only, the record's segment scale and offset of each coefficient
+        const float* scales;
+        const float* offsets;
+        
+        std::size_t size() const
+        { return this->coefficientCount; }
+        
+        // Decodes a single coefficient, decode() is the way to go for the whole record
+        float operator[](std::size_t index) const
+        {
+            float value;
+            decodeCoefficients(this->encoding,
+                               static_cast<const std::uint8_t*>(this->payload) + index * bytesPerCoefficient(this->encoding),
+                               1,
+                               this->scales ? this->scales + index : nullptr,
+                               this->offsets ? this->offsets + index : nullptr,
+                               &value);
+            return value;
+        }
+        
+        // Writes the coefficientCount coefficients as floats to output
+        void decode(float* output) const
+        { decodeCoefficients(this->encoding, this->payload, this->coefficientCount, this->scales, this->offsets, output); }
+        
+        bool isMarker() const
+        { return this->marker != FrameMarker::None; }
+    };
+    
+    // Memory maps a binary feature stream and hands out its records without copying them. Only the
+    // whole records present when the file was opened are visible. Int8 scale records are hidden,
+    // records being numbered as the frames written.
+    class FeatureReader
+    {
+        private:
+        // Records from firstRecord on are stored from firstStored on, scaled by scales[scaleOffset...] and
+        // offset by the coefficientCount floats after them
+        struct Segment
+        {
+            std::size_t firstRecord;
+            std::size_t firstStored;
+            std::size_t scaleOffset;
+        };
+        
+        static constexpr std::size_t noScales = static_cast<std::size_t>(-1);
+        
+        std::string fileName;
+        const std::uint8_t* mappedFile = nullptr;
+        std::size_t mappedSize = 0;
+        FeatureHeader header;
+        std::size_t recordCount = 0;
+        std::vector<Segment> segments;
+        std::vector<float> scales;
+        
+        const std::uint8_t* storedRecord(std::size_t index) const
+        { return this->mappedFile + this->header.headerSize + index * this->header.recordSize; }
+        
+        // Walks an Int8 stream's prefixes once, finding its segments and decoding their scales and offsets
+        void indexSegments(std::size_t storedCount);
+        
+        public:
+        explicit FeatureReader(const std::string& fileName);
+        ~FeatureReader() noexcept;
+        
+        // Deleted copy and move constructors and operators
+        FeatureReader(const FeatureReader&) = delete;
+        FeatureReader& operator=(const FeatureReader&) = delete;
+        FeatureReader(FeatureReader&&) = delete;
+        FeatureReader& operator=(FeatureReader&&) = delete;
+        
+        const FeatureHeader& getHeader() const
+        { return this->header; }
+        
+        std::size_t size() const
+        { return this->recordCount; }
+        
+        FeatureRecord operator[](std::size_t index) const;
+        
+        FeatureRecord at(std::size_t index) const;
+        
+        // Decodes count records from first on to output, coefficientCount floats each and zeros for markers.
+        // Returns how many records were decoded, fewer than count past the end of the stream.
+        std::size_t decode(std::size_t first, std::size_t count, float* output) const;
+    };
+}
+
+#endif //DICTA_FEATUREREADER_H
@@ -0,0 +1,91 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FEATUREWRITER_H
+#define DICTA_FEATUREWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+#include "FeatureFormat.h"
+#include "../preprocessor/Frame.hpp"
+
+namespace Dicta
+{
+    // Writes frames as a binary feature stream. Frames are kept, not copied, until bufferedRecords of them
+    // are pending, then their record prefixes and coefficients go out straight from memory with writev
+    // and the frames return to their pools. Compact encodings are encoded into one buffer instead, and
+    // Int8 streams also flush at utterance boundaries, so every utterance gets scales of its own.
+    class FeatureWriter
+    {
+        private:
+        int fileDescriptor;
+        bool ownsDescriptor;
+        FeatureHeader header;
+        std::size_t bufferedRecords;
+        std::size_t payloadSize;
+        
+        std::vector<Frame<float>> pendingFrames;
+        std::vector<RecordPrefix> pendingPrefixes;
+        std::vector<iovec> iovecs;
+        // Coefficients of marker records and padding
+        std::vector<char> zeros;
+        // Pending records, scale records first for Int8, when not written as Float32
+        std::vector<std::uint8_t> encodedRecords;
+        std::size_t scaleRecords = 0;
+        // Int8 segment range of each coefficient, and the exponents, offsets and inverse scales it makes
+        std::vector<float> minima;
+        std::vector<float> maxima;
+        std::vector<std::int8_t> exponents;
+        std::vector<float> offsets;
+        std::vector<float> inverseScales;
+        std::uint64_t recordsWritten = 0;
+        
+        FeatureWriter(int fileDescriptor, bool ownsDescriptor, const FeatureHeader& header, std::size_t bufferedRecords);
+        
+        void writeFrames();
+        
+        void writeEncodedFrames();
+        
+        // Int8 only, writes the segment's scale records at output and sets offsets and inverseScales to match
+        void encodeScales(std::uint8_t* output);
+        
+        void writeAll(iovec* vectors, std::size_t count);
+        
+        public:
+        // Creates or truncates fileName and writes the header
+        FeatureWriter(const std::string& fileName, const FeatureHeader& header, std::size_t bufferedRecords = 256);
+        
+        // Writes to an already open descriptor, like standard output, which is left open
+        FeatureWriter(int fileDescriptor, const FeatureHeader& header, std::size_t bufferedRecords = 256);
+        
+        // Flushes what's pending, errors at this point are lost, call flush() to see them
+        ~FeatureWriter();
+        
+        // Deleted copy and move constructors and operators
+        FeatureWriter(const FeatureWriter&) = delete;
+        FeatureWriter& operator=(const FeatureWriter&) = delete;
+        FeatureWriter(FeatureWriter&&) = delete;
+        FeatureWriter& operator=(FeatureWriter&&) = delete;
+        
+        const FeatureHeader& getHeader() const
+        { return this->header; }
+        
+        auto getRecordsWritten() const
+        { return this->recordsWritten; }
+        
+        // Queues a frame of the header's coefficient count, or a marker frame
+        void write(Frame<float> frame);
+        
+        void flush();
+    };
+}
+
+#endif //DICTA_FEATUREWRITER_H
@@ -0,0 +1,63 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_DCTMATRIX_H
+#define DICTA_DCTMATRIX_H
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "../util/SIMD.hpp"
+
+namespace Dicta
+{
+    // DCT-II of a short input as a precomputed matrix, computing only the first outputCount coefficients.
+    // For the few filter bank energies of a frame it beats running a whole FFTW plan and dropping half of it.
+    // Scaled like FFTW's REDFT10: output[k] = 2 * sum(input[n] * cos(pi * k * (2n + 1) / (2 * inputSize)))
+    template <class T>
+    class DCTMatrix
+    {
+        private:
+        std::size_t inputSize;
+        std::size_t outputCount;
+        // Row k holds the inputSize cosines of coefficient k, rows stored contiguously
+        std::vector<T> basis;
+        
+        public:
+        DCTMatrix(std::size_t inputSize, std::size_t outputCount) :
+                inputSize(inputSize),
+                outputCount(outputCount),
+                basis(inputSize * outputCount)
+        {
+            if (outputCount > inputSize)
+                throw std::invalid_argument("DCT error: More coefficients than inputs asked for");
+            
+            const double pi = std::atan(1) * 4;
+            for (std::size_t coefficient = 0; coefficient != outputCount; ++coefficient)
+                for (std::size_t input = 0; input != inputSize; ++input)
+                    this->basis[coefficient * inputSize + input] =
+                            static_cast<T>(2 * std::cos(pi * coefficient * (2 * input + 1) / (2.0 * inputSize)));
+        }
+        
+        auto getInputSize() const
+        { return this->inputSize; }
+        
+        auto getOutputCount() const
+        { return this->outputCount; }
+        
+        // Reads inputSize values and writes outputCount coefficients. Const and allocation free, safe to share.
+        void compute(const T* input, T* output) const
+        {
+            for (std::size_t coefficient = 0; coefficient != this->outputCount; ++coefficient)
+                output[coefficient] = SIMD::dot(this->basis.data() + coefficient * this->inputSize, input, this->inputSize);
+        }
+    };
+}
+
+#endif //DICTA_DCTMATRIX_H
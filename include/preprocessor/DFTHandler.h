@@ -11,48 +11,192 @@
 
 #include <cstddef>
 #include <cmath>
+#include <memory>
+#include <type_traits>
 #include <fftw3.h>
 #include "Frame.hpp"
+#include "FFTWisdom.h"
 
 namespace Dicta
 {
+    // FFTW's API for each precision, so DFTHandler can be written once
+    template <class T>
+    struct FFTW;
+    
+    template <>
+    struct FFTW<float>
+    {
+        using Complex = fftwf_complex;
+        using Plan = fftwf_plan;
+        
+        static float* allocReal(std::size_t size)
+        { return fftwf_alloc_real(size); }
+        
+        static Complex* allocComplex(std::size_t size)
+        { return fftwf_alloc_complex(size); }
+        
+        static void free(void* buffer)
+        { fftwf_free(buffer); }
+        
+        static void destroy(Plan plan)
+        { fftwf_destroy_plan(plan); }
+        
+        static void execute(Plan plan)
+        { fftwf_execute(plan); }
+        
+        static Plan planFFT(int size, float* input, Complex* output, unsigned flags)
+        { return fftwf_plan_dft_r2c_1d(size, input, output, flags); }
+        
+        static Plan planDCT(int size, float* input, float* output, unsigned flags)
+        { return fftwf_plan_r2r_1d(size, input, output, FFTW_REDFT10, flags); }
+        
+        static Plan planFFTMany(int size, int howMany, float* input, Complex* output, int outputSize, unsigned flags)
+        { return fftwf_plan_many_dft_r2c(1, &size, howMany, input, NULL, 1, size, output, NULL, 1, outputSize, flags); }
+        
+        static Plan planDCTMany(int size, int howMany, float* input, float* output, unsigned flags)
+        {
+            fftw_r2r_kind kind = FFTW_REDFT10;
+            return fftwf_plan_many_r2r(1, &size, howMany, input, NULL, 1, size, output, NULL, 1, size, &kind, flags);
+        }
+    };
+    
+    template <>
+    struct FFTW<double>
+    {
+        using Complex = fftw_complex;
+        using Plan = fftw_plan;
+        
+        static double* allocReal(std::size_t size)
+        { return fftw_alloc_real(size); }
+        
+        static Complex* allocComplex(std::size_t size)
+        { return fftw_alloc_complex(size); }
+        
+        static void free(void* buffer)
+        { fftw_free(buffer); }
+        
+        static void destroy(Plan plan)
+        { fftw_destroy_plan(plan); }
+        
+        static void execute(Plan plan)
+        { fftw_execute(plan); }
+        
+        static Plan planFFT(int size, double* input, Complex* output, unsigned flags)
+        { return fftw_plan_dft_r2c_1d(size, input, output, flags); }
+        
+        static Plan planDCT(int size, double* input, double* output, unsigned flags)
+        { return fftw_plan_r2r_1d(size, input, output, FFTW_REDFT10, flags); }
+        
+        static Plan planFFTMany(int size, int howMany, double* input, Complex* output, int outputSize, unsigned flags)
+        { return fftw_plan_many_dft_r2c(1, &size, howMany, input, NULL, 1, size, output, NULL, 1, outputSize, flags); }
+        
+        static Plan planDCTMany(int size, int howMany, double* input, double* output, unsigned flags)
+        {
+            fftw_r2r_kind kind = FFTW_REDFT10;
+            return fftw_plan_many_r2r(1, &size, howMany, input, NULL, 1, size, output, NULL, 1, size, &kind, flags);
+        }
+    };
+    
+    // Owners for FFTW's buffers and plans, released with the functions of their precision
+    template <class T>
+    struct FFTWBufferDeleter
+    {
+        void operator()(void* buffer) const
+        { FFTW<T>::free(buffer); }
+    };
+    
+    template <class T>
+    struct FFTWPlanDeleter
+    {
+        void operator()(typename FFTW<T>::Plan plan) const
+        { FFTW<T>::destroy(plan); }
+    };
+    
+    template <class T, class Element = T>
+    using FFTWBuffer = std::unique_ptr<Element[], FFTWBufferDeleter<T>>;
+    
+    template <class T>
+    using FFTWPlan = std::unique_ptr<std::remove_pointer_t<typename FFTW<T>::Plan>, FFTWPlanDeleter<T>>;
+    
+    // Magnitude spectrum FFT and DCT-II over frames of a single precision, float or double
+    template <class T>
     class DFTHandler
     {
+        public:
+        using Complex = typename FFTW<T>::Complex;
+        
         private:
         std::size_t fftSize;
         std::size_t dctSize;
         std::size_t outputSize;
+        std::size_t batchSize;
+        
+        FFTWBuffer<T> fftInput;
+        FFTWBuffer<T, Complex> fftOutput;
+        FFTWBuffer<T> dctInput;
+        FFTWBuffer<T> dctOutput;
+        FFTWPlan<T> fftPlan;
+        FFTWPlan<T> dctPlan;
+        std::shared_ptr<FramePool<T>> spectrumPool;
+        std::shared_ptr<FramePool<T>> coefficientsPool;
         
-        // Float version
-        float* fftFloatInput;
-        fftwf_complex* fftFloatOutput;
-        float* dctFloatInput;
-        float* dctFloatOutput;
-        fftwf_plan fftFloatPlan;
-        fftwf_plan dctFloatPlan;
-        
-        // Double version
-        double* fftDoubleInput;
-        fftw_complex* fftDoubleOutput;
-        double* dctDoubleInput;
-        double* dctDoubleOutput;
-        fftw_plan fftDoublePlan;
-        fftw_plan dctDoublePlan;
-        
-        const std::string wisdomFloatFileName = "./fftWisdomFloatFile.data";
-        const std::string wisdomDoubleFileName = "./fftWisdomDoubleFile.data";
+        // Batch version, batchSize frames laid out contiguously
+        FFTWBuffer<T> fftBatchInput;
+        FFTWBuffer<T, Complex> fftBatchOutput;
+        FFTWBuffer<T> dctBatchInput;
+        FFTWBuffer<T> dctBatchOutput;
+        FFTWPlan<T> fftBatchPlan;
+        FFTWPlan<T> dctBatchPlan;
+        
+        void magnitudeSpectrum(const Complex* spectrum, T* output) const;
+        Frame<T> magnitudeSpectrum(const Complex* spectrum, FramePool<T>& pool) const;
+        
+        void firstHalf(const T* coefficients, T* output) const;
+        Frame<T> firstHalf(const T* coefficients, FramePool<T>& pool) const;
         
         public:
-        DFTHandler(std::size_t fftSize, std::size_t dctSize, float);
-        DFTHandler(std::size_t fftSize, std::size_t dctSize, double);
-        ~DFTHandler();
+        // A batchSize bigger than 1 also plans FFTW "many" transforms for the batch methods.
+        // Plans come from the wisdom cache when possible, otherwise they're made with the chosen effort and cached.
+        DFTHandler(std::size_t fftSize, std::size_t dctSize, std::size_t batchSize = 1, const PlannerOptions& plannerOptions = {});
+        
+        auto getBatchSize() const
+        { return this->batchSize; }
+        
+        auto getOutputSize() const
+        { return this->outputSize; }
+        
+        // Single frame version, for the live low latency case.
+        // Frames can be written in place on the FFT input buffer to avoid copying them.
+        T* getFFTInput()
+        { return this->fftInput.get(); }
+        
+        Frame<T> processFFT(const Frame<T>& input);
+        Frame<T> processFFT(const T* input);
+        Frame<T> processDCT(const Frame<T>& input);
+        
+        // FFT leaving the fftSize / 2 + 1 complex bins on the output buffer, for kernels that read them in place.
+        // Valid until the next transform.
+        const Complex* executeFFT(const T* input);
+        
+        // Batch version, frameCount frames of fftSize (or dctSize) samples laid out contiguously, writing
+        // fftSize / 2 + 1 magnitudes (or dctSize / 2 coefficients) per frame, also contiguously, to the output.
+        // Frames can be written in place on the batch input buffers to avoid copying them.
+        T* getFFTBatchInput()
+        { return this->fftBatchInput.get(); }
+        
+        T* getDCTBatchInput()
+        { return this->dctBatchInput.get(); }
         
-        Frame<float> processFFT(const Frame<float>& input);
-        Frame<float> processDCT(const Frame<float>& input);
+        void processFFTBatch(const T* frames, std::size_t frameCount, T* spectra);
         
-        Frame<double> processFFT(const Frame<double>& input);
-        Frame<double> processDCT(const Frame<double>& input);
+        // In place version over the frames already windowed on the batch input buffer, frame f's complex
+        // spectrum starting at f * getOutputSize(). Needs batch plans, a batchSize bigger than 1.
+        const Complex* executeFFTBatch();
+        void processDCTBatch(const T* frames, std::size_t frameCount, T* coefficients);
     };
+    
+    extern template class DFTHandler<float>;
+    extern template class DFTHandler<double>;
 }
 
 #endif //DICTA_DFTHANDLER_H
@@ -0,0 +1,111 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_DELTAFILTER_H
+#define DICTA_DELTAFILTER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Frame.hpp"
+
+namespace Dicta
+{
+    // Appends delta and delta-delta coefficients to cepstral frames as they stream by. Deltas are the
+    // regression d[t] = sum n * (c[t + n] - c[t - n]) / (2 * sum n^2) for n up to width, delta-deltas
+    // the same regression over deltas, with the first and last frames of a segment repeated past its
+    // edges. Only the last 2 * width + 1 frames of each are kept, in rings, and every frame comes out
+    // 2 * width frames late as one pooled frame of static, delta and delta-delta coefficients.
+    class DeltaFilter
+    {
+        private:
+        std::size_t coefficientCount;
+        std::size_t width;
+        std::size_t ringSize;
+        float normalization;
+        
+        std::vector<float> statics;
+        std::vector<float> deltas;
+        std::vector<std::int64_t> timestamps;
+        std::vector<std::int64_t> captureTimes;
+        std::shared_ptr<FramePool<float>> outputPool;
+        // Frames pushed since the segment started
+        std::int64_t pushedFrames = 0;
+        
+        float* staticAt(std::int64_t index)
+        { return this->statics.data() + index % this->ringSize * this->coefficientCount; }
+        
+        float* deltaAt(std::int64_t index)
+        { return this->deltas.data() + index % this->ringSize * this->coefficientCount; }
+        
+        // Regression at index over frames up to last, straight into output
+        void regression(float* (DeltaFilter::*frameAt)(std::int64_t),
+                        std::int64_t index,
+                        std::int64_t last,
+                        float* output);
+        
+        // Frame index of the segment once frames up to last arrived
+        Frame<float> makeFrame(std::int64_t index, std::int64_t last);
+        
+        public:
+        DeltaFilter(std::size_t coefficientCount, std::size_t width);
+        
+        auto getWidth() const
+        { return this->width; }
+        
+        // Static, delta and delta-delta coefficients
+        std::size_t getOutputSize() const
+        { return 3 * this->coefficientCount; }
+        
+        // Frames a frame waits for the ones after it
+        std::size_t getLatency() const
+        { return 2 * this->width; }
+        
+        // Takes the next frame of the segment, outputting the one 2 * width frames older if there's one
+        template <class Output>
+        void push(const Frame<float>& frame, Output&& output);
+        
+        // Outputs every frame still waiting, as the segment ends, then starts a new segment
+        template <class Output>
+        void finish(Output&& output);
+    };
+    
+    template <class Output>
+    void DeltaFilter::push(const Frame<float>& frame, Output&& output)
+    {
+        auto index = this->pushedFrames++;
+        std::copy_n(frame.data(), this->coefficientCount, this->staticAt(index));
+        this->timestamps[index % this->ringSize] = frame.getTimestamp();
+        this->captureTimes[index % this->ringSize] = frame.getCaptureTime();
+        
+        auto width = static_cast<std::int64_t>(this->width);
+        if (index >= width)
+            this->regression(&DeltaFilter::staticAt, index - width, index, this->deltaAt(index - width));
+        if (index >= 2 * width)
+            output(this->makeFrame(index - 2 * width, index - width));
+    }
+    
+    template <class Output>
+    void DeltaFilter::finish(Output&& output)
+    {
+        // As if the last frame kept coming, its deltas computed as those frames would have
+        auto last = this->pushedFrames - 1;
+        auto width = static_cast<std::int64_t>(this->width);
+        for (auto index = last + 1; index <= last + 2 * width; ++index) {
+            if (index - width >= 0 && index - width <= last)
+                this->regression(&DeltaFilter::staticAt, index - width, last, this->deltaAt(index - width));
+            if (index - 2 * width >= 0)
+                output(this->makeFrame(index - 2 * width, std::min(index - width, last)));
+        }
+        this->pushedFrames = 0;
+    }
+}
+
+#endif //DICTA_DELTAFILTER_H
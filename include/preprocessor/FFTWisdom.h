@@ -0,0 +1,75 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FFTWISDOM_H
+#define DICTA_FFTWISDOM_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace Dicta
+{
+    // How hard FFTW searches for the fastest plan, from ESTIMATE (instant, slower transforms) to EXHAUSTIVE
+    enum class PlannerEffort
+    {
+        Estimate,
+        Measure,
+        Patient,
+        Exhaustive
+    };
+    
+    struct PlannerOptions
+    {
+        PlannerEffort effort = PlannerEffort::Patient;
+        // Caps planning time in seconds, FFTW settles for the best plan found so far. Negative means no limit
+        double timeLimit = -1;
+        // Where wisdom is cached, empty means $DICTA_WISDOM_DIR, then $XDG_CACHE_HOME/dicta, then ~/.cache/dicta
+        std::string wisdomDirectory;
+    };
+    
+    // One cached wisdom file per precision, transform sizes, planner effort and CPU features, since wisdom
+    // from a different machine or configuration is useless at best. Files are replaced atomically,
+    // so concurrent processes never read a half written cache.
+    class FFTWisdom
+    {
+        private:
+        PlannerOptions options;
+        bool doublePrecision;
+        std::string path;
+        
+        FFTWisdom(const PlannerOptions& options, std::size_t fftSize, std::size_t dctSize, std::size_t batchSize, bool doublePrecision);
+        
+        static std::string resolveDirectory(const std::string& directory);
+        static std::string effortName(PlannerEffort effort);
+        
+        public:
+        FFTWisdom(const PlannerOptions& options, std::size_t fftSize, std::size_t dctSize, std::size_t batchSize, float);
+        FFTWisdom(const PlannerOptions& options, std::size_t fftSize, std::size_t dctSize, std::size_t batchSize, double);
+        
+        auto getPath() const
+        { return this->path; }
+        
+        // FFTW planner flags for the chosen effort, also applies the time limit
+        unsigned planFlags() const;
+        
+        // Imports the cached wisdom, returns false if there's none for this configuration yet
+        bool load() const;
+        
+        // Exports everything FFTW knows for this precision, returns false if the cache couldn't be written
+        bool save() const;
+        
+        // FFTW's planner isn't thread safe, every planning must hold this lock
+        static std::mutex& plannerMutex();
+        
+        // Short tag of the SIMD extensions the running CPU supports, e.g. "avx2-fma"
+        static std::string cpuFeatures();
+    };
+}
+
+#endif //DICTA_FFTWISDOM_H
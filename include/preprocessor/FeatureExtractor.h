@@ -0,0 +1,167 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FEATUREEXTRACTOR_H
+#define DICTA_FEATUREEXTRACTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "DCTMatrix.hpp"
+#include "DeltaFilter.h"
+#include "DFTHandler.h"
+#include "Frame.hpp"
+#include "MFCC.hpp"
+#include "PreProcessor.h"
+
+namespace Dicta
+{
+    // Push based front end for embedding: the caller hands in spans of mono samples as they arrive and
+    // gets their frames' coefficients back before process() returns, on its own thread. Frames lying
+    // within a span are windowed straight from the caller's memory, only the few samples of a frame
+    // straddling two spans are carried over. Frames come out as PreProcessor's would for the same audio.
+    class FeatureExtractor
+    {
+        private:
+        static constexpr std::size_t filterBankCount = RuntimeConfig::filterBankCount;
+        static constexpr std::size_t coefficientCount = filterBankCount / 2;
+        
+        std::size_t sampleRate;
+        std::size_t frameLength;
+        std::size_t hopLength;
+        std::size_t fftSize;
+        std::shared_ptr<const std::vector<float>> window;
+        DFTHandler<float> dftHandler;
+        MFCC<float, filterBankCount> mfcc;
+        DCTMatrix<float> dct;
+        std::shared_ptr<FramePool<float>> coefficientsPool;
+        std::unique_ptr<DeltaFilter> deltaFilter;
+        
+        // Samples after the last span's frames, the start of the next frame on, and a frame put together from them
+        std::vector<float> carry;
+        std::vector<float> straddling;
+        // Stream positions: samples pushed so far and where the next frame starts
+        std::uint64_t samplesSeen = 0;
+        std::uint64_t nextFrameStart;
+        std::uint64_t framesSeen = 0;
+        std::uint64_t nextSequence = 0;
+        
+        // Frames end on hop boundaries, like Framer's, so the first one starts past zero when the hop doesn't divide it
+        std::uint64_t firstFrameStart() const
+        { return (this->frameLength + this->hopLength - 1) / this->hopLength * this->hopLength - this->frameLength; }
+        
+        // Window, FFT, mel filter banks and DCT of the frame of frameLength samples at frame
+        Frame<float> transform(const float* frame);
+        
+        // Keeps the samples of the span the next frames need, once its whole frames are out
+        void keepTail(const float* samples, std::size_t count);
+        
+        template <class Callback>
+        void output(Frame<float> frame, Callback& callback)
+        {
+            frame.setSequence(this->nextSequence++);
+            callback(std::move(frame));
+        }
+        
+        public:
+        // Frames and hops follow PreProcessor's defaults when FramingOptions leaves them at zero. Non zero
+        // deltaWidth appends delta and delta-delta coefficients, frames then coming out 2 * deltaWidth late.
+        FeatureExtractor(std::size_t sampleRate,
+                         FramingOptions framingOptions = {},
+                         std::size_t deltaWidth = 0,
+                         const PlannerOptions& plannerOptions = {});
+        
+        auto getSampleRate() const
+        { return this->sampleRate; }
+        
+        auto getFrameLength() const
+        { return this->frameLength; }
+        
+        auto getHopLength() const
+        { return this->hopLength; }
+        
+        auto getFFTSize() const
+        { return this->fftSize; }
+        
+        static constexpr std::size_t getFilterBankCount()
+        { return filterBankCount; }
+        
+        // Coefficients of each output frame, static ones followed by deltas and delta-deltas if enabled
+        std::size_t getFrameSize() const
+        { return this->deltaFilter ? this->deltaFilter->getOutputSize() : coefficientCount; }
+        
+        FeatureHeader makeFeatureHeader(FeatureEncoding encoding = FeatureEncoding::Float32) const
+        {
+            return FeatureHeader::make(static_cast<std::uint32_t>(this->sampleRate),
+                                       static_cast<std::uint32_t>(this->frameLength),
+                                       static_cast<std::uint32_t>(this->hopLength),
+                                       static_cast<std::uint32_t>(this->getFrameSize()),
+                                       encoding);
+        }
+        
+        // Featurizes the next count samples of the stream, calling callback(Frame<float>) with every frame
+        // they complete, in order. Frames are pooled and go back to the pool once the callback lets go of them.
+        // Returns how many frames were output.
+        template <class Callback>
+        std::size_t process(const float* samples, std::size_t count, Callback&& callback);
+        
+        // Outputs the frames the delta filter still holds and starts a new stream, a trailing partial frame
+        // being dropped like PreProcessor does
+        template <class Callback>
+        std::size_t finish(Callback&& callback);
+    };
+    
+    template <class Callback>
+    std::size_t FeatureExtractor::process(const float* samples, std::size_t count, Callback&& callback)
+    {
+        auto sequenceBefore = this->nextSequence;
+        auto end = this->samplesSeen + count;
+        
+        for (; this->nextFrameStart + this->frameLength <= end; this->nextFrameStart += this->hopLength) {
+            const float* frame;
+            if (this->nextFrameStart >= this->samplesSeen)
+                frame = samples + (this->nextFrameStart - this->samplesSeen);
+            else {
+                // Starts on the carry and ends on this span
+                auto offset = this->carry.size() - (this->samplesSeen - this->nextFrameStart);
+                auto fromCarry = this->carry.size() - offset;
+                std::copy(this->carry.begin() + offset, this->carry.end(), this->straddling.begin());
+                std::copy_n(samples, this->frameLength - fromCarry, this->straddling.begin() + fromCarry);
+                frame = this->straddling.data();
+            }
+            
+            auto coefficients = this->transform(frame);
+            if (this->deltaFilter)
+                this->deltaFilter->push(coefficients, [&](Frame<float> frame) { this->output(std::move(frame), callback); });
+            else
+                this->output(std::move(coefficients), callback);
+        }
+        
+        this->keepTail(samples, count);
+        return this->nextSequence - sequenceBefore;
+    }
+    
+    template <class Callback>
+    std::size_t FeatureExtractor::finish(Callback&& callback)
+    {
+        auto sequenceBefore = this->nextSequence;
+        if (this->deltaFilter)
+            this->deltaFilter->finish([&](Frame<float> frame) { this->output(std::move(frame), callback); });
+        auto outputCount = this->nextSequence - sequenceBefore;
+        
+        this->carry.clear();
+        this->samplesSeen = 0;
+        this->nextFrameStart = this->firstFrameStart();
+        this->framesSeen = 0;
+        this->nextSequence = 0;
+        return outputCount;
+    }
+}
+
+#endif //DICTA_FEATUREEXTRACTOR_H
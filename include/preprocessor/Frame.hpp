@@ -9,37 +9,123 @@
 #ifndef DICTA_FRAME_H
 #define DICTA_FRAME_H
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace Dicta
 {
+    template <class T>
+    class FramePool;
+    
+    // Stream events sent as empty frames in between the processed ones: utterance boundaries found by the
+    // voice activity gate and the end of a stream run by a StreamManager
+    enum class FrameMarker
+    {
+        None,
+        UtteranceStart,
+        UtteranceEnd,
+        StreamEnd
+    };
+    
     template <class T>
     class Frame
     {
+        friend class FramePool<T>;
+        
+        static_assert(std::is_trivial<T>::value, "Frames hold plain samples, left uninitialized until written");
+        
+        public:
+        // Sample buffers start on a cache line, so vectorized kernels can use aligned loads on them
+        static constexpr std::size_t alignment = 64;
+        
         private:
         std::size_t numSamples = 0;
         std::size_t sampleCounter = 0;
         T* samples = nullptr;
+        std::shared_ptr<FramePool<T>> pool;
+        std::uint64_t sequence = 0;
+        std::int64_t timestamp = 0;
+        std::int64_t captureTime = 0;
+        FrameMarker marker = FrameMarker::None;
+        
+        // Every sample buffer ever allocated for a Frame<T>, pooled or not
+        static inline std::atomic<std::size_t> allocationCount{0};
+        
+        Frame(std::shared_ptr<FramePool<T>> pool, T* samples, std::size_t numSamples) :
+                numSamples(numSamples),
+                samples(samples),
+                pool(std::move(pool))
+        {}
+        
+        static T* allocate(std::size_t numSamples)
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<T*>(::operator new[](numSamples * sizeof(T), std::align_val_t{alignment}));
+        }
+        
+        static void deallocate(T* samples)
+        { ::operator delete[](samples, std::align_val_t{alignment}); }
+        
+        void release()
+        {
+            if (this->pool)
+                this->pool->recycle(this->samples);
+            else
+                deallocate(this->samples);
+        }
         
         public:
         Frame() = default;
         
         Frame(std::size_t numSamples) :
                 numSamples(numSamples),
-                samples(new T[numSamples])
+                samples(allocate(numSamples))
         {}
         
+        // Pooled frames give their buffer back to the pool instead of freeing it
         ~Frame()
-        { delete[] this->samples; }
+        { this->release(); }
+        
+        // An empty frame standing for a stream event
+        static Frame makeMarker(FrameMarker marker)
+        {
+            Frame frame;
+            frame.marker = marker;
+            return frame;
+        }
+        
+        static std::size_t getAllocationCount()
+        { return allocationCount.load(std::memory_order_relaxed); }
         
         // Array subscript operators
-        T operator[](std::size_t index)
+        T& operator[](std::size_t index)
         { return this->samples[index]; }
         
-        const T operator[](std::size_t index) const
+        const T& operator[](std::size_t index) const
         { return this->samples[index]; }
         
+        // Raw storage, for kernels that fill the whole frame at once and then commit it
+        T* data()
+        { return this->samples; }
+        
+        const T* data() const
+        { return this->samples; }
+        
+        void commit(std::size_t count)
+        {
+            if (count <= this->numSamples)
+                this->sampleCounter = count;
+            else
+                throw std::out_of_range("Frame error: Cannot commit more samples than the frame holds");
+        }
+        
         // USE ONLY ADD TO FILL THE CONTAINER
         void push(T sample)
         {
@@ -49,12 +135,42 @@ namespace Dicta
                 throw std::out_of_range("Frame error: Cannot push a sample to a full frame");
         }
         
-        std::size_t size()
+        std::size_t size() const
         { return this->sampleCounter; }
         
-        bool empty()
+        std::size_t capacity() const
+        { return this->numSamples; }
+        
+        bool empty() const
         { return this->sampleCounter == 0; }
         
+        // Index of the frame among those output by its stream, also used to keep frames in order when processed in parallel
+        std::uint64_t getSequence() const
+        { return this->sequence; }
+        
+        void setSequence(std::uint64_t sequence)
+        { this->sequence = sequence; }
+        
+        // Nanoseconds from the start of the stream to the frame's first sample
+        std::int64_t getTimestamp() const
+        { return this->timestamp; }
+        
+        void setTimestamp(std::int64_t timestamp)
+        { this->timestamp = timestamp; }
+        
+        // Steady clock nanoseconds at which the device handed over the frame's last sample, zero when unknown
+        std::int64_t getCaptureTime() const
+        { return this->captureTime; }
+        
+        void setCaptureTime(std::int64_t captureTime)
+        { this->captureTime = captureTime; }
+        
+        FrameMarker getMarker() const
+        { return this->marker; }
+        
+        bool isMarker() const
+        { return this->marker != FrameMarker::None; }
+        
         // Deleted copy constructor and operator
         Frame(const Frame& other) = delete;
         Frame& operator=(const Frame& other) = delete;
@@ -63,7 +179,12 @@ namespace Dicta
         Frame(Frame&& other) noexcept :
                 numSamples(other.numSamples),
                 sampleCounter(other.sampleCounter),
-                samples(other.samples)
+                samples(other.samples),
+                pool(std::move(other.pool)),
+                sequence(other.sequence),
+                timestamp(other.timestamp),
+                captureTime(other.captureTime),
+                marker(other.marker)
         {
             other.numSamples = 0;
             other.sampleCounter = 0;
@@ -74,11 +195,16 @@ namespace Dicta
         Frame& operator=(Frame&& other) noexcept
         {
             if (this != &other) {
-                delete[] this->samples;
+                this->release();
                 
                 this->numSamples = other.numSamples;
                 this->sampleCounter = other.sampleCounter;
                 this->samples = other.samples;
+                this->pool = std::move(other.pool);
+                this->sequence = other.sequence;
+                this->timestamp = other.timestamp;
+                this->captureTime = other.captureTime;
+                this->marker = other.marker;
                 
                 other.numSamples = 0;
                 other.sampleCounter = 0;
@@ -87,6 +213,70 @@ namespace Dicta
             return *this;
         }
     };
+    
+    // Recycles sample buffers of a fixed size. Frames acquired from a pool return their buffer to its
+    // free list when destroyed, on whatever thread that happens, so after a warm-up the pipeline stops
+    // hitting the allocator. Frames keep their pool alive, so it can be dropped while frames are in flight.
+    template <class T>
+    class FramePool : public std::enable_shared_from_this<FramePool<T>>
+    {
+        friend class Frame<T>;
+        
+        private:
+        std::size_t frameSize;
+        std::mutex mutex;
+        std::vector<T*> freeBuffers;
+        
+        FramePool(std::size_t frameSize, std::size_t preallocatedFrames) :
+                frameSize(frameSize)
+        {
+            this->freeBuffers.reserve(preallocatedFrames);
+            for (std::size_t frame = 0; frame != preallocatedFrames; ++frame)
+                this->freeBuffers.push_back(Frame<T>::allocate(frameSize));
+        }
+        
+        void recycle(T* buffer)
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->freeBuffers.push_back(buffer);
+        }
+        
+        public:
+        static std::shared_ptr<FramePool> create(std::size_t frameSize, std::size_t preallocatedFrames = 0)
+        { return std::shared_ptr<FramePool>(new FramePool(frameSize, preallocatedFrames)); }
+        
+        ~FramePool()
+        {
+            for (auto buffer : this->freeBuffers)
+                Frame<T>::deallocate(buffer);
+        }
+        
+        // Deleted copy and move constructors and operators
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+        FramePool(FramePool&&) = delete;
+        FramePool& operator=(FramePool&&) = delete;
+        
+        auto getFrameSize() const
+        { return this->frameSize; }
+        
+        // An empty frame able to hold frameSize samples, allocating only when the free list is empty
+        Frame<T> acquire()
+        {
+            T* buffer = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (!this->freeBuffers.empty()) {
+                    buffer = this->freeBuffers.back();
+                    this->freeBuffers.pop_back();
+                }
+            }
+            if (!buffer)
+                buffer = Frame<T>::allocate(this->frameSize);
+            
+            return Frame<T>(this->shared_from_this(), buffer, this->frameSize);
+        }
+    };
 }
 
 #endif //DICTA_FRAME_H
@@ -0,0 +1,101 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FRAMEWORKERPOOL_H
+#define DICTA_FRAMEWORKERPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Frame.hpp"
+#include "../util/ThreadOptions.h"
+
+namespace Dicta
+{
+    // Runs the spectral chain over windowed frames on a pool of worker threads. Every worker owns its
+    // transform, so FFTW buffers are never shared, while read only state like the MFCC filter banks can be.
+    // Results are put back in submission order before reaching the output.
+    class FrameWorkerPool
+    {
+        public:
+        using Output = std::function<void(Frame<float>)>;
+        // Turns a windowed frame into its coefficients, made once per worker by a TransformFactory
+        using Transform = std::function<Frame<float>(const float* windowed)>;
+        using TransformFactory = std::function<Transform()>;
+        
+        private:
+        Output output;
+        std::vector<Transform> transforms;
+        std::shared_ptr<FramePool<float>> inputPool;
+        
+        // Windowed frames waiting for a worker
+        std::mutex jobsMutex;
+        std::condition_variable jobsCondition;
+        std::deque<Frame<float>> jobs;
+        bool stopping = false;
+        
+        // Processed frames waiting for their predecessors, slot = sequence % maxInFlight
+        std::mutex reorderMutex;
+        std::condition_variable reorderCondition;
+        std::size_t maxInFlight;
+        std::vector<Frame<float>> reorderSlots;
+        std::vector<char> slotReady;
+        std::uint64_t nextSequence = 0;
+        std::uint64_t nextToTake = 0;
+        std::uint64_t nextToEmit = 0;
+        // One worker at a time takes the ready run of frames out of the slots and outputs it without the lock,
+        // so a slow consumer holds up neither the other workers nor submit()
+        bool draining = false;
+        std::vector<Frame<float>> emitting;
+        
+        std::vector<std::thread> workers;
+        
+        void work(std::size_t worker, const ThreadOptions& threadOptions, std::promise<void> started);
+        void complete(Frame<float> result);
+        
+        // Lets the workers finish the queued frames and joins them
+        void stop();
+        
+        public:
+        // Windowed frames hold fftSize samples, output is called in sequence order from the worker threads.
+        // Throws if threadOptions can't be applied to the workers.
+        FrameWorkerPool(std::size_t workerCount,
+                        std::size_t fftSize,
+                        const TransformFactory& makeTransform,
+                        Output output,
+                        const ThreadOptions& threadOptions = {});
+        ~FrameWorkerPool();
+        
+        // Deleted copy and move constructors and operators
+        FrameWorkerPool(const FrameWorkerPool&) = delete;
+        FrameWorkerPool& operator=(const FrameWorkerPool&) = delete;
+        FrameWorkerPool(FrameWorkerPool&&) = delete;
+        FrameWorkerPool& operator=(FrameWorkerPool&&) = delete;
+        
+        auto getWorkerCount() const
+        { return this->workers.size(); }
+        
+        // A pooled frame of fftSize samples to window the next frame into
+        Frame<float> acquireInput()
+        { return this->inputPool->acquire(); }
+        
+        // Queues a windowed frame, waiting while too many frames are already in flight
+        void submit(Frame<float> windowed);
+        
+        // Waits until every submitted frame reached the output
+        void flush();
+    };
+}
+
+#endif //DICTA_FRAMEWORKERPOOL_H
@@ -0,0 +1,96 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_FRAMER_H
+#define DICTA_FRAMER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "../util/SIMD.hpp"
+
+namespace Dicta
+{
+    enum class WindowType
+    {
+        Rectangular,
+        Hann,
+        Hamming,
+        Povey
+    };
+    
+    // Splits a stream of samples into overlapping frames of frameLength samples, one every hopLength samples.
+    // Hops are written straight into a contiguous history buffer and each frame is clamped and windowed
+    // in a single pass against a window table computed once, which framers of the same layout can share.
+    class Framer
+    {
+        private:
+        std::size_t frameLength;
+        std::size_t hopLength;
+        std::size_t paddedLength;
+        std::shared_ptr<const std::vector<float>> window;
+        std::vector<float> history;
+        std::size_t historyEnd = 0;
+        std::size_t bufferedSamples = 0;
+        std::size_t lookbackHops = 0;
+        
+        static constexpr std::size_t historyHops = 32;
+        
+        const float* latestFrame(std::size_t hopsAgo = 0) const
+        { return this->history.data() + (this->historyEnd - hopsAgo * this->hopLength - this->frameLength); }
+        
+        public:
+        // Frames are zero padded up to paddedLength samples, useful when the FFT size is bigger than the frame
+        Framer(std::size_t frameLength, std::size_t hopLength, WindowType windowType, std::size_t paddedLength = 0);
+        
+        // Reuses a window table made by makeWindow, which must hold frameLength values
+        Framer(std::size_t frameLength,
+               std::size_t hopLength,
+               std::shared_ptr<const std::vector<float>> window,
+               std::size_t paddedLength = 0);
+        
+        static std::shared_ptr<const std::vector<float>> makeWindow(std::size_t frameLength, WindowType windowType);
+        
+        auto getWindow() const
+        { return this->window; }
+        
+        auto getFrameLength() const
+        { return this->frameLength; }
+        
+        auto getHopLength() const
+        { return this->hopLength; }
+        
+        auto getPaddedLength() const
+        { return this->paddedLength; }
+        
+        // Keeps enough history to window frames up to hops hops older than the latest one
+        void setLookbackHops(std::size_t hops);
+        
+        // Where the next hopLength samples must be written
+        float* getHopInput();
+        
+        // Accounts for the hop written on getHopInput(), returns true if a whole frame is available
+        bool commitHop();
+        
+        // Writes the latest frame, or the one hopsAgo hops before it, clamped to [-1, 1], windowed and zero padded, to output
+        void windowFrame(float* output, std::size_t hopsAgo = 0) const;
+        
+        // Same as above with the frame and padded lengths known at compile time, which must match the runtime ones
+        template <std::size_t FrameLength, std::size_t PaddedLength>
+        void windowFrame(float* output, std::size_t hopsAgo = 0) const
+        {
+            SIMD::clampAndMultiply(this->latestFrame(hopsAgo), this->window->data(), output, FrameLength);
+            std::fill(output + FrameLength, output + PaddedLength, 0.0f);
+        }
+        
+        void reset();
+    };
+}
+
+#endif //DICTA_FRAMER_H
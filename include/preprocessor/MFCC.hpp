@@ -10,13 +10,23 @@
 #define DICTA_MFCC_H
 
 #include <cmath>
+#include <memory>
+#include <stdexcept>
 #include <vector>
-#include <array>
 #include "Frame.hpp"
+#include "../util/SIMD.hpp"
 
 namespace Dicta
 {
-    template <class T>
+    // What the filter banks weight when computed straight from a complex spectrum
+    enum class SpectrumType
+    {
+        Power,
+        Magnitude
+    };
+    
+    // A non zero FilterBankCount fixes the filter count at compile time, so loops over the filters can be unrolled
+    template <class T, std::size_t FilterBankCount = 0>
     class MFCC
     {
         private:
@@ -25,7 +35,15 @@ namespace Dicta
         std::size_t frameLength;
         T lowerFrequency;
         T higherFrequency = sampleRate / 2.0;
-        std::vector<std::array<int, 3>> filterBanks;
+        bool useFastLog = false;
+        SpectrumType spectrumType = SpectrumType::Power;
+        
+        // Triangular filters stored sparse, CSR style: filter i weights spectrum bins starting at
+        // filterStarts[i] with weights[weightOffsets[i]] up to weights[weightOffsets[i + 1]]
+        std::vector<std::size_t> filterStarts;
+        std::vector<std::size_t> weightOffsets;
+        std::vector<T> weights;
+        std::shared_ptr<FramePool<T>> framePool;
         
         public:
         MFCC(std::size_t sampleRate,
@@ -37,37 +55,87 @@ namespace Dicta
                 filterBanksCount(filterBanksCount),
                 frameLength(frameLength),
                 lowerFrequency(lowerFrequency),
-                higherFrequency(higherFrequency)
+                higherFrequency(higherFrequency),
+                framePool(FramePool<T>::create(filterBanksCount))
         {
+            if (FilterBankCount && filterBanksCount != FilterBankCount)
+                throw std::invalid_argument("MFCC error: Filter bank count doesn't match the compile time one");
+            
             this->createFilterBanks();
         }
         
-        Frame <T> computeMFCC(const Frame <T>& frame)
+        std::size_t getFilterBanksCount() const
+        { return FilterBankCount ? FilterBankCount : this->filterBanksCount; }
+        
+        // Use a vectorized logarithm approximation instead of std::log
+        void setFastLog(bool useFastLog)
+        { this->useFastLog = useFastLog; }
+        
+        // Filter banks weight the power spectrum unless told otherwise, only applies to complex spectra
+        void setSpectrumType(SpectrumType spectrumType)
+        { this->spectrumType = spectrumType; }
+        
+        auto getSpectrumType() const
+        { return this->spectrumType; }
+        
+        // Writes the log energy of each filter bank over a magnitude spectrum to output, which must hold
+        // filterBanksCount values. Doesn't allocate nor touch any state, so it's safe to share between threads.
+        void computeMFCC(const T* spectrum, T* output) const
         {
-            Frame<T> filteredFrame(this->filterBanksCount);
-            T* filteredValues = new T[this->filterBanksCount]();
+            const std::size_t filterBanksCount = this->getFilterBanksCount();
             
-            int currentFilter = 0;
-            for (const auto& filterBank : this->filterBanks) {
-                auto begin = filterBank[0];
-                auto center = filterBank[1];
-                auto end = filterBank[2];
-                
-                for (auto pos = begin; pos != center; ++pos)
-                    filteredValues[currentFilter] += frame[pos] * (pos - begin) / static_cast<T>(center - begin);
-                for (auto pos = center; pos != end; ++pos)
-                    filteredValues[currentFilter] += frame[pos] * (end - pos) / static_cast<T>(end - center);
-                ++currentFilter;
-            }
-            for (int pos = 0; pos != this->filterBanksCount; ++pos)
-                filteredFrame.push(std::log(filteredValues[pos]));
+            for (std::size_t filter = 0; filter != filterBanksCount; ++filter)
+                output[filter] = SIMD::dot(spectrum + this->filterStarts[filter],
+                                           this->weights.data() + this->weightOffsets[filter],
+                                           this->weightOffsets[filter + 1] - this->weightOffsets[filter]);
+            
+            this->logEnergies(output);
+        }
+        
+        // Same over the complex spectrum the FFT left in place, fftSize / 2 + 1 (real, imaginary) pairs.
+        // Power or magnitude of each bin goes straight to the filter sums, no spectrum is written anywhere.
+        void computeMFCC(const T (* spectrum)[2], T* output) const
+        {
+            if (this->spectrumType == SpectrumType::Magnitude)
+                this->filterEnergies<true>(spectrum, output);
+            else
+                this->filterEnergies<false>(spectrum, output);
             
-            delete[] filteredValues;
+            this->logEnergies(output);
+        }
+        
+        Frame <T> computeMFCC(const Frame <T>& frame) const
+        {
+            auto filteredFrame = this->framePool->acquire();
+            this->computeMFCC(frame.data(), filteredFrame.data());
+            filteredFrame.commit(this->getFilterBanksCount());
             
             return filteredFrame;
         }
         
         private:
+        template <bool Magnitude>
+        void filterEnergies(const T (* spectrum)[2], T* output) const
+        {
+            const std::size_t filterBanksCount = this->getFilterBanksCount();
+            
+            for (std::size_t filter = 0; filter != filterBanksCount; ++filter)
+                output[filter] = SIMD::dotSpectrum<Magnitude>(spectrum[this->filterStarts[filter]],
+                                                              this->weights.data() + this->weightOffsets[filter],
+                                                              this->weightOffsets[filter + 1] - this->weightOffsets[filter]);
+        }
+        
+        void logEnergies(T* energies) const
+        {
+            const std::size_t filterBanksCount = this->getFilterBanksCount();
+            
+            if (this->useFastLog)
+                SIMD::fastLog(energies, filterBanksCount);
+            else
+                for (std::size_t filter = 0; filter != filterBanksCount; ++filter)
+                    energies[filter] = std::log(energies[filter]);
+        }
+        
         void createFilterBanks()
         {
             T lowerMel = this->hertzToMels(this->lowerFrequency);
@@ -76,16 +144,33 @@ namespace Dicta
             
             std::vector<int> bins;
             
-            for (int pos = 0; pos != this->filterBanksCount + 2; ++pos) {
+            for (std::size_t pos = 0; pos != this->filterBanksCount + 2; ++pos) {
                 bins.push_back(std::floor((this->frameLength + 1) * this->melsToHertz(lowerMel + pos * deltaMel) / this->sampleRate));
             }
             
-            for (int pos = 0; pos != this->filterBanksCount; ++pos) {
-                std::array<int, 3> currentFilterBank;
-                currentFilterBank[0] = bins[pos];
-                currentFilterBank[1] = bins[pos + 1];
-                currentFilterBank[2] = bins[pos + 2];
-                this->filterBanks.push_back(currentFilterBank);
+            // Weights are computed once here, dropping the zeros at the ends of each triangle
+            this->weightOffsets.push_back(0);
+            for (std::size_t pos = 0; pos != this->filterBanksCount; ++pos) {
+                auto begin = bins[pos];
+                auto center = bins[pos + 1];
+                auto end = bins[pos + 2];
+                
+                std::vector<T> filterWeights;
+                for (auto bin = begin; bin != center; ++bin)
+                    filterWeights.push_back((bin - begin) / static_cast<T>(center - begin));
+                for (auto bin = center; bin != end; ++bin)
+                    filterWeights.push_back((end - bin) / static_cast<T>(end - center));
+                
+                std::size_t first = 0;
+                while (first != filterWeights.size() && filterWeights[first] == 0)
+                    ++first;
+                std::size_t last = filterWeights.size();
+                while (last != first && filterWeights[last - 1] == 0)
+                    --last;
+                
+                this->filterStarts.push_back(begin + first);
+                this->weights.insert(this->weights.end(), filterWeights.begin() + first, filterWeights.begin() + last);
+                this->weightOffsets.push_back(this->weights.size());
             }
         }
         
@@ -0,0 +1,52 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_PIPELINECONFIG_HPP
+#define DICTA_PIPELINECONFIG_HPP
+
+#include <cstddef>
+
+namespace Dicta
+{
+    constexpr std::size_t nextPowerOf2(std::size_t num)
+    {
+        std::size_t base2 = 1;
+        while (base2 < num)
+            base2 <<= 1;
+        return base2;
+    }
+    
+    // Sizes decided at run time, from the sample rate and FramingOptions
+    struct RuntimeConfig
+    {
+        static constexpr bool isStatic = false;
+        static constexpr std::size_t filterBankCount = 26;
+    };
+    
+    // Sizes fixed at compile time, so frame lengths and loop bounds become constants the compiler can unroll
+    // and vectorize. Defaults match the runtime ones: the power of 2 closest to 10ms from above, half a frame hops.
+    template <std::size_t SampleRate,
+              std::size_t FrameLength = nextPowerOf2(SampleRate / 100),
+              std::size_t HopLength = FrameLength / 2,
+              std::size_t FilterBankCount = 26>
+    struct StaticConfig
+    {
+        static_assert(SampleRate && FrameLength && HopLength, "Sample rate, frame and hop lengths must be positive");
+        static_assert(FilterBankCount >= 2, "At least 2 filter banks are needed to keep any coefficient");
+        
+        static constexpr bool isStatic = true;
+        static constexpr std::size_t sampleRate = SampleRate;
+        static constexpr std::size_t frameLength = FrameLength;
+        static constexpr std::size_t hopLength = HopLength;
+        // Frames are zero padded up to the FFT size
+        static constexpr std::size_t fftSize = nextPowerOf2(FrameLength);
+        static constexpr std::size_t filterBankCount = FilterBankCount;
+    };
+}
+
+#endif //DICTA_PIPELINECONFIG_HPP
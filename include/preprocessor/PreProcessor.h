@@ -9,69 +9,537 @@
 #ifndef DICTA_PREPROCESSOR_H
 #define DICTA_PREPROCESSOR_H
 
-#include <queue>
-#include <boost/circular_buffer.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
 #include <cmath>
 #include <iostream>
 #include "Frame.hpp"
+#include "DCTMatrix.hpp"
+#include "DeltaFilter.h"
 #include "DFTHandler.h"
 #include "MFCC.hpp"
+#include "Framer.h"
+#include "FrameWorkerPool.h"
+#include "PipelineConfig.hpp"
+#include "VoiceActivityDetector.h"
+#include "../audio/AudioSource.h"
+#include "../features/FeatureWriter.h"
+#include "../util/BoundedQueue.hpp"
+#include "../util/Stats.h"
+#include "../util/ThreadOptions.h"
 
 namespace Dicta
 {
-    class PreProcessor
+    struct FramingOptions
+    {
+        // Zero keeps the default frame, the power of 2 closest to 10ms from above
+        double frameMilliseconds = 0;
+        // Zero means half a frame
+        double hopMilliseconds = 0;
+        WindowType windowType = WindowType::Hann;
+    };
+    
+    struct ExecutionOptions
+    {
+        // Frames transformed at once by FFTW "many" plans, good for offline input
+        std::size_t batchSize = 1;
+        // More than one worker runs the spectral chain on a thread pool instead of the framing thread,
+        // taking precedence over batching
+        std::size_t workerCount = 1;
+        // Processed frames waiting for the consumer, and what to do when it falls behind
+        std::size_t outputCapacity = 1024;
+        OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+        // FFTW planner effort and wisdom cache location
+        PlannerOptions plannerOptions;
+        // Runs the spectral chain only on speech, sending utterance start and end markers along with the frames
+        VoiceActivityOptions voiceActivity;
+        // Frames on each side of the delta regressions. Non zero appends delta and delta-delta coefficients
+        // to every frame, which then comes out 2 * deltaWidth frames late.
+        std::size_t deltaWidth = 0;
+        // CPU affinity and scheduling of the thread running readFrameAndWindowRecordingBuffer and of the workers
+        ThreadOptions framingThread;
+        ThreadOptions workerThreads;
+    };
+    
+    // Config is either RuntimeConfig, sized from the sample rate and FramingOptions given to the constructor,
+    // or a StaticConfig whose sizes are compile time constants
+    template <class Config>
+    class BasicPreProcessor
     {
         private:
+        static constexpr std::size_t filterBankCount = Config::filterBankCount;
+        static constexpr std::size_t lowerFrequency = 0;
+        static constexpr std::size_t coefficientCount = filterBankCount / 2;
+        
         std::size_t sampleRate;
+        std::size_t frameLength;
+        std::size_t hopLength;
         std::size_t samplesPerFrame;
-        std::queue<Frame<float>> processedFrames;
-        DFTHandler dftHandler;
-        MFCC<float> mfcc;
+        Framer framer;
+        BoundedQueue<Frame<float>> processedFrames;
+        DFTHandler<float> dftHandler;
+        MFCC<float, filterBankCount> mfcc;
+        DCTMatrix<float> dct;
+        std::size_t pendingFrames = 0;
+        std::vector<std::int64_t> pendingTimestamps;
+        std::vector<std::int64_t> pendingCaptureTimes;
+        // Capture time of the latest hop read, zero when the source doesn't know it
+        std::int64_t captureTime = 0;
+        // Frames the framer completed so far, processed or not, and frames output so far
+        std::uint64_t framesSeen = 0;
+        std::uint64_t nextSequence = 0;
+        std::shared_ptr<FramePool<float>> coefficientsPool;
+        std::unique_ptr<FrameWorkerPool> workerPool;
+        std::unique_ptr<VoiceActivityDetector> voiceActivityDetector;
+        std::unique_ptr<DeltaFilter> deltaFilter;
+        // Frames skipped since the last processed one, the most an utterance start can reach back
+        std::size_t skippedFrames = 0;
+        ThreadOptions framingThread;
         
-        static constexpr std::size_t filterBankCount = 26;
-        static constexpr std::size_t lowerFrequency = 0;
-        static constexpr float dftFloat = float{};
-        static constexpr double dftDouble = double{};
-        static constexpr double pi = std::atan(1) * 4;
+        BasicPreProcessor(std::size_t sampleRate,
+                          std::size_t frameLength,
+                          std::size_t hopLength,
+                          WindowType windowType,
+                          const ExecutionOptions& executionOptions);
         
         public:
-        PreProcessor(std::size_t sampleRate) :
-                sampleRate(sampleRate),
-                samplesPerFrame(getNextPowerOf2(sampleRate / 100)), // To get 10ms sized processedFrames
-                dftHandler(samplesPerFrame, filterBankCount, dftFloat),
-                mfcc(sampleRate, filterBankCount, samplesPerFrame, lowerFrequency, calculateHigherFrequency(sampleRate))
+        template <class C = Config, std::enable_if_t<!C::isStatic, int> = 0>
+        BasicPreProcessor(std::size_t sampleRate, FramingOptions framingOptions = {}, ExecutionOptions executionOptions = {}) :
+                BasicPreProcessor(sampleRate,
+                                  framingOptions.frameMilliseconds
+                                  ? millisecondsToSamples(sampleRate, framingOptions.frameMilliseconds)
+                                  : nextPowerOf2(sampleRate / 100), // To get 10ms sized processedFrames
+                                  framingOptions.hopMilliseconds
+                                  ? millisecondsToSamples(sampleRate, framingOptions.hopMilliseconds)
+                                  : 0,
+                                  framingOptions.windowType,
+                                  executionOptions)
+        {}
+        
+        template <class C = Config, std::enable_if_t<C::isStatic, int> = 0>
+        explicit BasicPreProcessor(ExecutionOptions executionOptions = {}, WindowType windowType = WindowType::Hann) :
+                BasicPreProcessor(Config::sampleRate, Config::frameLength, Config::hopLength, windowType, executionOptions)
         {}
         
         auto getSamplesPerFrame() const
         { return this->samplesPerFrame; }
         
-        void addFrame(Frame<float> frame)
-        { this->processedFrames.push(std::move(frame)); }
+        void addFrame(Frame<float> frame);
+        
+        // Processed frames, closed once the audio source ends
+        BoundedQueue<Frame<float>>& getProcessedFrames()
+        { return this->processedFrames; }
+        
+        auto getFrameLength() const
+        { return this->frameLength; }
+        
+        auto getHopLength() const
+        { return this->hopLength; }
         
-        float hannWindowFunction(std::size_t index)
-        { return 0.5 * (1 - std::cos((2 * pi * index) / this->samplesPerFrame)); }
+        auto getSampleRate() const
+        { return this->sampleRate; }
         
-        DFTHandler& getDFTHandler()
+        static constexpr std::size_t getCoefficientCount()
+        { return coefficientCount; }
+        
+        // Coefficients of each output frame, static ones followed by deltas and delta-deltas if enabled
+        std::size_t getFrameSize() const
+        { return this->deltaFilter ? this->deltaFilter->getOutputSize() : coefficientCount; }
+        
+        DFTHandler<float>& getDFTHandler()
         { return this->dftHandler; }
         
-        MFCC<float>& getMFCC()
+        MFCC<float, filterBankCount>& getMFCC()
         { return this->mfcc; }
         
-        std::size_t calculateHigherFrequency(std::size_t sampleRate)
+        static std::size_t calculateHigherFrequency(std::size_t sampleRate)
         { return sampleRate / 2;}
         
-        static void readFrameAndWindowRecordingBuffer(boost::circular_buffer<float>* circularBuffer, PreProcessor* preProcessor);
+        // Runs FFT, MFCC and DCT over the framer's latest frame, or the one hopsAgo hops before it,
+        // either right away, on the worker pool or as part of a batch
+        void processFrame(std::size_t hopsAgo = 0);
+        
+        // Processes any frames still waiting for their batch to fill up or for a worker
+        void flush();
         
+        // Frames audioSource until it ends, on the calling thread, after applying ExecutionOptions::framingThread to it
+        static void readFrameAndWindowRecordingBuffer(AudioSource* audioSource, BasicPreProcessor* preProcessor);
+        
+        // Prints processed frames until the audio source ends and every frame was reported
         void report();
         
+        // Header describing the frames this pipeline outputs, stored as encoding
+        FeatureHeader makeFeatureHeader(FeatureEncoding encoding = FeatureEncoding::Float32) const
+        {
+            return FeatureHeader::make(static_cast<std::uint32_t>(this->sampleRate),
+                                       static_cast<std::uint32_t>(this->frameLength),
+                                       static_cast<std::uint32_t>(this->hopLength),
+                                       static_cast<std::uint32_t>(this->getFrameSize()),
+                                       encoding);
+        }
+        
+        // Writes processed frames, markers included, until the audio source ends and every frame was written
+        void record(FeatureWriter& writer);
+        
         private:
-        std::size_t getNextPowerOf2(std::size_t num)
+        // FFT size, a compile time constant with a StaticConfig
+        std::size_t fftSize() const
+        {
+            if constexpr (Config::isStatic)
+                return Config::fftSize;
+            else
+                return this->samplesPerFrame;
+        }
+        
+        void windowFrame(float* output, std::size_t hopsAgo) const
         {
-            std::size_t base2 = 1;
-            while(base2 < num)
-                base2 <<= 1;
-            return base2;
+            StageTimer timer(Stage::Framing);
+            if constexpr (Config::isStatic)
+                this->framer.template windowFrame<Config::frameLength, Config::fftSize>(output, hopsAgo);
+            else
+                this->framer.windowFrame(output, hopsAgo);
         }
+        
+        // Stream time of the latest frame, or the one hopsAgo hops before it
+        std::int64_t frameTimestamp(std::size_t hopsAgo = 0) const
+        {
+            auto frame = this->framesSeen > hopsAgo ? this->framesSeen - 1 - hopsAgo : 0;
+            return static_cast<std::int64_t>(static_cast<double>(frame * this->hopLength) * 1e9 / this->sampleRate);
+        }
+        
+        // Capture time of the latest frame's last sample, or the one hopsAgo hops before it
+        std::int64_t frameCaptureTime(std::size_t hopsAgo = 0) const
+        {
+            if (!this->captureTime)
+                return 0;
+            return this->captureTime - static_cast<std::int64_t>(static_cast<double>(hopsAgo * this->hopLength) * 1e9 / this->sampleRate);
+        }
+        
+        static Frame<float> makeMarker(FrameMarker marker, std::int64_t timestamp)
+        {
+            auto frame = Frame<float>::makeMarker(marker);
+            frame.setTimestamp(timestamp);
+            return frame;
+        }
+        
+        // Runs the voice activity gate over a hop just read, processing the frame it completed if any
+        void processHop(const float* hop, bool frameReady);
+        
+        // Flushes everything and closes an utterance still open when the audio source ends
+        void finish();
+        
+        // Numbers a frame ready for the consumer and queues it
+        void pushFrame(Frame<float> frame);
+        
+        // FFT, mel filter banks and DCT of a windowed frame, each stage timed
+        Frame<float> transform(DFTHandler<float>& dftHandler, const float* windowed) const;
+        
+        // Filter banks straight from a complex spectrum left in place by the FFT, their log energies kept
+        // on the stack and only the kept DCT coefficients written to a pooled frame
+        Frame<float> cepstrum(const DFTHandler<float>::Complex* spectrum) const;
+        
+        static std::size_t millisecondsToSamples(std::size_t sampleRate, double milliseconds)
+        { return static_cast<std::size_t>(std::lround(sampleRate * milliseconds / 1000)); }
     };
+    
+    using PreProcessor = BasicPreProcessor<RuntimeConfig>;
+    
+    template <class Config>
+    BasicPreProcessor<Config>::BasicPreProcessor(std::size_t sampleRate,
+                                                 std::size_t frameLength,
+                                                 std::size_t hopLength,
+                                                 WindowType windowType,
+                                                 const ExecutionOptions& executionOptions) :
+            sampleRate(sampleRate),
+            frameLength(frameLength),
+            hopLength(hopLength ? hopLength : frameLength / 2),
+            samplesPerFrame(nextPowerOf2(frameLength)), // FFT size, frames are zero padded up to it
+            framer(this->frameLength, this->hopLength, windowType, samplesPerFrame),
+            processedFrames(executionOptions.outputCapacity, executionOptions.overflowPolicy),
+            dftHandler(samplesPerFrame, filterBankCount, executionOptions.batchSize, executionOptions.plannerOptions),
+            mfcc(sampleRate, filterBankCount, samplesPerFrame, lowerFrequency, calculateHigherFrequency(sampleRate)),
+            dct(filterBankCount, coefficientCount),
+            pendingTimestamps(dftHandler.getBatchSize()),
+            pendingCaptureTimes(dftHandler.getBatchSize()),
+            coefficientsPool(FramePool<float>::create(coefficientCount)),
+            framingThread(executionOptions.framingThread)
+    {
+        if (executionOptions.voiceActivity.enabled) {
+            this->voiceActivityDetector = std::make_unique<VoiceActivityDetector>(
+                    executionOptions.voiceActivity, sampleRate, this->hopLength);
+            // Utterance onsets and padding are processed after the fact, so their frames must still be around
+            this->framer.setLookbackHops(this->voiceActivityDetector->getLookbackHops());
+        }
+        
+        if (executionOptions.deltaWidth)
+            this->deltaFilter = std::make_unique<DeltaFilter>(coefficientCount, executionOptions.deltaWidth);
+        
+        if (executionOptions.workerCount <= 1)
+            return;
+        
+        // Every worker gets its own FFTW plans and buffers, the mel filter banks and DCT matrix are shared read only
+        auto makeTransform = [this, plannerOptions = executionOptions.plannerOptions] {
+            auto dftHandler = std::make_shared<DFTHandler<float>>(this->fftSize(), filterBankCount, 1, plannerOptions);
+            return FrameWorkerPool::Transform([this, dftHandler](const float* windowed) {
+                return this->transform(*dftHandler, windowed);
+            });
+        };
+        
+        this->workerPool = std::make_unique<FrameWorkerPool>(
+                executionOptions.workerCount, this->fftSize(), makeTransform,
+                [this](Frame<float> frame) { this->addFrame(std::move(frame)); },
+                executionOptions.workerThreads
+        );
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::readFrameAndWindowRecordingBuffer(AudioSource* audioSource, BasicPreProcessor* preProcessor)
+    {
+        auto& framer = preProcessor->framer;
+        auto hopLength = framer.getHopLength();
+        
+        // Hops are read straight into the framer, a frame is emitted as soon as each hop completes one
+        try {
+            preProcessor->framingThread.apply();
+            
+            while (true) {
+                auto hop = framer.getHopInput();
+                if (audioSource->read(hop, hopLength) != hopLength)
+                    break;
+                preProcessor->captureTime = audioSource->getCaptureTime();
+                
+                preProcessor->processHop(hop, framer.commitHop());
+            }
+            
+            preProcessor->finish();
+        }
+        catch (...) {
+            // Don't leave the consumer waiting forever
+            preProcessor->processedFrames.close();
+            throw;
+        }
+        preProcessor->processedFrames.close();
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::processHop(const float* hop, bool frameReady)
+    {
+        this->framesSeen += frameReady;
+        
+        if (!this->voiceActivityDetector) {
+            if (frameReady)
+                this->processFrame();
+            return;
+        }
+        
+        auto& stats = Stats::global();
+        switch (this->voiceActivityDetector->process(hop)) {
+            case VoiceActivity::Silence:
+                break;
+            
+            case VoiceActivity::UtteranceStart: {
+                // Frames of the onset and padding, oldest first, never reaching into the previous utterance
+                auto lookback = std::min(this->voiceActivityDetector->getLookbackHops(), this->skippedFrames);
+                this->addFrame(makeMarker(FrameMarker::UtteranceStart, this->frameTimestamp(lookback)));
+                for (auto hopsAgo = lookback; hopsAgo; --hopsAgo)
+                    this->processFrame(hopsAgo);
+                stats.framesSkipped.fetch_sub(lookback, std::memory_order_relaxed);
+                this->skippedFrames = 0;
+                
+                if (frameReady)
+                    this->processFrame();
+                return;
+            }
+            
+            case VoiceActivity::Speech:
+                if (frameReady)
+                    this->processFrame();
+                return;
+            
+            case VoiceActivity::UtteranceEnd:
+                // Every frame of the utterance goes out before its end marker
+                this->flush();
+                this->addFrame(makeMarker(FrameMarker::UtteranceEnd, this->frameTimestamp()));
+                break;
+        }
+        
+        this->skippedFrames += frameReady;
+        stats.framesSkipped.fetch_add(frameReady, std::memory_order_relaxed);
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::finish()
+    {
+        this->flush();
+        
+        if (this->voiceActivityDetector && this->voiceActivityDetector->isSpeaking())
+            this->addFrame(makeMarker(FrameMarker::UtteranceEnd, this->frameTimestamp()));
+        else if (this->deltaFilter)
+            this->deltaFilter->finish([this](Frame<float> frame) { this->pushFrame(std::move(frame)); });
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::processFrame(std::size_t hopsAgo)
+    {
+        if (this->workerPool) {
+            auto windowed = this->workerPool->acquireInput();
+            this->windowFrame(windowed.data(), hopsAgo);
+            windowed.commit(this->fftSize());
+            windowed.setTimestamp(this->frameTimestamp(hopsAgo));
+            windowed.setCaptureTime(this->frameCaptureTime(hopsAgo));
+            this->workerPool->submit(std::move(windowed));
+            return;
+        }
+        
+        if (this->dftHandler.getBatchSize() == 1) {
+            auto fftInput = this->dftHandler.getFFTInput();
+            this->windowFrame(fftInput, hopsAgo);
+            auto coefficients = this->transform(this->dftHandler, fftInput);
+            coefficients.setTimestamp(this->frameTimestamp(hopsAgo));
+            coefficients.setCaptureTime(this->frameCaptureTime(hopsAgo));
+            this->addFrame(std::move(coefficients));
+            return;
+        }
+        
+        // Window the frame straight on its slot of the batch, transforming all of them once it's full
+        this->windowFrame(this->dftHandler.getFFTBatchInput() + this->pendingFrames * this->fftSize(), hopsAgo);
+        this->pendingTimestamps[this->pendingFrames] = this->frameTimestamp(hopsAgo);
+        this->pendingCaptureTimes[this->pendingFrames] = this->frameCaptureTime(hopsAgo);
+        
+        if (++this->pendingFrames == this->dftHandler.getBatchSize())
+            this->flush();
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::addFrame(Frame<float> frame)
+    {
+        if (this->deltaFilter) {
+            // Frames come out of the filter late, markers close the segment so deltas don't span utterances
+            auto output = [this](Frame<float> frame) { this->pushFrame(std::move(frame)); };
+            if (!frame.isMarker()) {
+                this->deltaFilter->push(frame, output);
+                return;
+            }
+            this->deltaFilter->finish(output);
+        }
+        
+        this->pushFrame(std::move(frame));
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::pushFrame(Frame<float> frame)
+    {
+        auto& stats = Stats::global();
+        if (!frame.isMarker()) {
+            frame.setSequence(this->nextSequence++);
+            stats.recordLatency(frame.getCaptureTime());
+        }
+        
+        auto droppedBefore = this->processedFrames.getDroppedCount();
+        bool pushed;
+        {
+            StageTimer timer(Stage::QueueWait);
+            pushed = this->processedFrames.push(std::move(frame));
+        }
+        
+        stats.framesEmitted.fetch_add(pushed, std::memory_order_relaxed);
+        stats.framesDropped.fetch_add(this->processedFrames.getDroppedCount() - droppedBefore, std::memory_order_relaxed);
+        stats.queueDepth.store(this->processedFrames.size(), std::memory_order_relaxed);
+    }
+    
+    template <class Config>
+    Frame<float> BasicPreProcessor<Config>::transform(DFTHandler<float>& dftHandler, const float* windowed) const
+    {
+        const DFTHandler<float>::Complex* spectrum;
+        {
+            StageTimer timer(Stage::FFT);
+            spectrum = dftHandler.executeFFT(windowed);
+        }
+        return this->cepstrum(spectrum);
+    }
+    
+    template <class Config>
+    Frame<float> BasicPreProcessor<Config>::cepstrum(const DFTHandler<float>::Complex* spectrum) const
+    {
+        float energies[filterBankCount];
+        {
+            StageTimer timer(Stage::Mel);
+            this->mfcc.computeMFCC(spectrum, energies);
+        }
+        
+        StageTimer timer(Stage::DCT);
+        auto coefficients = this->coefficientsPool->acquire();
+        this->dct.compute(energies, coefficients.data());
+        coefficients.commit(coefficientCount);
+        return coefficients;
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::flush()
+    {
+        if (this->workerPool)
+            this->workerPool->flush();
+        
+        if (!this->pendingFrames)
+            return;
+        
+        // The whole batch is transformed, slots past pendingFrames hold stale frames that are just ignored
+        const DFTHandler<float>::Complex* spectra;
+        {
+            StageTimer timer(Stage::FFT, this->pendingFrames);
+            spectra = this->dftHandler.executeFFTBatch();
+        }
+        
+        auto outputSize = this->dftHandler.getOutputSize();
+        for (std::size_t frame = 0; frame != this->pendingFrames; ++frame) {
+            auto coefficients = this->cepstrum(spectra + frame * outputSize);
+            coefficients.setTimestamp(this->pendingTimestamps[frame]);
+            coefficients.setCaptureTime(this->pendingCaptureTimes[frame]);
+            this->addFrame(std::move(coefficients));
+        }
+        
+        this->pendingFrames = 0;
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::report() // Execute on terminal: graph -T png -C --bitmap-size 4000x4000 < A.txt > plot.png
+    {
+        // Sleeps until frames arrive, then prints everything queued so far at once
+        std::vector<Frame<float>> frames;
+        while (this->processedFrames.drain(frames)) {
+            for (auto& frame : frames) {
+                if (frame.isMarker()) {
+                    if (frame.getMarker() != FrameMarker::StreamEnd)
+                        std::cout << (frame.getMarker() == FrameMarker::UtteranceStart ? "# utterance start" : "# utterance end")
+                                  << "\n\n";
+                    continue;
+                }
+                
+                for (std::size_t pos = 0; pos != frame.size(); ++pos)
+                    std::cout << pos << " " << frame[pos] << "\n";
+                
+                std::cout << "\n";
+            }
+            frames.clear();
+        }
+    }
+    
+    template <class Config>
+    void BasicPreProcessor<Config>::record(FeatureWriter& writer)
+    {
+        // Frames go to the writer as they are, it holds them until its next flush
+        std::vector<Frame<float>> frames;
+        while (this->processedFrames.drain(frames)) {
+            for (auto& frame : frames)
+                if (frame.getMarker() != FrameMarker::StreamEnd)
+                    writer.write(std::move(frame));
+            frames.clear();
+        }
+        writer.flush();
+    }
+    
+    // The runtime configured pipeline is compiled once, in PreProcessor.cpp
+    extern template class BasicPreProcessor<RuntimeConfig>;
 }
 #endif //DICTA_PREPROCESSOR_H
@@ -0,0 +1,131 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_STREAMMANAGER_H
+#define DICTA_STREAMMANAGER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "DCTMatrix.hpp"
+#include "DFTHandler.h"
+#include "Frame.hpp"
+#include "Framer.h"
+#include "MFCC.hpp"
+#include "PreProcessor.h"
+#include "../audio/AudioSource.h"
+#include "../util/ThreadOptions.h"
+
+namespace Dicta
+{
+    // Featurizes many audio sources of the same sample rate in one process. Read only state, the window table,
+    // mel filter banks and DCT matrix, exists once for all streams, and every worker of a fixed pool owns FFTW
+    // plans and buffers it uses for any stream. Workers take turns on the streams that have audio, a stream
+    // being run by a single worker at a time, so its frames are framed, transformed and output in order.
+    class StreamManager
+    {
+        public:
+        // Called from the worker threads with each stream's frames, in order, then a FrameMarker::StreamEnd
+        // marker once its source ends. Different streams may be output concurrently.
+        using Output = std::function<void(std::size_t stream, Frame<float> frame)>;
+        
+        private:
+        // Hops a worker frames for a stream before moving on, trading fairness for cache locality
+        static constexpr std::size_t hopsPerTurn = 16;
+        static constexpr std::size_t filterBankCount = RuntimeConfig::filterBankCount;
+        static constexpr std::size_t coefficientCount = filterBankCount / 2;
+        
+        struct Stream
+        {
+            std::unique_ptr<AudioSource> source;
+            Framer framer;
+            std::uint64_t nextSequence = 0;
+        };
+        
+        // Outcome of one turn on a stream
+        enum class Turn
+        {
+            Progress,
+            Idle,
+            Ended
+        };
+        
+        std::size_t sampleRate;
+        std::size_t frameLength;
+        std::size_t hopLength;
+        std::size_t fftSize;
+        Output output;
+        
+        std::shared_ptr<const std::vector<float>> window;
+        MFCC<float, filterBankCount> mfcc;
+        DCTMatrix<float> dct;
+        std::shared_ptr<FramePool<float>> coefficientsPool;
+        std::vector<std::unique_ptr<DFTHandler<float>>> dftHandlers;
+        
+        std::vector<std::unique_ptr<Stream>> streams;
+        
+        // Streams waiting for a worker, each one queued at most once
+        std::mutex readyMutex;
+        std::condition_variable readyCondition;
+        std::deque<std::size_t> ready;
+        std::size_t activeStreams = 0;
+        bool stopping = false;
+        std::exception_ptr error;
+        
+        std::vector<std::thread> workers;
+        ThreadOptions workerThreads;
+        
+        void work(std::size_t worker);
+        Turn runTurn(Stream& stream, std::size_t streamIndex, DFTHandler<float>& dftHandler);
+        
+        public:
+        // frameMilliseconds and hopMilliseconds follow PreProcessor's defaults when zero
+        StreamManager(std::size_t sampleRate,
+                      std::size_t workerCount,
+                      Output output,
+                      FramingOptions framingOptions = {},
+                      const PlannerOptions& plannerOptions = {},
+                      const ThreadOptions& workerThreads = {});
+        ~StreamManager();
+        
+        // Deleted copy and move constructors and operators
+        StreamManager(const StreamManager&) = delete;
+        StreamManager& operator=(const StreamManager&) = delete;
+        StreamManager(StreamManager&&) = delete;
+        StreamManager& operator=(StreamManager&&) = delete;
+        
+        // Adds a source before start(), returning the stream index its frames are output with
+        std::size_t addStream(std::unique_ptr<AudioSource> source);
+        
+        auto getStreamCount() const
+        { return this->streams.size(); }
+        
+        auto getWorkerCount() const
+        { return this->dftHandlers.size(); }
+        
+        auto getHopLength() const
+        { return this->hopLength; }
+        
+        AudioSource& getSource(std::size_t stream)
+        { return *this->streams.at(stream)->source; }
+        
+        // Starts every source and the workers
+        void start();
+        
+        // Waits until every stream ended, rethrowing the first error a source or the output threw
+        void wait();
+    };
+}
+
+#endif //DICTA_STREAMMANAGER_H
@@ -0,0 +1,102 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_VOICEACTIVITYDETECTOR_H
+#define DICTA_VOICEACTIVITYDETECTOR_H
+
+#include <array>
+#include <cstddef>
+
+namespace Dicta
+{
+    struct VoiceActivityOptions
+    {
+        // Off by default, every frame goes through the spectral chain
+        bool enabled = false;
+        // Hop energy over the noise floor, in dB, needed to start an utterance and to keep it going
+        double startThreshold = 12;
+        double stopThreshold = 6;
+        // Noise floors under this, in dBFS, are raised to it, so near digital silence doesn't count as speech
+        double minimumEnergy = -60;
+        // Share of samples changing sign that lets a hop between both thresholds start an utterance,
+        // catching fricatives too quiet to pass the start threshold
+        double zeroCrossingThreshold = 0.25;
+        // Active audio needed to start an utterance, and silence needed to end it
+        double startMilliseconds = 30;
+        double hangoverMilliseconds = 250;
+        // Audio before the start still processed, so soft onsets aren't cut
+        double paddingMilliseconds = 100;
+        // The noise floor is the quietest hop over about this long
+        double noiseFloorMilliseconds = 2000;
+    };
+    
+    enum class VoiceActivity
+    {
+        Silence,
+        UtteranceStart,
+        Speech,
+        UtteranceEnd
+    };
+    
+    // Streaming voice activity detection over raw hops, cheap enough to run before windowing: short time energy
+    // against a minimum tracking noise floor, zero crossing rate for unvoiced onsets, hysteresis between the start
+    // and stop thresholds and a hangover so short pauses don't split utterances
+    class VoiceActivityDetector
+    {
+        private:
+        static constexpr std::size_t noiseFloorBlocks = 4;
+        
+        VoiceActivityOptions options;
+        std::size_t hopLength;
+        std::size_t startHops;
+        std::size_t hangoverHops;
+        std::size_t paddingHops;
+        
+        // Noise floor as the minimum of the last few blocks of hops, updated in constant time
+        std::size_t blockHops;
+        std::array<float, noiseFloorBlocks> blockMinima{};
+        std::size_t completedBlocks = 0;
+        std::size_t hopsInBlock = 0;
+        float blockMinimum;
+        
+        bool speaking = false;
+        std::size_t activeHops = 0;
+        std::size_t silentHops = 0;
+        float energy = 0;
+        float zeroCrossingRate = 0;
+        
+        void updateNoiseFloor(float energy);
+        
+        public:
+        VoiceActivityDetector(const VoiceActivityOptions& options, std::size_t sampleRate, std::size_t hopLength);
+        
+        // Classifies the next hopLength samples of the stream
+        VoiceActivity process(const float* hop);
+        
+        bool isSpeaking() const
+        { return this->speaking; }
+        
+        // Hops before the one starting an utterance that belong to it, the onset and the padding
+        std::size_t getLookbackHops() const
+        { return this->paddingHops + this->startHops - 1; }
+        
+        // Noise floor in dBFS, never below the minimum energy
+        float getNoiseFloor() const;
+        
+        // Energy, in dBFS, and zero crossing rate of the last hop
+        auto getEnergy() const
+        { return this->energy; }
+        
+        auto getZeroCrossingRate() const
+        { return this->zeroCrossingRate; }
+        
+        void reset();
+    };
+}
+
+#endif //DICTA_VOICEACTIVITYDETECTOR_H
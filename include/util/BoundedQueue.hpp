@@ -0,0 +1,174 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_BOUNDEDQUEUE_HPP
+#define DICTA_BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Dicta
+{
+    // What push() does when the queue is full
+    enum class OverflowPolicy
+    {
+        Block,      // Waits for the consumer, applying backpressure on producers
+        DropOldest, // Discards the oldest queued item to make room
+        DropNewest  // Discards the item being pushed
+    };
+    
+    // Fixed capacity multi producer queue, consumers sleep on a condition variable instead of polling.
+    // close() wakes everybody up: producers stop queueing and consumers get what's left, then false.
+    template <typename T>
+    class BoundedQueue
+    {
+        private:
+        std::vector<T> items;
+        std::size_t head = 0;
+        std::size_t count = 0;
+        OverflowPolicy overflowPolicy;
+        bool closed = false;
+        std::atomic<std::size_t> droppedCount{0};
+        
+        mutable std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        
+        void pushBack(T&& item)
+        {
+            this->items[(this->head + this->count) % this->items.size()] = std::move(item);
+            ++this->count;
+        }
+        
+        T popFront()
+        {
+            T item = std::move(this->items[this->head]);
+            this->head = (this->head + 1) % this->items.size();
+            --this->count;
+            return item;
+        }
+        
+        public:
+        explicit BoundedQueue(std::size_t capacity, OverflowPolicy overflowPolicy = OverflowPolicy::Block) :
+                items(capacity),
+                overflowPolicy(overflowPolicy)
+        {
+            if (!capacity)
+                throw std::invalid_argument("BoundedQueue error: Capacity must be positive");
+        }
+        
+        // Deleted copy and move constructors and operators
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+        BoundedQueue(BoundedQueue&&) = delete;
+        BoundedQueue& operator=(BoundedQueue&&) = delete;
+        
+        // Returns false if the item was dropped, either by the overflow policy or because the queue is closed
+        bool push(T item)
+        {
+            T evicted;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (this->count == this->items.size() && !this->closed) {
+                    switch (this->overflowPolicy) {
+                        case OverflowPolicy::Block:
+                            this->notFull.wait(lock, [this] {
+                                return this->closed || this->count != this->items.size();
+                            });
+                            break;
+                        case OverflowPolicy::DropOldest:
+                            // Destroyed outside the lock, so recycling it doesn't hold up the consumer
+                            evicted = this->popFront();
+                            ++this->droppedCount;
+                            break;
+                        case OverflowPolicy::DropNewest:
+                            ++this->droppedCount;
+                            return false;
+                    }
+                }
+                
+                if (this->closed)
+                    return false;
+                
+                this->pushBack(std::move(item));
+            }
+            this->notEmpty.notify_one();
+            return true;
+        }
+        
+        // Waits for an item, returns false once the queue is closed and empty
+        bool pop(T& item)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->notEmpty.wait(lock, [this] { return this->closed || this->count; });
+                if (!this->count)
+                    return false;
+                
+                item = this->popFront();
+            }
+            this->notFull.notify_one();
+            return true;
+        }
+        
+        // Waits for at least one item and moves up to maxItems of them to output in a single lock,
+        // returns how many were appended, 0 once the queue is closed and empty
+        std::size_t drain(std::vector<T>& output, std::size_t maxItems = static_cast<std::size_t>(-1))
+        {
+            std::size_t drained = 0;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->notEmpty.wait(lock, [this] { return this->closed || this->count; });
+                
+                while (this->count && drained != maxItems) {
+                    output.push_back(this->popFront());
+                    ++drained;
+                }
+            }
+            if (drained)
+                this->notFull.notify_all();
+            return drained;
+        }
+        
+        // Signals the end of the stream, waking every waiting producer and consumer
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->closed = true;
+            }
+            this->notEmpty.notify_all();
+            this->notFull.notify_all();
+        }
+        
+        bool isClosed() const
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            return this->closed;
+        }
+        
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            return this->count;
+        }
+        
+        auto capacity() const
+        { return this->items.size(); }
+        
+        auto getDroppedCount() const
+        { return this->droppedCount.load(); }
+    };
+}
+
+#endif //DICTA_BOUNDEDQUEUE_HPP
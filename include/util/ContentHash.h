@@ -0,0 +1,35 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_CONTENTHASH_H
+#define DICTA_CONTENTHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Dicta
+{
+    // XXH64 of size bytes at data, fast enough to be bound by memory bandwidth. Not cryptographic,
+    // only meant to tell contents apart.
+    std::uint64_t contentHash(const void* data, std::size_t size, std::uint64_t seed = 0);
+    
+    inline std::uint64_t contentHash(const std::string& text)
+    { return contentHash(text.data(), text.size()); }
+    
+    // contentHash of a whole file, memory mapped, throwing std::runtime_error if it can't be read
+    std::uint64_t hashFile(const std::string& fileName);
+    
+    // 16 lowercase hex digits
+    std::string hashToString(std::uint64_t hash);
+    
+    // Inverse of hashToString, throwing std::invalid_argument on anything else
+    std::uint64_t hashFromString(const std::string& text);
+}
+
+#endif //DICTA_CONTENTHASH_H
@@ -0,0 +1,432 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_SIMD_H
+#define DICTA_SIMD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+// Small vectorized kernels used on the hot path. Each one has an AVX and an SSE version picked at
+// compile time (configure with DICTA_NATIVE_ARCH to get them) and a scalar version for the tails.
+namespace Dicta
+{
+    namespace SIMD
+    {
+        // output[i] = clamp(input[i], -1, 1) * window[i]
+        inline void clampAndMultiply(const float* input, const float* window, float* output, std::size_t count)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX__)
+            const __m256 lower = _mm256_set1_ps(-1.0f);
+            const __m256 upper = _mm256_set1_ps(1.0f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m256 samples = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input + pos), lower), upper);
+                _mm256_storeu_ps(output + pos, _mm256_mul_ps(samples, _mm256_loadu_ps(window + pos)));
+            }
+#elif defined(__SSE__)
+            const __m128 lower = _mm_set1_ps(-1.0f);
+            const __m128 upper = _mm_set1_ps(1.0f);
+            for (; pos + 4 <= count; pos += 4) {
+                __m128 samples = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + pos), lower), upper);
+                _mm_storeu_ps(output + pos, _mm_mul_ps(samples, _mm_loadu_ps(window + pos)));
+            }
+#endif
+            for (; pos != count; ++pos)
+                output[pos] = std::min(std::max(input[pos], -1.0f), 1.0f) * window[pos];
+        }
+        
+        // Sum of a[i] * b[i]
+        template <class T>
+        inline T dot(const T* a, const T* b, std::size_t count)
+        {
+            T sum = 0;
+            for (std::size_t pos = 0; pos != count; ++pos)
+                sum += a[pos] * b[pos];
+            return sum;
+        }
+        
+        template <>
+        inline float dot(const float* a, const float* b, std::size_t count)
+        {
+            std::size_t pos = 0;
+            float sum = 0;
+#if defined(__AVX__)
+            __m256 sums = _mm256_setzero_ps();
+            for (; pos + 8 <= count; pos += 8) {
+#if defined(__FMA__)
+                sums = _mm256_fmadd_ps(_mm256_loadu_ps(a + pos), _mm256_loadu_ps(b + pos), sums);
+#else
+                sums = _mm256_add_ps(sums, _mm256_mul_ps(_mm256_loadu_ps(a + pos), _mm256_loadu_ps(b + pos)));
+#endif
+            }
+            __m128 half = _mm_add_ps(_mm256_castps256_ps128(sums), _mm256_extractf128_ps(sums, 1));
+            half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+            half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+            sum = _mm_cvtss_f32(half);
+#elif defined(__SSE__)
+            __m128 sums = _mm_setzero_ps();
+            for (; pos + 4 <= count; pos += 4)
+                sums = _mm_add_ps(sums, _mm_mul_ps(_mm_loadu_ps(a + pos), _mm_loadu_ps(b + pos)));
+            sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+            sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1));
+            sum = _mm_cvtss_f32(sums);
+#endif
+            for (; pos != count; ++pos)
+                sum += a[pos] * b[pos];
+            return sum;
+        }
+        
+        // Sum of weights[i] * |spectrum[i]|^2, or weights[i] * |spectrum[i]| with Magnitude, over count complex
+        // values stored interleaved (real, imaginary) like FFTW's output, so no spectrum has to be written out
+        template <bool Magnitude, class T>
+        inline T dotSpectrum(const T* spectrum, const T* weights, std::size_t count)
+        {
+            T sum = 0;
+            for (std::size_t pos = 0; pos != count; ++pos) {
+                T power = spectrum[2 * pos] * spectrum[2 * pos] + spectrum[2 * pos + 1] * spectrum[2 * pos + 1];
+                sum += weights[pos] * (Magnitude ? std::sqrt(power) : power);
+            }
+            return sum;
+        }
+        
+        template <bool Magnitude>
+        inline float dotSpectrum(const float* spectrum, const float* weights, std::size_t count)
+        {
+            std::size_t pos = 0;
+            float sum = 0;
+#if defined(__AVX__)
+            __m256 sums = _mm256_setzero_ps();
+            for (; pos + 8 <= count; pos += 8) {
+                // Bins 0 to 3 and 4 to 7, regrouped as 0, 1, 4, 5 and 2, 3, 6, 7 so the in lane shuffles below
+                // split real and imaginary parts back in order
+                __m256 first = _mm256_loadu_ps(spectrum + 2 * pos);
+                __m256 second = _mm256_loadu_ps(spectrum + 2 * pos + 8);
+                __m256 low = _mm256_permute2f128_ps(first, second, 0x20);
+                __m256 high = _mm256_permute2f128_ps(first, second, 0x31);
+                __m256 real = _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+                __m256 imaginary = _mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+                
+                __m256 power = _mm256_add_ps(_mm256_mul_ps(real, real), _mm256_mul_ps(imaginary, imaginary));
+                if (Magnitude)
+                    power = _mm256_sqrt_ps(power);
+#if defined(__FMA__)
+                sums = _mm256_fmadd_ps(power, _mm256_loadu_ps(weights + pos), sums);
+#else
+                sums = _mm256_add_ps(sums, _mm256_mul_ps(power, _mm256_loadu_ps(weights + pos)));
+#endif
+            }
+            __m128 half = _mm_add_ps(_mm256_castps256_ps128(sums), _mm256_extractf128_ps(sums, 1));
+            half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+            half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+            sum = _mm_cvtss_f32(half);
+#elif defined(__SSE__)
+            __m128 sums = _mm_setzero_ps();
+            for (; pos + 4 <= count; pos += 4) {
+                __m128 first = _mm_loadu_ps(spectrum + 2 * pos);
+                __m128 second = _mm_loadu_ps(spectrum + 2 * pos + 4);
+                __m128 real = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 imaginary = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+                
+                __m128 power = _mm_add_ps(_mm_mul_ps(real, real), _mm_mul_ps(imaginary, imaginary));
+                if (Magnitude)
+                    power = _mm_sqrt_ps(power);
+                sums = _mm_add_ps(sums, _mm_mul_ps(power, _mm_loadu_ps(weights + pos)));
+            }
+            sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+            sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1));
+            sum = _mm_cvtss_f32(sums);
+#endif
+            for (; pos != count; ++pos) {
+                float power = spectrum[2 * pos] * spectrum[2 * pos] + spectrum[2 * pos + 1] * spectrum[2 * pos + 1];
+                sum += weights[pos] * (Magnitude ? std::sqrt(power) : power);
+            }
+            return sum;
+        }
+        
+        // Natural logarithm approximation (Cephes' logf polynomial), relative error around 1e-7 for normal
+        // inputs. Zero and denormals are flushed to the smallest normal float instead of giving -inf.
+        inline float fastLog(float value)
+        {
+            value = std::max(value, 1.17549435e-38f);
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(float));
+            
+            float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 126);
+            bits = (bits & 0x007FFFFFu) | 0x3F000000u; // Mantissa in [0.5, 1)
+            float x;
+            std::memcpy(&x, &bits, sizeof(float));
+            
+            if (x < 0.707106781186547524f) {
+                exponent -= 1;
+                x = x + x - 1;
+            } else
+                x = x - 1;
+            
+            float z = x * x;
+            float y = 7.0376836292E-2f;
+            y = y * x - 1.1514610310E-1f;
+            y = y * x + 1.1676998740E-1f;
+            y = y * x - 1.2420140846E-1f;
+            y = y * x + 1.4249322787E-1f;
+            y = y * x - 1.6668057665E-1f;
+            y = y * x + 2.0000714765E-1f;
+            y = y * x - 2.4999993993E-1f;
+            y = y * x + 3.3333331174E-1f;
+            y = y * x * z;
+            y += exponent * -2.12194440e-4f;
+            y -= 0.5f * z;
+            return x + y + exponent * 0.693359375f;
+        }
+        
+        // values[i] = log(values[i]), exact for any type but float, which uses the vectorized approximation
+        template <class T>
+        inline void fastLog(T* values, std::size_t count)
+        {
+            for (std::size_t pos = 0; pos != count; ++pos)
+                values[pos] = std::log(values[pos]);
+        }
+        
+        template <>
+        inline void fastLog(float* values, std::size_t count)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX2__)
+            const __m256 smallestNormal = _mm256_set1_ps(1.17549435e-38f);
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 half = _mm256_set1_ps(0.5f);
+            const __m256 sqrtHalf = _mm256_set1_ps(0.707106781186547524f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m256 x = _mm256_max_ps(_mm256_loadu_ps(values + pos), smallestNormal);
+                __m256i bits = _mm256_castps_si256(x);
+                
+                __m256 exponent = _mm256_cvtepi32_ps(
+                        _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+                x = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                        _mm256_set1_epi32(0x3F000000)));
+                
+                __m256 mask = _mm256_cmp_ps(x, sqrtHalf, _CMP_LT_OQ);
+                exponent = _mm256_sub_ps(exponent, _mm256_and_ps(one, mask));
+                x = _mm256_add_ps(_mm256_sub_ps(x, one), _mm256_and_ps(x, mask));
+                
+                __m256 z = _mm256_mul_ps(x, x);
+                __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.1514610310E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.1676998740E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.2420140846E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.4249322787E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.6668057665E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(2.0000714765E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-2.4999993993E-1f));
+                y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(3.3333331174E-1f));
+                y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+                y = _mm256_add_ps(y, _mm256_mul_ps(exponent, _mm256_set1_ps(-2.12194440e-4f)));
+                y = _mm256_sub_ps(y, _mm256_mul_ps(z, half));
+                x = _mm256_add_ps(_mm256_add_ps(x, y), _mm256_mul_ps(exponent, _mm256_set1_ps(0.693359375f)));
+                
+                _mm256_storeu_ps(values + pos, x);
+            }
+#elif defined(__SSE2__)
+            const __m128 smallestNormal = _mm_set1_ps(1.17549435e-38f);
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128 sqrtHalf = _mm_set1_ps(0.707106781186547524f);
+            for (; pos + 4 <= count; pos += 4) {
+                __m128 x = _mm_max_ps(_mm_loadu_ps(values + pos), smallestNormal);
+                __m128i bits = _mm_castps_si128(x);
+                
+                __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+                x = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                  _mm_set1_epi32(0x3F000000)));
+                
+                __m128 mask = _mm_cmplt_ps(x, sqrtHalf);
+                exponent = _mm_sub_ps(exponent, _mm_and_ps(one, mask));
+                x = _mm_add_ps(_mm_sub_ps(x, one), _mm_and_ps(x, mask));
+                
+                __m128 z = _mm_mul_ps(x, x);
+                __m128 y = _mm_set1_ps(7.0376836292E-2f);
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.1514610310E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.1676998740E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.2420140846E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.4249322787E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.6668057665E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(2.0000714765E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-2.4999993993E-1f));
+                y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(3.3333331174E-1f));
+                y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+                y = _mm_add_ps(y, _mm_mul_ps(exponent, _mm_set1_ps(-2.12194440e-4f)));
+                y = _mm_sub_ps(y, _mm_mul_ps(z, half));
+                x = _mm_add_ps(_mm_add_ps(x, y), _mm_mul_ps(exponent, _mm_set1_ps(0.693359375f)));
+                
+                _mm_storeu_ps(values + pos, x);
+            }
+#endif
+            for (; pos != count; ++pos)
+                values[pos] = fastLog(values[pos]);
+        }
+        
+        // How many values[i] >= threshold, for a threshold of at least 1
+        inline std::size_t countAtLeast(const std::uint16_t* values, std::size_t count, std::uint16_t threshold)
+        {
+            std::size_t pos = 0;
+            std::size_t total = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+            // No unsigned 16 bit compare before AVX-512, so flip the sign bits and compare values > threshold - 1
+            const std::int16_t bias = static_cast<std::int16_t>(0x8000);
+#endif
+#if defined(__AVX2__)
+            const __m256i signs = _mm256_set1_epi16(bias);
+            const __m256i limit = _mm256_set1_epi16(static_cast<std::int16_t>((threshold - 1) ^ 0x8000));
+            for (; pos + 16 <= count; pos += 16) {
+                __m256i lanes = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + pos)), signs);
+                // Two mask bits per 16 bit lane
+                total += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi16(lanes, limit))) / 2;
+            }
+#elif defined(__SSE2__)
+            const __m128i signs = _mm_set1_epi16(bias);
+            const __m128i limit = _mm_set1_epi16(static_cast<std::int16_t>((threshold - 1) ^ 0x8000));
+            for (; pos + 8 <= count; pos += 8) {
+                __m128i lanes = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + pos)), signs);
+                total += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi16(lanes, limit))) / 2;
+            }
+#endif
+            for (; pos != count; ++pos)
+                total += values[pos] >= threshold;
+            return total;
+        }
+        
+        // IEEE half precision bits of value, rounded to nearest even, the same as F16C does it
+        inline std::uint16_t floatToHalf(float value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            std::uint32_t sign = bits & 0x80000000u;
+            bits ^= sign;
+            
+            std::uint32_t half;
+            if (bits >= 0x47800000u) {
+                // Too big for a half becomes infinity, NaNs stay NaNs
+                half = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+            }
+            else if (bits < 0x38800000u) {
+                // Subnormal half: adding 0.5 shifts the mantissa into place and the FPU rounds it
+                float shifted;
+                std::memcpy(&shifted, &bits, sizeof(shifted));
+                shifted += 0.5f;
+                std::memcpy(&half, &shifted, sizeof(half));
+                half -= 0x3f000000u;
+            }
+            else {
+                // Rebias the exponent and round the 13 dropped mantissa bits to even
+                std::uint32_t oddMantissa = (bits >> 13) & 1;
+                half = (bits - 0x38000000u + 0xfffu + oddMantissa) >> 13;
+            }
+            return static_cast<std::uint16_t>(half | (sign >> 16));
+        }
+        
+        inline float halfToFloat(std::uint16_t half)
+        {
+            std::uint32_t bits = static_cast<std::uint32_t>(half & 0x7fffu) << 13;
+            std::uint32_t exponent = bits & 0x0f800000u;
+            bits += 0x38000000u;
+            
+            float value;
+            if (exponent == 0x0f800000u)
+                // Infinity or NaN
+                bits += 0x38000000u;
+            else if (!exponent) {
+                // Subnormal half, renormalized by the FPU
+                bits += 0x00800000u;
+                std::memcpy(&value, &bits, sizeof(value));
+                value -= 6.103515625e-05f;
+                std::memcpy(&bits, &value, sizeof(bits));
+            }
+            bits |= static_cast<std::uint32_t>(half & 0x8000u) << 16;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        
+        // output[i] = half precision bits of input[i]
+        inline void floatToHalf(const float* input, std::uint16_t* output, std::size_t count)
+        {
+            std::size_t pos = 0;
+#if defined(__F16C__)
+            for (; pos + 8 <= count; pos += 8)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + pos),
+                                 _mm256_cvtps_ph(_mm256_loadu_ps(input + pos), _MM_FROUND_TO_NEAREST_INT));
+#endif
+            for (; pos != count; ++pos)
+                output[pos] = floatToHalf(input[pos]);
+        }
+        
+        // output[i] = input[i] half precision bits as a float
+        inline void halfToFloat(const std::uint16_t* input, float* output, std::size_t count)
+        {
+            std::size_t pos = 0;
+#if defined(__F16C__)
+            for (; pos + 8 <= count; pos += 8)
+                _mm256_storeu_ps(output + pos, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + pos))));
+#endif
+            for (; pos != count; ++pos)
+                output[pos] = halfToFloat(input[pos]);
+        }
+        
+        // output[i] = round(clamp((input[i] - offsets[i]) * inverseScales[i], -127, 127)), rounding to nearest even
+        inline void quantize(const float* input,
+                             const float* offsets,
+                             const float* inverseScales,
+                             std::int8_t* output,
+                             std::size_t count)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX__)
+            const __m256 lower = _mm256_set1_ps(-127.0f);
+            const __m256 upper = _mm256_set1_ps(127.0f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m256 centered = _mm256_sub_ps(_mm256_loadu_ps(input + pos), _mm256_loadu_ps(offsets + pos));
+                __m256 scaled = _mm256_mul_ps(centered, _mm256_loadu_ps(inverseScales + pos));
+                __m256i rounded = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(scaled, lower), upper));
+                // Already in range, so the saturating packs just narrow 32 to 16 to 8 bits
+                __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(rounded), _mm256_extractf128_si256(rounded, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(output + pos), _mm_packs_epi16(words, words));
+            }
+#endif
+            for (; pos != count; ++pos)
+                output[pos] = static_cast<std::int8_t>(std::nearbyint(
+                        std::min(std::max((input[pos] - offsets[pos]) * inverseScales[pos], -127.0f), 127.0f)));
+        }
+        
+        // output[i] = input[i] * scales[i] + offsets[i]
+        inline void dequantize(const std::int8_t* input,
+                               const float* scales,
+                               const float* offsets,
+                               float* output,
+                               std::size_t count)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX2__)
+            for (; pos + 8 <= count; pos += 8) {
+                __m256i values = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + pos)));
+                __m256 scaled = _mm256_mul_ps(_mm256_cvtepi32_ps(values), _mm256_loadu_ps(scales + pos));
+                _mm256_storeu_ps(output + pos, _mm256_add_ps(scaled, _mm256_loadu_ps(offsets + pos)));
+            }
+#endif
+            for (; pos != count; ++pos)
+                output[pos] = input[pos] * scales[pos] + offsets[pos];
+        }
+    }
+}
+
+#endif //DICTA_SIMD_H
@@ -0,0 +1,275 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_STATS_H
+#define DICTA_STATS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Dicta
+{
+    // Pipeline stages timed by Stats
+    enum class Stage
+    {
+        Callback,  // Audio device callback, downmix and ring buffer write
+        Framing,   // Windowing a frame
+        FFT,
+        Mel,
+        DCT,
+        QueueWait, // Producers blocked on a full output queue
+        Latency,   // Device handing a frame's last sample over to the frame reaching the output
+        Count
+    };
+    
+    const char* stageName(Stage stage);
+    
+    // Steady clock nanoseconds, the clock capture times are taken on
+    inline std::int64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // Log-linear histogram of nanosecond durations, HDR style: every power of 2 is split in subBuckets
+    // linear buckets, keeping about 6% precision from 1ns to minutes in a few kilobytes
+    class LatencyHistogram
+    {
+        public:
+        static constexpr std::size_t subBucketBits = 4;
+        static constexpr std::size_t subBuckets = 1 << subBucketBits;
+        // Longer durations, about 18 minutes, land on the last bucket
+        static constexpr std::size_t valueBits = 40;
+        static constexpr std::size_t bucketCount = (valueBits - subBucketBits + 1) * subBuckets;
+        
+        private:
+        // Written by a single thread at a time with plain relaxed loads and stores, no read-modify-write,
+        // atomic only so snapshots can read them while the owner records. Shared ones use recordShared().
+        std::array<std::atomic<std::uint64_t>, bucketCount> buckets{};
+        std::atomic<std::uint64_t> total{0};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> maximum{0};
+        
+        public:
+        static std::size_t bucketOf(std::uint64_t nanoseconds);
+        
+        // Highest value that falls on bucket, reported for every value recorded there
+        static std::uint64_t bucketValue(std::size_t bucket);
+        
+        // Only the histogram's current owner thread may record
+        void record(std::uint64_t nanoseconds, std::uint64_t times = 1);
+        
+        // Slower record any number of threads may run at once
+        void recordShared(std::uint64_t nanoseconds, std::uint64_t times = 1);
+        
+        friend class HistogramSnapshot;
+    };
+    
+    // Plain copy of one or more merged histograms, for reading percentiles
+    class HistogramSnapshot
+    {
+        private:
+        std::array<std::uint64_t, LatencyHistogram::bucketCount> buckets{};
+        std::uint64_t total = 0;
+        std::uint64_t count = 0;
+        std::uint64_t maximum = 0;
+        
+        public:
+        void merge(const LatencyHistogram& histogram);
+        
+        auto getCount() const
+        { return this->count; }
+        
+        auto getMaximum() const
+        { return this->maximum; }
+        
+        double getMean() const
+        { return this->count ? static_cast<double>(this->total) / this->count : 0; }
+        
+        // Duration in nanoseconds percentile percent of the records are under, e.g. percentile(99)
+        std::uint64_t percentile(double percent) const;
+    };
+    
+    struct StatsSnapshot
+    {
+        std::array<HistogramSnapshot, static_cast<std::size_t>(Stage::Count)> stages;
+        std::uint64_t overflowHoles = 0;
+        std::uint64_t holeSamples = 0;
+        std::uint64_t deviceOverflows = 0;
+        std::uint64_t streamErrors = 0;
+        std::uint64_t droppedSamples = 0;
+        std::uint64_t framesEmitted = 0;
+        std::uint64_t framesDropped = 0;
+        std::uint64_t framesSkipped = 0;
+        std::uint64_t queueDepth = 0;
+        
+        const HistogramSnapshot& operator[](Stage stage) const
+        { return this->stages[static_cast<std::size_t>(stage)]; }
+    };
+    
+    std::ostream& operator<<(std::ostream& out, const StatsSnapshot& snapshot);
+    
+    // Process wide latency histograms and health counters, cheap enough to stay on in production.
+    // Every recording thread gets its own histograms, merged by snapshot() without stopping it.
+    class Stats
+    {
+        public:
+        // A thread's histograms, one per stage. Blocks outlive their thread so its records stay in the
+        // snapshots, and are handed to the next thread that starts recording.
+        struct ThreadHistograms
+        {
+            std::array<LatencyHistogram, static_cast<std::size_t>(Stage::Count)> stages;
+            // Claimed with a compare and swap, cleared by the owner thread's exit hook
+            std::atomic<bool> inUse{false};
+        };
+        
+        private:
+        // Tells apart instances for the thread local lookup, addresses may be reused
+        std::uint64_t instance;
+        // Allocated up front so claiming a block never locks nor allocates. Shared with the exit hooks of
+        // the threads holding one, which may run after this instance is gone.
+        std::size_t threadCount;
+        std::shared_ptr<ThreadHistograms[]> threads;
+        // Blocks claimed at least once, the ones snapshot() merges
+        std::atomic<std::size_t> threadsUsed{0};
+        // Recorded with read-modify-writes by threads that found every block taken
+        ThreadHistograms sharedHistograms;
+        std::atomic<bool> enabled{true};
+        
+        // The calling thread's block, claimed on its first record
+        ThreadHistograms& threadHistograms();
+        ThreadHistograms& claimThreadHistograms();
+        
+        public:
+        // Audio device holes (overflows) and the silence samples filling them
+        std::atomic<std::uint64_t> overflowHoles{0};
+        std::atomic<std::uint64_t> holeSamples{0};
+        // Overflows libsoundio reported, the device capturing faster than callbacks ran, and stream errors
+        std::atomic<std::uint64_t> deviceOverflows{0};
+        std::atomic<std::uint64_t> streamErrors{0};
+        // Samples lost because the ring buffer was full
+        std::atomic<std::uint64_t> droppedSamples{0};
+        // Frames that reached the output queue, and those discarded by its overflow policy
+        std::atomic<std::uint64_t> framesEmitted{0};
+        std::atomic<std::uint64_t> framesDropped{0};
+        // Frames the voice activity gate kept out of the spectral chain
+        std::atomic<std::uint64_t> framesSkipped{0};
+        // Output queue depth seen on the last push
+        std::atomic<std::uint64_t> queueDepth{0};
+        
+        Stats();
+        
+        // Deleted copy and move constructors and operators
+        Stats(const Stats&) = delete;
+        Stats& operator=(const Stats&) = delete;
+        Stats(Stats&&) = delete;
+        Stats& operator=(Stats&&) = delete;
+        
+        static Stats& global();
+        
+        // Realtime threads call it before they first record. Their block is then claimed without registering
+        // the exit hook that releases it, as that allocates, so it stays claimed once they exit.
+        static void markRealtimeThread();
+        
+        bool isEnabled() const
+        { return this->enabled.load(std::memory_order_relaxed); }
+        
+        // Disabled stats skip the clock reads, counters keep counting
+        void setEnabled(bool enabled)
+        { this->enabled.store(enabled, std::memory_order_relaxed); }
+        
+        void record(Stage stage, std::uint64_t nanoseconds, std::uint64_t times = 1)
+        {
+            auto& histograms = this->threadHistograms();
+            auto& histogram = histograms.stages[static_cast<std::size_t>(stage)];
+            if (&histograms == &this->sharedHistograms)
+                histogram.recordShared(nanoseconds, times);
+            else
+                histogram.record(nanoseconds, times);
+        }
+        
+        // Records how long ago captureTime was on Stage::Latency, nothing when it's zero, meaning unknown
+        void recordLatency(std::int64_t captureTime)
+        {
+            if (captureTime && this->isEnabled())
+                this->record(Stage::Latency, static_cast<std::uint64_t>(std::max<std::int64_t>(steadyNanoseconds() - captureTime, 0)));
+        }
+        
+        StatsSnapshot snapshot() const;
+    };
+    
+    // Records how long its scope took on a stage, spread over frames when it covers a batch of them
+    class StageTimer
+    {
+        private:
+        Stage stage;
+        std::uint64_t frames;
+        bool enabled;
+        std::chrono::steady_clock::time_point start;
+        
+        public:
+        explicit StageTimer(Stage stage, std::uint64_t frames = 1) :
+                stage(stage),
+                frames(frames),
+                enabled(Stats::global().isEnabled() && frames)
+        {
+            if (this->enabled)
+                this->start = std::chrono::steady_clock::now();
+        }
+        
+        ~StageTimer()
+        {
+            if (!this->enabled)
+                return;
+            
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start);
+            Stats::global().record(this->stage, elapsed.count() / this->frames, this->frames);
+        }
+        
+        // Deleted copy and move constructors and operators
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+        StageTimer(StageTimer&&) = delete;
+        StageTimer& operator=(StageTimer&&) = delete;
+    };
+    
+    // Writes a snapshot to out every interval from a background thread, until destroyed
+    class StatsDumper
+    {
+        private:
+        std::ostream& out;
+        std::chrono::milliseconds interval;
+        std::mutex mutex;
+        std::condition_variable stopCondition;
+        bool stopping = false;
+        std::thread thread;
+        
+        void run();
+        
+        public:
+        StatsDumper(std::ostream& out, std::chrono::milliseconds interval);
+        ~StatsDumper();
+        
+        // Deleted copy and move constructors and operators
+        StatsDumper(const StatsDumper&) = delete;
+        StatsDumper& operator=(const StatsDumper&) = delete;
+        StatsDumper(StatsDumper&&) = delete;
+        StatsDumper& operator=(StatsDumper&&) = delete;
+    };
+}
+
+#endif //DICTA_STATS_H
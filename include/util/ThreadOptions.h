@@ -0,0 +1,39 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_THREADOPTIONS_H
+#define DICTA_THREADOPTIONS_H
+
+#include <string>
+#include <vector>
+
+namespace Dicta
+{
+    // CPU affinity and scheduling of a pipeline thread, left as inherited by default. Realtime priorities
+    // need CAP_SYS_NICE or an RLIMIT_RTPRIO allowing them, and so do negative niceness values.
+    struct ThreadOptions
+    {
+        // CPUs the thread may run on, empty keeping the inherited affinity
+        std::vector<int> cpus;
+        // SCHED_FIFO priority, 1 to 99, zero keeping the time sharing scheduler
+        int realtimePriority = 0;
+        // Niceness under the time sharing scheduler, -20 to 19, ignored with a realtime priority
+        int niceness = 0;
+        
+        bool isDefault() const
+        { return this->cpus.empty() && !this->realtimePriority && !this->niceness; }
+        
+        // Applies the options to the calling thread, throwing std::system_error if the system refuses any
+        void apply() const;
+        
+        // Parses a CPU list like "0-3,6"
+        static std::vector<int> parseCpuList(const std::string& list);
+    };
+}
+
+#endif //DICTA_THREADOPTIONS_H
@@ -0,0 +1,91 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_ADDRESSTABLE_H
+#define DICTA_ADDRESSTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Dicta
+{
+    // Contents of one RAM node: how many times each address was written, addresses never written reading
+    // as zero. A RAM of 16 or more address bits is mostly empty, so instead of 2^bits counters it's an open
+    // addressing hash table with linear probing, keys and counts in separate arrays so probing only walks
+    // keys. A zero count marks an empty slot.
+    class AddressTable
+    {
+        private:
+        static constexpr std::size_t initialCapacity = 8;
+        
+        std::vector<std::uint32_t> keys;
+        std::vector<std::uint16_t> counts;
+        std::size_t used = 0;
+        
+        static std::size_t hash(std::uint32_t address)
+        {
+            std::uint32_t mixed = address * 0x9E3779B1u;
+            return mixed ^ (mixed >> 15);
+        }
+        
+        std::size_t slotOf(std::uint32_t address) const
+        {
+            std::size_t mask = this->keys.size() - 1;
+            std::size_t slot = hash(address) & mask;
+            while (this->counts[slot] && this->keys[slot] != address)
+                slot = (slot + 1) & mask;
+            return slot;
+        }
+        
+        void grow()
+        {
+            std::vector<std::uint32_t> oldKeys(this->keys.empty() ? initialCapacity : this->keys.size() * 2);
+            std::vector<std::uint16_t> oldCounts(oldKeys.size());
+            oldKeys.swap(this->keys);
+            oldCounts.swap(this->counts);
+            
+            for (std::size_t slot = 0; slot != oldKeys.size(); ++slot)
+                if (oldCounts[slot]) {
+                    auto newSlot = this->slotOf(oldKeys[slot]);
+                    this->keys[newSlot] = oldKeys[slot];
+                    this->counts[newSlot] = oldCounts[slot];
+                }
+        }
+        
+        public:
+        // Counts saturate instead of wrapping around
+        void increment(std::uint32_t address)
+        {
+            // Kept at most half full so probe sequences stay short
+            if (2 * (this->used + 1) > this->keys.size())
+                this->grow();
+            
+            auto slot = this->slotOf(address);
+            if (!this->counts[slot]) {
+                this->keys[slot] = address;
+                ++this->used;
+            }
+            if (this->counts[slot] != std::numeric_limits<std::uint16_t>::max())
+                ++this->counts[slot];
+        }
+        
+        std::uint16_t find(std::uint32_t address) const
+        { return this->keys.empty() ? 0 : this->counts[this->slotOf(address)]; }
+        
+        // Addresses written at least once
+        std::size_t size() const
+        { return this->used; }
+        
+        std::size_t memoryUsage() const
+        { return this->keys.capacity() * sizeof(std::uint32_t) + this->counts.capacity() * sizeof(std::uint16_t); }
+    };
+}
+
+#endif //DICTA_ADDRESSTABLE_H
@@ -0,0 +1,70 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_THERMOMETER_H
+#define DICTA_THERMOMETER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../preprocessor/Frame.hpp"
+
+namespace Dicta
+{
+    // Words of a bit packed vector of bitCount bits
+    inline std::size_t packedWords(std::size_t bitCount)
+    { return (bitCount + 63) / 64; }
+    
+    // Binarizes feature vectors for WiSARD: every feature becomes levelCount bits, the first k of them set
+    // when the value passes k of the feature's thresholds, so close values share most of their bits.
+    // Thresholds are either evenly spaced on a range or put on quantiles of training data, which spends
+    // the levels where values actually are.
+    class Thermometer
+    {
+        private:
+        std::size_t featureCount;
+        std::size_t levelCount;
+        // levelCount ascending thresholds per feature
+        std::vector<float> thresholds;
+        
+        public:
+        // Evenly spaced thresholds on [minimum, maximum] for every feature
+        Thermometer(std::size_t featureCount, std::size_t levelCount, float minimum, float maximum);
+        
+        // Thresholds on the quantiles of sampleCount training vectors of featureCount values, stored contiguously
+        static Thermometer fitQuantiles(const float* samples,
+                                        std::size_t sampleCount,
+                                        std::size_t featureCount,
+                                        std::size_t levelCount);
+        
+        auto getFeatureCount() const
+        { return this->featureCount; }
+        
+        auto getLevelCount() const
+        { return this->levelCount; }
+        
+        std::size_t getBitCount() const
+        { return this->featureCount * this->levelCount; }
+        
+        const float* getThresholds(std::size_t feature) const
+        { return this->thresholds.data() + feature * this->levelCount; }
+        
+        // Writes packedWords(getBitCount()) words of bits for featureCount values
+        void encode(const float* features, std::uint64_t* bits) const;
+    };
+    
+    // Stretches or squeezes an utterance's frames of coefficientCount values to exactly frameCount frames,
+    // interpolating linearly, so utterances of any length map to WiSARD inputs of one size.
+    // Writes frameCount * coefficientCount values, marker frames being skipped.
+    void stretchFrames(const std::vector<Frame<float>>& frames,
+                       std::size_t coefficientCount,
+                       std::size_t frameCount,
+                       float* output);
+}
+
+#endif //DICTA_THERMOMETER_H
@@ -0,0 +1,127 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_WISARD_H
+#define DICTA_WISARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AddressTable.hpp"
+#include "Thermometer.h"
+
+namespace Dicta
+{
+    struct WiSARDOptions
+    {
+        // Input bits addressing each RAM node, from 1 to 32
+        std::size_t tupleSize = 16;
+        // Raise the count a RAM needs to answer until a single class wins
+        bool bleaching = true;
+        // Threads training classes at once, zero being one per core
+        std::size_t workerCount = 0;
+        // Seeds the input to RAM mapping, classifiers only agree on what they learned if they share it
+        std::uint64_t seed = 0x5EED5EED5EED5EEDull;
+    };
+    
+    struct Prediction
+    {
+        std::size_t label;
+        // RAM nodes of the winning discriminator that recognized the input
+        std::size_t score;
+        // Count a RAM needed to answer when the decision was taken, 1 meaning no bleaching
+        std::uint16_t threshold;
+        // Margin over the runner up, relative to the winner's score
+        double confidence;
+    };
+    
+    // One class's RAM nodes, one per tuple of input bits
+    class Discriminator
+    {
+        private:
+        std::vector<AddressTable> rams;
+        std::size_t trainedCount = 0;
+        
+        public:
+        explicit Discriminator(std::size_t ramCount) : rams(ramCount)
+        {}
+        
+        void train(const std::uint32_t* addresses)
+        {
+            for (std::size_t ram = 0; ram != this->rams.size(); ++ram)
+                this->rams[ram].increment(addresses[ram]);
+            ++this->trainedCount;
+        }
+        
+        // How many times each RAM saw its address of the input
+        void recall(const std::uint32_t* addresses, std::uint16_t* counts) const
+        {
+            for (std::size_t ram = 0; ram != this->rams.size(); ++ram)
+                counts[ram] = this->rams[ram].find(addresses[ram]);
+        }
+        
+        auto getTrainedCount() const
+        { return this->trainedCount; }
+        
+        std::size_t memoryUsage() const;
+    };
+    
+    // Weightless neural network classifier. Bit packed inputs are cut into tuples of tupleSize bits by a
+    // fixed pseudorandom mapping, every tuple addressing one RAM node of each class's discriminator, and
+    // the class whose RAMs recognize most of the input's addresses wins. Addresses are computed once per
+    // input and shared by all discriminators, and each discriminator's RAM responses are kept as a row of
+    // counts, so a bleaching round is one vectorized compare and popcount per class.
+    class WiSARD
+    {
+        private:
+        std::size_t inputBits;
+        WiSARDOptions options;
+        std::size_t ramCount;
+        // Input bit feeding bit j of RAM r's address, at r * tupleSize + j
+        std::vector<std::uint32_t> mapping;
+        std::vector<Discriminator> discriminators;
+        
+        public:
+        WiSARD(std::size_t inputBits, std::size_t classCount, const WiSARDOptions& options = {});
+        
+        auto getInputBits() const
+        { return this->inputBits; }
+        
+        std::size_t getInputWords() const
+        { return packedWords(this->inputBits); }
+        
+        auto getTupleSize() const
+        { return this->options.tupleSize; }
+        
+        auto getRAMCount() const
+        { return this->ramCount; }
+        
+        std::size_t getClassCount() const
+        { return this->discriminators.size(); }
+        
+        const Discriminator& getDiscriminator(std::size_t label) const
+        { return this->discriminators.at(label); }
+        
+        std::size_t memoryUsage() const;
+        
+        // Writes getRAMCount() addresses for a bit packed input of getInputWords() words
+        void mapAddresses(const std::uint64_t* input, std::uint32_t* addresses) const;
+        
+        void train(const std::uint64_t* input, std::size_t label);
+        
+        // Trains sampleCount inputs stored getInputWords() words apart, classes trained in parallel
+        void train(const std::uint64_t* inputs, const std::size_t* labels, std::size_t sampleCount);
+        
+        // RAM nodes of every discriminator that saw the input's address at least threshold times
+        std::vector<std::size_t> score(const std::uint64_t* input, std::uint16_t threshold = 1) const;
+        
+        Prediction classify(const std::uint64_t* input) const;
+    };
+}
+
+#endif //DICTA_WISARD_H
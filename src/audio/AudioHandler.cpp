@@ -6,35 +6,79 @@
 |-------------------------------------------------------------|
 \*************************************************************/
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <sys/mman.h>
 #include "../../include/audio/AudioHandler.h"
+#include "../../include/util/Stats.h"
 
 namespace Dicta
 {
-    AudioHandler::AudioHandler()
+    namespace
+    {
+        // Native endian formats converted by the callback, false for any other
+        bool toSampleFormat(SoundIoFormat format, SampleFormat& sampleFormat)
+        {
+            switch (format) {
+                case SoundIoFormatS16NE:
+                    sampleFormat = SampleFormat::Signed16;
+                    return true;
+                case SoundIoFormatS24NE:
+                    sampleFormat = SampleFormat::Signed24In32;
+                    return true;
+                case SoundIoFormatS32NE:
+                    sampleFormat = SampleFormat::Signed32;
+                    return true;
+                case SoundIoFormatFloat32NE:
+                    sampleFormat = SampleFormat::Float32;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+    
+    AudioHandler::AudioHandler(const DeviceOptions& options) :
+            options(options)
     {
         initializeSoundIoContext();
         initializeDevice();
         selectSampleRate();
-        checkSupportedFormat();
+        selectFormat();
         initializeInputStream();
         openInputStream();
-        initializeCircularBuffer();
+        initializeRingBuffer();
+        if (this->options.lockMemory)
+            lockMemory();
     }
     
     AudioHandler::~AudioHandler() noexcept
     {
-        delete this->circularBuffer;
         soundio_instream_destroy(this->inStream);
         soundio_device_unref(this->device);
         soundio_destroy(this->soundIo);
+        if (this->memoryLocked)
+            munlock(this, sizeof(*this));
     }
     
-    void AudioHandler::readCallback(SoundIoInStream* inStream, int frameCountMin, int frameCountMax)
+    void AudioHandler::readCallback(SoundIoInStream* inStream, int, int frameCountMax)
     {
-        auto circularBuffer = static_cast<boost::circular_buffer<float>*>(inStream->userdata);
+        // Before the timer's record, which claims this thread's histograms on the first callback
+        Stats::markRealtimeThread();
+        StageTimer timer(Stage::Callback);
+        auto& stats = Stats::global();
+        auto handler = static_cast<AudioHandler*>(inStream->userdata);
+        auto& ringBuffers = handler->ringBuffers;
+        auto sampleFormat = handler->sampleFormat;
+        auto bytesPerSample = static_cast<std::size_t>(inStream->bytes_per_sample);
+        bool split = ringBuffers.size() > 1;
         SoundIoChannelArea* areas;
         int error;
-        float channelsSum = 0;
         int channelCount = inStream->layout.channel_count;
         
         int writeFrames = frameCountMax;
@@ -43,29 +87,82 @@ namespace Dicta
         while (framesLeft > 0) {
             int frameCount = framesLeft;
             
-            if (error = soundio_instream_begin_read(inStream, &areas, &frameCount))
-                throw SoundIoException("Unable to begin reading", error);
+            if ((error = soundio_instream_begin_read(inStream, &areas, &frameCount))) {
+                handler->failStream(error);
+                return;
+            }
             
             if (!frameCount) break;
             
+            // Samples are converted straight into the ring buffers, which publish each area's worth at once,
+            // so this realtime callback never allocates, blocks nor copies twice
+            std::size_t written = 0;
             if (!areas) {
-                // Due to an overflow there is a hole. Fill the circular buffer with silence for the fftSize of the hole.
-                for (int frame = 0; frame != frameCount; ++frame)
-                    circularBuffer->push_back(0);
+                // Due to an overflow there is a hole. Fill the ring buffers with silence for the size of the hole.
+                stats.overflowHoles.fetch_add(1, std::memory_order_relaxed);
+                for (auto& ringBuffer : ringBuffers) {
+                    written += ringBuffer->fill(0, frameCount);
+                    stats.holeSamples.fetch_add(frameCount, std::memory_order_relaxed);
+                }
+            } else if (split) {
+                for (int channel = 0; channel != channelCount; ++channel) {
+                    const auto& area = areas[channel];
+                    written += ringBuffers[channel]->produce(frameCount, [&](float* destination, std::size_t offset, std::size_t count) {
+                        auto source = reinterpret_cast<const std::uint8_t*>(area.ptr) + offset * area.step;
+                        convertSamples(sampleFormat, source, area.step, count, destination);
+                    });
+                }
             } else {
-                for (int frame = 0; frame != frameCount; ++frame) {
+                // Interleaved frames, every channel's sample next to the previous one's, get the vectorized downmix
+                bool interleaved = areas[0].step == static_cast<int>(channelCount * bytesPerSample);
+                for (int channel = 1; channel != channelCount && interleaved; ++channel)
+                    interleaved = areas[channel].ptr == areas[0].ptr + channel * bytesPerSample;
+                
+                written += ringBuffers.front()->produce(frameCount, [&](float* destination, std::size_t offset, std::size_t count) {
+                    if (interleaved) {
+                        auto source = reinterpret_cast<const std::uint8_t*>(areas[0].ptr) + offset * areas[0].step;
+                        downmixSamples(sampleFormat, source, channelCount, count, destination);
+                        return;
+                    }
+                    
+                    const std::uint8_t* sources[SOUNDIO_MAX_CHANNELS];
+                    std::size_t strides[SOUNDIO_MAX_CHANNELS];
                     for (int channel = 0; channel != channelCount; ++channel) {
-                        channelsSum += *(reinterpret_cast<float*>(areas[channel].ptr + frame * areas[channel].step));
+                        sources[channel] = reinterpret_cast<const std::uint8_t*>(areas[channel].ptr) + offset * areas[channel].step;
+                        strides[channel] = areas[channel].step;
                     }
-                    circularBuffer->push_back(channelsSum / channelCount);
-                    channelsSum = 0;
-                }
+                    downmixSamples(sampleFormat, sources, strides, channelCount, count, destination);
+                });
+            }
+            stats.droppedSamples.fetch_add(frameCount * ringBuffers.size() - written, std::memory_order_relaxed);
+            
+            if ((error = soundio_instream_end_read(inStream))) {
+                handler->failStream(error);
+                return;
             }
-            if (error = soundio_instream_end_read(inStream))
-                throw SoundIoException("Unable to end reading", error);
             
             framesLeft -= frameCount;
         }
+        
+        auto& anchor = handler->anchors[handler->anchorsWritten.load(std::memory_order_relaxed) % anchorCount];
+        anchor.endSample.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        anchor.time.store(steadyNanoseconds(), std::memory_order_relaxed);
+        anchor.endSample.store(ringBuffers.front()->totalWritten(), std::memory_order_release);
+        handler->anchorsWritten.fetch_add(1, std::memory_order_release);
+    }
+    
+    void AudioHandler::overflowCallback(SoundIoInStream*)
+    { Stats::global().deviceOverflows.fetch_add(1, std::memory_order_relaxed); }
+    
+    void AudioHandler::errorCallback(SoundIoInStream* inStream, int error)
+    { static_cast<AudioHandler*>(inStream->userdata)->failStream(error); }
+    
+    void AudioHandler::failStream(int error)
+    {
+        int noError = 0;
+        this->streamError.compare_exchange_strong(noError, error, std::memory_order_release, std::memory_order_relaxed);
+        Stats::global().streamErrors.fetch_add(1, std::memory_order_relaxed);
     }
     
     void AudioHandler::initializeSoundIoContext()
@@ -83,7 +180,13 @@ namespace Dicta
     
     void AudioHandler::initializeDevice()
     {
-        this->device = soundio_get_input_device(this->soundIo, soundio_default_input_device_index(this->soundIo));
+        int deviceIndex = this->options.deviceIndex == -1
+                          ? soundio_default_input_device_index(this->soundIo)
+                          : this->options.deviceIndex;
+        if (deviceIndex < 0 || deviceIndex >= soundio_input_device_count(this->soundIo))
+            throw SoundIoException("No input device at the index asked for");
+        
+        this->device = soundio_get_input_device(this->soundIo, deviceIndex);
         
         if (!this->device)
             throw SoundIoException("No input device available");
@@ -108,10 +211,25 @@ namespace Dicta
             throw SoundIoException("Device doesn't support the sample rate used");
     }
     
-    void AudioHandler::checkSupportedFormat()
+    void AudioHandler::selectFormat()
     {
-        if (!soundio_device_supports_format(this->device, this->format))
-            throw SoundIoException("Device doesn't support the format used");
+        if (this->options.format != SoundIoFormatInvalid) {
+            if (!toSampleFormat(this->options.format, this->sampleFormat))
+                throw SoundIoException("The format asked for can't be converted natively");
+            if (!soundio_device_supports_format(this->device, this->options.format))
+                throw SoundIoException("Device doesn't support the format asked for");
+            this->format = this->options.format;
+            return;
+        }
+        
+        // Taken in the order the backend reports them
+        for (int index = 0; index != this->device->format_count; ++index)
+            if (toSampleFormat(this->device->formats[index], this->sampleFormat)) {
+                this->format = this->device->formats[index];
+                return;
+            }
+        
+        throw SoundIoException("Device supports none of the signed 16, 24 and 32 bit and float formats");
     }
     
     void AudioHandler::initializeInputStream()
@@ -123,6 +241,10 @@ namespace Dicta
         this->inStream->format = this->format;
         this->inStream->sample_rate = this->sampleRate;
         this->inStream->read_callback = AudioHandler::readCallback;
+        this->inStream->overflow_callback = AudioHandler::overflowCallback;
+        this->inStream->error_callback = AudioHandler::errorCallback;
+        if (this->options.softwareLatency > 0)
+            this->inStream->software_latency = this->options.softwareLatency;
     }
     
     void AudioHandler::openInputStream()
@@ -131,20 +253,104 @@ namespace Dicta
             throw SoundIoException("Unable to open input stream", error);
     }
     
-    void AudioHandler::initializeCircularBuffer()
+    void AudioHandler::initializeRingBuffer()
+    {
+        int ringBufferCount = this->options.splitChannels ? this->inStream->layout.channel_count : 1;
+        for (int channel = 0; channel != ringBufferCount; ++channel)
+            this->ringBuffers.push_back(
+                    std::make_unique<RingBuffer<float>>(static_cast<std::size_t>(
+                            std::ceil(this->options.ringBufferSeconds * this->inStream->sample_rate))));
+        
+        this->inStream->userdata = this;
+    }
+    
+    void AudioHandler::lockMemory()
     {
-        this->circularBuffer =
-                new boost::circular_buffer<float>(this->circularBufferDuration * this->inStream->sample_rate);
+        for (auto& ringBuffer : this->ringBuffers)
+            ringBuffer->lockInMemory();
         
-        this->inStream->userdata = this->circularBuffer;
+        // The handler holds the capture anchors the callback writes
+        if (mlock(this, sizeof(*this)))
+            throw std::system_error(errno, std::generic_category(), "AudioHandler error: Unable to lock memory");
+        this->memoryLocked = true;
     }
     
     void AudioHandler::startInputStream()
     {
+        if (this->started.exchange(true))
+            return;
+        
         if (int error = soundio_instream_start(this->inStream))
             throw SoundIoException("Unable to start input stream", error);
     }
     
+    std::size_t AudioHandler::readChannel(int channel, float* destination, std::size_t count)
+    {
+        auto& ringBuffer = this->ringBuffers.at(channel);
+        
+        // A live device never ends, so wait until the whole request has been captured, sleeping about
+        // as long as the device takes to capture the missing samples instead of spinning
+        std::size_t samplesRead = 0;
+        while (samplesRead != count) {
+            samplesRead += ringBuffer->read(destination + samplesRead, count - samplesRead);
+            if (samplesRead == count)
+                break;
+            
+            if (int error = this->streamError.load(std::memory_order_acquire))
+                throw SoundIoException("Input stream failed", error);
+            
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                    std::max<std::size_t>((count - samplesRead) * 1000000 / this->sampleRate, 100)
+            ));
+        }
+        return samplesRead;
+    }
+    
+    std::int64_t AudioHandler::getChannelCaptureTime(int channel) const
+    {
+        auto position = this->ringBuffers.at(channel)->totalRead();
+        if (!position)
+            return 0;
+        
+        // Newest to oldest, the earliest callback whose samples reach position delivered it
+        std::int64_t captureTime = 0;
+        auto written = this->anchorsWritten.load(std::memory_order_acquire);
+        for (auto anchor = written; anchor != 0 && written - anchor != anchorCount; --anchor) {
+            auto& slot = this->anchors[(anchor - 1) % anchorCount];
+            auto endSample = slot.endSample.load(std::memory_order_acquire);
+            auto time = slot.time.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!endSample || endSample != slot.endSample.load(std::memory_order_relaxed))
+                continue; // Being rewritten by the callback
+            if (endSample < position)
+                break;
+            captureTime = time;
+        }
+        return captureTime;
+    }
+    
+    std::vector<std::unique_ptr<AudioSource>> AudioHandler::openChannels(const std::shared_ptr<AudioHandler>& handler)
+    {
+        std::vector<std::unique_ptr<AudioSource>> channels;
+        for (int channel = 0; channel != handler->getChannelCount(); ++channel)
+            channels.push_back(std::make_unique<AudioChannel>(handler, channel));
+        return channels;
+    }
+    
+    void AudioHandler::print(std::ostream& out) const
+    { out << *this; }
+    
+    AudioChannel::AudioChannel(std::shared_ptr<AudioHandler> handler, int channel) :
+            handler(std::move(handler)),
+            channel(channel)
+    {
+        if (channel < 0 || channel >= this->handler->getChannelCount())
+            throw std::out_of_range("AudioChannel error: The handler has no ring buffer for that channel");
+    }
+    
+    void AudioChannel::print(std::ostream& out) const
+    { out << "Channel " << this->channel << " of " << *this->handler; }
+    
     std::ostream& operator<<(std::ostream& out, const AudioHandler& audioHandler)
     {
         out << "Device: "
@@ -155,6 +361,12 @@ namespace Dicta
             << audioHandler.inStream->layout.name
             << "\nFormat: "
             << soundio_format_string(audioHandler.format)
+            << "\nSoftware latency: "
+            << audioHandler.inStream->software_latency * 1000
+            << "ms\nRing buffer: "
+            << audioHandler.ringBuffers.front()->capacity() * 1000 / audioHandler.sampleRate
+            << "ms"
+            << (audioHandler.getChannelCount() > 1 ? "\nChannels: split" : "\nChannels: downmixed")
             << std::endl;
         
         return out;
@@ -0,0 +1,202 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../include/audio/FileAudioSource.h"
+
+namespace Dicta
+{
+    namespace
+    {
+        std::uint16_t readLittleEndian16(const std::uint8_t* bytes)
+        { return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8)); }
+        
+        std::uint32_t readLittleEndian32(const std::uint8_t* bytes)
+        {
+            return static_cast<std::uint32_t>(bytes[0])
+                   | (static_cast<std::uint32_t>(bytes[1]) << 8)
+                   | (static_cast<std::uint32_t>(bytes[2]) << 16)
+                   | (static_cast<std::uint32_t>(bytes[3]) << 24);
+        }
+    }
+    
+    FileAudioSource::FileAudioSource(const std::string& fileName) :
+            fileName(fileName)
+    {
+        this->mapFile();
+        try {
+            this->parseWaveHeader();
+        } catch (...) {
+            munmap(const_cast<std::uint8_t*>(this->mappedFile), this->mappedSize);
+            throw;
+        }
+    }
+    
+    FileAudioSource::FileAudioSource(const std::string& fileName, RawAudioFormat rawAudioFormat) :
+            fileName(fileName),
+            sampleRate(rawAudioFormat.sampleRate),
+            channelCount(rawAudioFormat.channelCount),
+            sampleFormat(rawAudioFormat.sampleFormat),
+            bytesPerSample(getBytesPerSample(rawAudioFormat.sampleFormat))
+    {
+        if (this->sampleRate <= 0 || this->channelCount <= 0)
+            throw std::invalid_argument("FileAudioSource error: Invalid raw audio format");
+        
+        this->mapFile();
+        this->setSampleData(this->mappedFile, this->mappedSize);
+    }
+    
+    FileAudioSource::~FileAudioSource() noexcept
+    {
+        munmap(const_cast<std::uint8_t*>(this->mappedFile), this->mappedSize);
+    }
+    
+    void FileAudioSource::mapFile()
+    {
+        int fileDescriptor = open(this->fileName.c_str(), O_RDONLY);
+        if (fileDescriptor == -1)
+            throw std::runtime_error("FileAudioSource error: Unable to open " + this->fileName);
+        
+        struct stat fileStatus;
+        if (fstat(fileDescriptor, &fileStatus) == -1 || fileStatus.st_size == 0) {
+            close(fileDescriptor);
+            throw std::runtime_error("FileAudioSource error: Unable to stat or empty file " + this->fileName);
+        }
+        this->mappedSize = static_cast<std::size_t>(fileStatus.st_size);
+        
+        void* mapping = mmap(nullptr, this->mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        close(fileDescriptor);
+        if (mapping == MAP_FAILED)
+            throw std::runtime_error("FileAudioSource error: Unable to map " + this->fileName);
+        
+        // Samples are consumed front to back exactly once
+        madvise(mapping, this->mappedSize, MADV_SEQUENTIAL);
+        this->mappedFile = static_cast<const std::uint8_t*>(mapping);
+    }
+    
+    void FileAudioSource::parseWaveHeader()
+    {
+        const std::uint8_t* position = this->mappedFile;
+        const std::uint8_t* end = this->mappedFile + this->mappedSize;
+        
+        if (this->mappedSize < 12 || std::memcmp(position, "RIFF", 4) || std::memcmp(position + 8, "WAVE", 4))
+            throw std::runtime_error("FileAudioSource error: " + this->fileName + " isn't a RIFF/WAVE file");
+        position += 12;
+        
+        bool foundFormat = false;
+        while (end - position >= 8) {
+            const std::uint8_t* chunkId = position;
+            std::size_t chunkSize = readLittleEndian32(position + 4);
+            const std::uint8_t* chunkData = position + 8;
+            chunkSize = std::min(chunkSize, static_cast<std::size_t>(end - chunkData));
+            
+            if (!std::memcmp(chunkId, "fmt ", 4)) {
+                if (chunkSize < 16)
+                    throw std::runtime_error("FileAudioSource error: Truncated fmt chunk");
+                
+                std::uint16_t audioFormat = readLittleEndian16(chunkData);
+                this->channelCount = readLittleEndian16(chunkData + 2);
+                this->sampleRate = static_cast<int>(readLittleEndian32(chunkData + 4));
+                std::uint16_t bitsPerSample = readLittleEndian16(chunkData + 14);
+                
+                // WAVE_FORMAT_EXTENSIBLE stores the actual format on the first two bytes of the sub format GUID
+                if (audioFormat == 0xFFFE && chunkSize >= 26)
+                    audioFormat = readLittleEndian16(chunkData + 24);
+                
+                if (audioFormat == 1 && bitsPerSample == 8)
+                    this->sampleFormat = SampleFormat::Unsigned8;
+                else if (audioFormat == 1 && bitsPerSample == 16)
+                    this->sampleFormat = SampleFormat::Signed16;
+                else if (audioFormat == 1 && bitsPerSample == 24)
+                    this->sampleFormat = SampleFormat::Signed24;
+                else if (audioFormat == 1 && bitsPerSample == 32)
+                    this->sampleFormat = SampleFormat::Signed32;
+                else if (audioFormat == 3 && bitsPerSample == 32)
+                    this->sampleFormat = SampleFormat::Float32;
+                else
+                    throw std::runtime_error("FileAudioSource error: Unsupported WAV sample format");
+                
+                this->bytesPerSample = getBytesPerSample(this->sampleFormat);
+                foundFormat = true;
+                
+            } else if (!std::memcmp(chunkId, "data", 4)) {
+                if (!foundFormat)
+                    throw std::runtime_error("FileAudioSource error: data chunk found before fmt chunk");
+                this->setSampleData(chunkData, chunkSize);
+                return;
+            }
+            // Chunks are padded to an even size
+            position = chunkData + chunkSize + (chunkSize & 1);
+        }
+        throw std::runtime_error("FileAudioSource error: " + this->fileName + " has no data chunk");
+    }
+    
+    void FileAudioSource::setSampleData(const std::uint8_t* begin, std::size_t size)
+    {
+        if (this->sampleRate <= 0 || this->channelCount <= 0)
+            throw std::runtime_error("FileAudioSource error: Invalid sample rate or channel count");
+        
+        this->samples = begin;
+        this->frameCount = size / (this->bytesPerSample * this->channelCount);
+        this->currentFrame = 0;
+    }
+    
+    void FileAudioSource::selectChannel(int channel)
+    {
+        if (channel < -1 || channel >= this->channelCount)
+            throw std::out_of_range("FileAudioSource error: " + this->fileName + " has no channel " + std::to_string(channel));
+        
+        this->selectedChannel = channel;
+    }
+    
+    std::size_t FileAudioSource::read(float* destination, std::size_t count)
+    {
+        count = std::min(count, this->frameCount - this->currentFrame);
+        auto bytesPerFrame = this->bytesPerSample * this->channelCount;
+        const std::uint8_t* frame = this->samples + this->currentFrame * bytesPerFrame;
+        
+        // The selected channel, or all channels downmixed to mono just like the capture callback does
+        if (this->selectedChannel != -1)
+            convertSamples(this->sampleFormat, frame + this->selectedChannel * this->bytesPerSample, bytesPerFrame, count, destination);
+        else
+            downmixSamples(this->sampleFormat, frame, this->channelCount, count, destination);
+        
+        this->currentFrame += count;
+        return count;
+    }
+    
+    void FileAudioSource::print(std::ostream& out) const
+    { out << *this; }
+    
+    std::ostream& operator<<(std::ostream& out, const FileAudioSource& fileAudioSource)
+    {
+        out << "File: "
+            << fileAudioSource.fileName
+            << "\nSample Rate: "
+            << fileAudioSource.sampleRate
+            << "Hz\nChannels: "
+            << fileAudioSource.channelCount
+            << (fileAudioSource.selectedChannel == -1
+                ? " (downmixed)"
+                : " (reading channel " + std::to_string(fileAudioSource.selectedChannel) + ")")
+            << "\nFormat: "
+            << getSampleFormatName(fileAudioSource.sampleFormat)
+            << "\nDuration: "
+            << static_cast<double>(fileAudioSource.frameCount) / fileAudioSource.sampleRate
+            << "s"
+            << std::endl;
+        
+        return out;
+    }
+}
@@ -0,0 +1,183 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "../../include/audio/Resampler.h"
+#include "../../include/util/SIMD.hpp"
+
+namespace Dicta
+{
+    namespace
+    {
+        // Zeroth order modified Bessel function of the first kind, by its power series
+        double besselI0(double x)
+        {
+            double sum = 1;
+            double term = 1;
+            for (int k = 1; term > sum * 1e-12; ++k) {
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        }
+        
+        double sinc(double x)
+        {
+            const double pi = std::atan(1) * 4;
+            return x == 0 ? 1 : std::sin(pi * x) / (pi * x);
+        }
+    }
+    
+    PolyphaseResampler::PolyphaseResampler(std::size_t inputRate, std::size_t outputRate, double passband, double attenuation) :
+            inputRate(inputRate),
+            outputRate(outputRate)
+    {
+        if (!inputRate || !outputRate)
+            throw std::invalid_argument("PolyphaseResampler error: Sample rates must be positive");
+        if (!(passband > 0 && passband < 1))
+            throw std::invalid_argument("PolyphaseResampler error: Passband must be a fraction of the Nyquist frequency");
+        
+        auto divisor = std::gcd(inputRate, outputRate);
+        this->up = outputRate / divisor;
+        this->down = inputRate / divisor;
+        
+        // Band edges in cycles per sample at inputRate * up, the transition band ending at the lower Nyquist
+        const double pi = std::atan(1) * 4;
+        double stopband = 0.5 / std::max(this->up, this->down);
+        double transition = stopband * (1 - passband);
+        double cutoff = stopband - transition / 2;
+        
+        // Kaiser's estimates of the window shape and length for that attenuation and transition band
+        double beta = attenuation > 50 ? 0.1102 * (attenuation - 8.7)
+                      : attenuation > 21 ? 0.5842 * std::pow(attenuation - 21, 0.4) + 0.07886 * (attenuation - 21)
+                      : 0;
+        auto length = static_cast<std::size_t>(std::ceil((attenuation - 8) / (2.285 * 2 * pi * transition))) + 1;
+        this->tapsPerPhase = (length + this->up - 1) / this->up;
+        length = this->tapsPerPhase * this->up;
+        this->delay = (length - 1) / 2;
+        
+        // Odd length symmetric around a whole sample, so the delay compensation is exact, the last tap of an
+        // even length left at zero
+        std::vector<double> taps(length);
+        double center = this->delay;
+        for (std::size_t tap = 0; tap <= 2 * this->delay; ++tap) {
+            double position = center ? (tap - center) / center : 0;
+            double window = besselI0(beta * std::sqrt(std::max(0.0, 1 - position * position))) / besselI0(beta);
+            taps[tap] = 2 * cutoff * sinc(2 * cutoff * (tap - center)) * window;
+        }
+        
+        // Phase p holds taps p, p + up, p + 2 up... reversed to line up with the input oldest sample first,
+        // each phase scaled to unit gain so no phase colors the output differently
+        this->phases.resize(length);
+        for (std::size_t phase = 0; phase != this->up; ++phase) {
+            double gain = 0;
+            for (std::size_t tap = 0; tap != this->tapsPerPhase; ++tap)
+                gain += taps[phase + tap * this->up];
+            for (std::size_t tap = 0; tap != this->tapsPerPhase; ++tap)
+                this->phases[phase * this->tapsPerPhase + this->tapsPerPhase - 1 - tap] =
+                        static_cast<float>(taps[phase + tap * this->up] / gain);
+        }
+        
+        this->buffer.assign(this->tapsPerPhase - 1, 0.0f);
+        this->bufferStart = -static_cast<std::int64_t>(this->tapsPerPhase - 1);
+    }
+    
+    void PolyphaseResampler::push(const float* input, std::size_t count)
+    { this->buffer.insert(this->buffer.end(), input, input + count); }
+    
+    void PolyphaseResampler::finish()
+    {
+        // As many outputs as fit before the end of the input, the filter's tail fed with silence
+        auto inputCount = static_cast<std::uint64_t>(std::max<std::int64_t>(this->bufferEnd(), 0));
+        this->outputLimit = (inputCount * this->up + this->down - 1) / this->down;
+        if (this->outputLimit > this->nextOutput)
+            this->buffer.resize(this->buffer.size() + this->inputNeeded(this->outputLimit - this->nextOutput), 0.0f);
+    }
+    
+    std::size_t PolyphaseResampler::pull(float* output, std::size_t count)
+    {
+        std::size_t produced = 0;
+        while (produced != count && this->nextOutput < this->outputLimit) {
+            auto last = this->lastInputFor(this->nextOutput);
+            if (last >= this->bufferEnd())
+                break;
+            
+            auto phase = (this->nextOutput * this->down + this->delay) % this->up;
+            const float* input = this->buffer.data() + (last + 1 - static_cast<std::int64_t>(this->tapsPerPhase) - this->bufferStart);
+            output[produced++] = SIMD::dot(input, this->phases.data() + phase * this->tapsPerPhase, this->tapsPerPhase);
+            ++this->nextOutput;
+        }
+        
+        // Keep only the samples the next output reaches back to
+        auto keepFrom = this->lastInputFor(this->nextOutput) + 1 - static_cast<std::int64_t>(this->tapsPerPhase);
+        auto drop = std::min<std::int64_t>(keepFrom - this->bufferStart, this->buffer.size());
+        if (drop > 0) {
+            this->buffer.erase(this->buffer.begin(), this->buffer.begin() + drop);
+            this->bufferStart += drop;
+        }
+        return produced;
+    }
+    
+    std::size_t PolyphaseResampler::availableWith(std::size_t count) const
+    {
+        // Outputs n whose last input n * down + delay / up is before the end of the input
+        auto end = static_cast<std::int64_t>((this->bufferEnd() + count) * this->up) - static_cast<std::int64_t>(this->delay);
+        if (end <= 0)
+            return 0;
+        
+        auto outputEnd = std::min<std::uint64_t>((end + this->down - 1) / this->down, this->outputLimit);
+        return outputEnd > this->nextOutput ? outputEnd - this->nextOutput : 0;
+    }
+    
+    std::size_t PolyphaseResampler::inputNeeded(std::size_t count) const
+    {
+        if (!count)
+            return 0;
+        return static_cast<std::size_t>(std::max<std::int64_t>(this->lastInputFor(this->nextOutput + count - 1) + 1 - this->bufferEnd(), 0));
+    }
+    
+    ResamplingAudioSource::ResamplingAudioSource(std::unique_ptr<AudioSource> source, int sampleRate) :
+            source(std::move(source)),
+            resampler(this->source->getSampleRate(), sampleRate),
+            chunk(chunkSize)
+    {}
+    
+    std::size_t ResamplingAudioSource::read(float* destination, std::size_t count)
+    {
+        // Reads only the input the request needs, so a live source isn't waited on for more than that
+        auto produced = this->resampler.pull(destination, count);
+        while (produced != count && !this->ended) {
+            auto wanted = std::min(this->resampler.inputNeeded(count - produced), chunkSize);
+            auto got = this->source->read(this->chunk.data(), wanted);
+            this->resampler.push(this->chunk.data(), got);
+            if (got != wanted) {
+                this->ended = true;
+                this->resampler.finish();
+            }
+            produced += this->resampler.pull(destination + produced, count - produced);
+        }
+        return produced;
+    }
+    
+    std::size_t ResamplingAudioSource::availableSamples() const
+    {
+        auto available = this->ended ? 0 : this->source->availableSamples();
+        if (available == std::numeric_limits<std::size_t>::max())
+            return available;
+        return this->resampler.availableWith(available);
+    }
+    
+    void ResamplingAudioSource::print(std::ostream& out) const
+    {
+        out << "Resampled to " << this->resampler.getOutputRate() << "Hz, " << this->resampler.getPhaseCount()
+            << " phases of " << this->resampler.getTapsPerPhase() << " taps, from:\n" << *this->source;
+    }
+}
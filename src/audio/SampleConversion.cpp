@@ -0,0 +1,341 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include "../../include/audio/SampleConversion.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Samples are read with plain loads, which only gives the little endian values files and devices store on
+// little endian machines
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Sample conversion assumes a little endian machine");
+
+namespace Dicta
+{
+    namespace
+    {
+        template <SampleFormat Format>
+        struct Sample;
+        
+        template <>
+        struct Sample<SampleFormat::Unsigned8>
+        {
+            static constexpr std::size_t size = 1;
+            
+            static float load(const std::uint8_t* sample)
+            { return (static_cast<int>(sample[0]) - 128) / 128.0f; }
+        };
+        
+        template <>
+        struct Sample<SampleFormat::Signed16>
+        {
+            static constexpr std::size_t size = 2;
+            
+            static float load(const std::uint8_t* sample)
+            {
+                std::int16_t value;
+                std::memcpy(&value, sample, sizeof(value));
+                return value / 32768.0f;
+            }
+        };
+        
+        template <>
+        struct Sample<SampleFormat::Signed24>
+        {
+            static constexpr std::size_t size = 3;
+            
+            static float load(const std::uint8_t* sample)
+            {
+                // Place the 24 bits on the top of a 32 bits word so the sign gets extended
+                auto value = static_cast<std::int32_t>(
+                        (static_cast<std::uint32_t>(sample[0]) << 8)
+                        | (static_cast<std::uint32_t>(sample[1]) << 16)
+                        | (static_cast<std::uint32_t>(sample[2]) << 24));
+                return (value >> 8) / 8388608.0f;
+            }
+        };
+        
+        template <>
+        struct Sample<SampleFormat::Signed24In32>
+        {
+            static constexpr std::size_t size = 4;
+            
+            static float load(const std::uint8_t* sample)
+            {
+                std::uint32_t value;
+                std::memcpy(&value, sample, sizeof(value));
+                return static_cast<std::int32_t>(value << 8) / 2147483648.0f;
+            }
+        };
+        
+        template <>
+        struct Sample<SampleFormat::Signed32>
+        {
+            static constexpr std::size_t size = 4;
+            
+            static float load(const std::uint8_t* sample)
+            {
+                std::int32_t value;
+                std::memcpy(&value, sample, sizeof(value));
+                return value / 2147483648.0f;
+            }
+        };
+        
+        template <>
+        struct Sample<SampleFormat::Float32>
+        {
+            static constexpr std::size_t size = 4;
+            
+            static float load(const std::uint8_t* sample)
+            {
+                float value;
+                std::memcpy(&value, sample, sizeof(value));
+                return value;
+            }
+        };
+        
+        // Calls body with the format as a compile time constant, so per sample loops don't switch on it
+        template <class Body>
+        void withFormat(SampleFormat sampleFormat, Body&& body)
+        {
+            switch (sampleFormat) {
+                case SampleFormat::Unsigned8:
+                    return body(std::integral_constant<SampleFormat, SampleFormat::Unsigned8>());
+                case SampleFormat::Signed16:
+                    return body(std::integral_constant<SampleFormat, SampleFormat::Signed16>());
+                case SampleFormat::Signed24:
+                    return body(std::integral_constant<SampleFormat, SampleFormat::Signed24>());
+                case SampleFormat::Signed24In32:
+                    return body(std::integral_constant<SampleFormat, SampleFormat::Signed24In32>());
+                case SampleFormat::Signed32:
+                    return body(std::integral_constant<SampleFormat, SampleFormat::Signed32>());
+                case SampleFormat::Float32:
+                    return body(std::integral_constant<SampleFormat, SampleFormat::Float32>());
+            }
+        }
+        
+        template <SampleFormat Format>
+        void convertStrided(const std::uint8_t* source, std::size_t stride, std::size_t count, float* destination)
+        {
+            for (std::size_t pos = 0; pos != count; ++pos, source += stride)
+                destination[pos] = Sample<Format>::load(source);
+        }
+        
+        template <SampleFormat Format>
+        void downmixInterleaved(const std::uint8_t* source, int channelCount, std::size_t count, float* destination)
+        {
+            for (std::size_t pos = 0; pos != count; ++pos) {
+                float channelsSum = 0;
+                for (int channel = 0; channel != channelCount; ++channel, source += Sample<Format>::size)
+                    channelsSum += Sample<Format>::load(source);
+                destination[pos] = channelsSum / channelCount;
+            }
+        }
+        
+        // Contiguous 16 bit samples, sign extended to 32 bits, then converted and scaled
+        void convertSigned16(const std::uint8_t* source, std::size_t count, float* destination)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX2__)
+            const __m256 scale = _mm256_set1_ps(1 / 32768.0f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 2 * pos));
+                __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(samples));
+                _mm256_storeu_ps(destination + pos, _mm256_mul_ps(values, scale));
+            }
+#elif defined(__SSE2__)
+            const __m128 scale = _mm_set1_ps(1 / 32768.0f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 2 * pos));
+                // Each sample on the top half of a 32 bit lane, shifted down extending its sign
+                __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+                __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+                _mm_storeu_ps(destination + pos, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+                _mm_storeu_ps(destination + pos + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+            }
+#endif
+            convertStrided<SampleFormat::Signed16>(source + 2 * pos, 2, count - pos, destination + pos);
+        }
+        
+        // Contiguous 32 bit samples, 24 bit ones shifted to the top of their word first
+        template <SampleFormat Format>
+        void convertSigned32(const std::uint8_t* source, std::size_t count, float* destination)
+        {
+            constexpr int shift = Format == SampleFormat::Signed24In32 ? 8 : 0;
+            std::size_t pos = 0;
+#if defined(__AVX2__)
+            const __m256 scale = _mm256_set1_ps(1 / 2147483648.0f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * pos));
+                __m256 values = _mm256_cvtepi32_ps(_mm256_slli_epi32(samples, shift));
+                _mm256_storeu_ps(destination + pos, _mm256_mul_ps(values, scale));
+            }
+#elif defined(__SSE2__)
+            const __m128 scale = _mm_set1_ps(1 / 2147483648.0f);
+            for (; pos + 4 <= count; pos += 4) {
+                __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 4 * pos));
+                __m128 values = _mm_cvtepi32_ps(_mm_slli_epi32(samples, shift));
+                _mm_storeu_ps(destination + pos, _mm_mul_ps(values, scale));
+            }
+#endif
+            convertStrided<Format>(source + 4 * pos, 4, count - pos, destination + pos);
+        }
+        
+        // Stereo 16 bit frames, both channels summed at once by a multiply-add against ones
+        void downmixStereoSigned16(const std::uint8_t* source, std::size_t count, float* destination)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX2__)
+            const __m256i ones = _mm256_set1_epi16(1);
+            const __m256 scale = _mm256_set1_ps(1 / 65536.0f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m256i frames = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * pos));
+                __m256 sums = _mm256_cvtepi32_ps(_mm256_madd_epi16(frames, ones));
+                _mm256_storeu_ps(destination + pos, _mm256_mul_ps(sums, scale));
+            }
+#elif defined(__SSE2__)
+            const __m128i ones = _mm_set1_epi16(1);
+            const __m128 scale = _mm_set1_ps(1 / 65536.0f);
+            for (; pos + 4 <= count; pos += 4) {
+                __m128i frames = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 4 * pos));
+                __m128 sums = _mm_cvtepi32_ps(_mm_madd_epi16(frames, ones));
+                _mm_storeu_ps(destination + pos, _mm_mul_ps(sums, scale));
+            }
+#endif
+            downmixInterleaved<SampleFormat::Signed16>(source + 4 * pos, 2, count - pos, destination + pos);
+        }
+        
+        // Stereo float frames, left and right samples split apart by shuffles and averaged
+        void averageStereo(const float* source, std::size_t count, float* destination)
+        {
+            std::size_t pos = 0;
+#if defined(__AVX__)
+            const __m256 half = _mm256_set1_ps(0.5f);
+            for (; pos + 8 <= count; pos += 8) {
+                __m256 first = _mm256_loadu_ps(source + 2 * pos);
+                __m256 second = _mm256_loadu_ps(source + 2 * pos + 8);
+                __m256 lower = _mm256_permute2f128_ps(first, second, 0x20);
+                __m256 upper = _mm256_permute2f128_ps(first, second, 0x31);
+                __m256 left = _mm256_shuffle_ps(lower, upper, 0x88);
+                __m256 right = _mm256_shuffle_ps(lower, upper, 0xDD);
+                _mm256_storeu_ps(destination + pos, _mm256_mul_ps(_mm256_add_ps(left, right), half));
+            }
+#elif defined(__SSE__)
+            const __m128 half = _mm_set1_ps(0.5f);
+            for (; pos + 4 <= count; pos += 4) {
+                __m128 first = _mm_loadu_ps(source + 2 * pos);
+                __m128 second = _mm_loadu_ps(source + 2 * pos + 4);
+                __m128 left = _mm_shuffle_ps(first, second, 0x88);
+                __m128 right = _mm_shuffle_ps(first, second, 0xDD);
+                _mm_storeu_ps(destination + pos, _mm_mul_ps(_mm_add_ps(left, right), half));
+            }
+#endif
+            for (; pos != count; ++pos)
+                destination[pos] = (source[2 * pos] + source[2 * pos + 1]) * 0.5f;
+        }
+        
+        // Stereo 32 bit integer frames, converted a chunk at a time on the stack then averaged
+        template <SampleFormat Format>
+        void downmixStereoSigned32(const std::uint8_t* source, std::size_t count, float* destination)
+        {
+            constexpr std::size_t chunkFrames = 256;
+            float converted[2 * chunkFrames];
+            for (std::size_t pos = 0; pos < count; pos += chunkFrames) {
+                auto frames = std::min(chunkFrames, count - pos);
+                convertSigned32<Format>(source + 8 * pos, 2 * frames, converted);
+                averageStereo(converted, frames, destination + pos);
+            }
+        }
+    }
+    
+    std::size_t getBytesPerSample(SampleFormat sampleFormat)
+    {
+        std::size_t size = 0;
+        withFormat(sampleFormat, [&](auto format) { size = Sample<decltype(format)::value>::size; });
+        return size;
+    }
+    
+    const char* getSampleFormatName(SampleFormat sampleFormat)
+    {
+        switch (sampleFormat) {
+            case SampleFormat::Unsigned8: return "unsigned 8 bit";
+            case SampleFormat::Signed16: return "signed 16 bit";
+            case SampleFormat::Signed24: return "signed 24 bit";
+            case SampleFormat::Signed24In32: return "signed 24 bit in 32 bit words";
+            case SampleFormat::Signed32: return "signed 32 bit";
+            case SampleFormat::Float32: return "float 32 bit";
+        }
+        return "unknown";
+    }
+    
+    void convertSamples(SampleFormat sampleFormat,
+                        const std::uint8_t* source,
+                        std::size_t stride,
+                        std::size_t count,
+                        float* destination)
+    {
+        withFormat(sampleFormat, [&](auto format) {
+            constexpr SampleFormat Format = decltype(format)::value;
+            if (stride != Sample<Format>::size)
+                convertStrided<Format>(source, stride, count, destination);
+            else if constexpr (Format == SampleFormat::Signed16)
+                convertSigned16(source, count, destination);
+            else if constexpr (Format == SampleFormat::Signed32 || Format == SampleFormat::Signed24In32)
+                convertSigned32<Format>(source, count, destination);
+            else if constexpr (Format == SampleFormat::Float32)
+                std::memcpy(destination, source, count * sizeof(float));
+            else
+                convertStrided<Format>(source, stride, count, destination);
+        });
+    }
+    
+    void downmixSamples(SampleFormat sampleFormat,
+                        const std::uint8_t* source,
+                        int channelCount,
+                        std::size_t count,
+                        float* destination)
+    {
+        withFormat(sampleFormat, [&](auto format) {
+            constexpr SampleFormat Format = decltype(format)::value;
+            if (channelCount == 1)
+                convertSamples(Format, source, Sample<Format>::size, count, destination);
+            else if (channelCount != 2)
+                downmixInterleaved<Format>(source, channelCount, count, destination);
+            else if constexpr (Format == SampleFormat::Signed16)
+                downmixStereoSigned16(source, count, destination);
+            else if constexpr (Format == SampleFormat::Signed32 || Format == SampleFormat::Signed24In32)
+                downmixStereoSigned32<Format>(source, count, destination);
+            else if constexpr (Format == SampleFormat::Float32)
+                averageStereo(reinterpret_cast<const float*>(source), count, destination);
+            else
+                downmixInterleaved<Format>(source, channelCount, count, destination);
+        });
+    }
+    
+    void downmixSamples(SampleFormat sampleFormat,
+                        const std::uint8_t* const* sources,
+                        const std::size_t* strides,
+                        int channelCount,
+                        std::size_t count,
+                        float* destination)
+    {
+        withFormat(sampleFormat, [&](auto format) {
+            constexpr SampleFormat Format = decltype(format)::value;
+            for (std::size_t pos = 0; pos != count; ++pos) {
+                float channelsSum = 0;
+                for (int channel = 0; channel != channelCount; ++channel)
+                    channelsSum += Sample<Format>::load(sources[channel] + pos * strides[channel]);
+                destination[pos] = channelsSum / channelCount;
+            }
+        });
+    }
+}
@@ -0,0 +1,125 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <unistd.h>
+#include "../../include/features/FeatureCache.h"
+
+namespace Dicta
+{
+    namespace
+    {
+        const char* windowName(WindowType windowType)
+        {
+            switch (windowType) {
+                case WindowType::Rectangular:
+                    return "rectangular";
+                case WindowType::Hann:
+                    return "hann";
+                case WindowType::Hamming:
+                    return "hamming";
+                case WindowType::Povey:
+                    return "povey";
+            }
+            return "unknown";
+        }
+        
+        const char* encodingName(FeatureEncoding encoding)
+        {
+            switch (encoding) {
+                case FeatureEncoding::Float32:
+                    return "f32";
+                case FeatureEncoding::Float16:
+                    return "f16";
+                case FeatureEncoding::Int8:
+                    return "i8";
+            }
+            return "unknown";
+        }
+        
+        std::string resolveDirectory(const std::string& directory)
+        {
+            if (!directory.empty())
+                return directory;
+            
+            if (auto dictaDirectory = std::getenv("DICTA_CACHE_DIR"))
+                return dictaDirectory;
+            if (auto cacheHome = std::getenv("XDG_CACHE_HOME"))
+                return std::string(cacheHome) + "/dicta/features";
+            if (auto home = std::getenv("HOME"))
+                return std::string(home) + "/.cache/dicta/features";
+            
+            return "features";
+        }
+        
+        // Unique among the threads and processes writing to the cache
+        std::string temporarySuffix()
+        {
+            static std::atomic<std::uint64_t> counter{0};
+            return ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+        }
+    }
+    
+    std::string FeatureConfiguration::describe() const
+    {
+        return "dicta-features v" + std::to_string(pipelineVersion)
+               + " rate=" + std::to_string(this->sampleRate)
+               + " frame=" + std::to_string(this->frameLength)
+               + " hop=" + std::to_string(this->hopLength)
+               + " fft=" + std::to_string(this->fftSize)
+               + " filters=" + std::to_string(this->filterBankCount)
+               + " window=" + windowName(this->windowType)
+               + " deltas=" + std::to_string(this->deltaWidth)
+               + " encoding=" + encodingName(this->encoding);
+    }
+    
+    FeatureCache::FeatureCache(const std::string& directory) : directory(resolveDirectory(directory))
+    {}
+    
+    std::string FeatureCache::entryPath(std::uint64_t audioHash, const FeatureConfiguration& configuration) const
+    {
+        auto audio = hashToString(audioHash);
+        return this->directory + "/" + hashToString(configuration.hash()) + "/" + audio.substr(0, 2) + "/" + audio + ".features";
+    }
+    
+    bool FeatureCache::contains(std::uint64_t audioHash, const FeatureConfiguration& configuration) const
+    {
+        return ::access(this->entryPath(audioHash, configuration).c_str(), F_OK) == 0;
+    }
+    
+    std::unique_ptr<FeatureReader> FeatureCache::open(std::uint64_t audioHash, const FeatureConfiguration& configuration) const
+    {
+        if (!this->contains(audioHash, configuration))
+            return nullptr;
+        return std::make_unique<FeatureReader>(this->entryPath(audioHash, configuration));
+    }
+    
+    std::string FeatureCache::prepare(const std::string& path, const FeatureConfiguration& configuration) const
+    {
+        std::filesystem::path entry(path);
+        std::error_code error;
+        std::filesystem::create_directories(entry.parent_path(), error);
+        if (error)
+            throw std::runtime_error("FeatureCache error: Couldn't create " + entry.parent_path().string() + ": " + error.message());
+        
+        // Written once per configuration, through a temporary file like the entries
+        auto configurationPath = entry.parent_path().parent_path() / "configuration";
+        if (::access(configurationPath.c_str(), F_OK)) {
+            auto temporaryPath = configurationPath.string() + temporarySuffix();
+            std::ofstream(temporaryPath) << configuration.describe() << "\n";
+            if (std::rename(temporaryPath.c_str(), configurationPath.c_str()))
+                std::remove(temporaryPath.c_str());
+        }
+        
+        return path + temporarySuffix();
+    }
+}
@@ -0,0 +1,173 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "../../include/features/FeatureFormat.h"
+#include "../../include/util/SIMD.hpp"
+
+namespace Dicta
+{
+    namespace
+    {
+        std::runtime_error unknownEncoding(FeatureEncoding encoding)
+        {
+            return std::runtime_error("FeatureHeader error: Unknown encoding "
+                                      + std::to_string(static_cast<std::uint32_t>(encoding)));
+        }
+    }
+    
+    constexpr char FeatureHeader::expectedMagic[8];
+    
+    FeatureHeader FeatureHeader::make(std::uint32_t sampleRate,
+                                      std::uint32_t frameLength,
+                                      std::uint32_t hopLength,
+                                      std::uint32_t coefficientCount,
+                                      FeatureEncoding encoding)
+    {
+        FeatureHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, expectedMagic, sizeof(header.magic));
+        header.version = currentVersion;
+        header.headerSize = sizeof(FeatureHeader);
+        header.sampleRate = sampleRate;
+        header.frameLength = frameLength;
+        header.hopLength = hopLength;
+        header.coefficientCount = coefficientCount;
+        header.encoding = encoding;
+        header.recordSize = static_cast<std::uint32_t>(Dicta::recordSize(coefficientCount, encoding));
+        return header;
+    }
+    
+    void FeatureHeader::validate() const
+    {
+        if (std::memcmp(this->magic, expectedMagic, sizeof(this->magic)))
+            throw std::runtime_error("FeatureHeader error: Not a feature stream");
+        
+        if (this->version != currentVersion)
+            throw std::runtime_error("FeatureHeader error: Unsupported version " + std::to_string(this->version));
+        
+        if (this->headerSize < sizeof(FeatureHeader))
+            throw std::runtime_error("FeatureHeader error: Header of " + std::to_string(this->headerSize) + " bytes is too short");
+        
+        // Throws on encodings this build doesn't know
+        if (this->recordSize != Dicta::recordSize(this->coefficientCount, this->encoding))
+            throw std::runtime_error("FeatureHeader error: Record size doesn't match the coefficients");
+    }
+    
+    std::size_t bytesPerCoefficient(FeatureEncoding encoding)
+    {
+        switch (encoding) {
+            case FeatureEncoding::Float32:
+                return sizeof(float);
+            case FeatureEncoding::Float16:
+                return sizeof(std::uint16_t);
+            case FeatureEncoding::Int8:
+                return sizeof(std::int8_t);
+        }
+        throw unknownEncoding(encoding);
+    }
+    
+    std::int8_t scaleExponent(float maximumMagnitude)
+    {
+        // Powers of 2^(1/8) keep the scale in a byte and waste at most 9% of the int8 range
+        if (!(maximumMagnitude > 0))
+            return std::numeric_limits<std::int8_t>::min();
+        
+        auto exponent = static_cast<int>(std::ceil(8 * std::log2(maximumMagnitude / 127)));
+        // Rounding on log2 may leave the scale a hair short, making the largest magnitude clamp
+        while (exponent < std::numeric_limits<std::int8_t>::max() && scaleOf(static_cast<std::int8_t>(exponent)) * 127 < maximumMagnitude)
+            ++exponent;
+        return static_cast<std::int8_t>(std::clamp<int>(exponent, std::numeric_limits<std::int8_t>::min(),
+                                                        std::numeric_limits<std::int8_t>::max()));
+    }
+    
+    void encodeCoefficients(FeatureEncoding encoding,
+                            const float* coefficients,
+                            std::size_t count,
+                            const float* offsets,
+                            const float* inverseScales,
+                            void* output)
+    {
+        switch (encoding) {
+            case FeatureEncoding::Float32:
+                std::memcpy(output, coefficients, count * sizeof(float));
+                return;
+            case FeatureEncoding::Float16:
+                SIMD::floatToHalf(coefficients, static_cast<std::uint16_t*>(output), count);
+                return;
+            case FeatureEncoding::Int8:
+                SIMD::quantize(coefficients, offsets, inverseScales, static_cast<std::int8_t*>(output), count);
+                return;
+        }
+        throw unknownEncoding(encoding);
+    }
+    
+    void decodeCoefficients(FeatureEncoding encoding,
+                            const void* input,
+                            std::size_t count,
+                            const float* scales,
+                            const float* offsets,
+                            float* output)
+    {
+        switch (encoding) {
+            case FeatureEncoding::Float32:
+                std::memcpy(output, input, count * sizeof(float));
+                return;
+            case FeatureEncoding::Float16:
+                SIMD::halfToFloat(static_cast<const std::uint16_t*>(input), output, count);
+                return;
+            case FeatureEncoding::Int8:
+                SIMD::dequantize(static_cast<const std::int8_t*>(input), scales, offsets, output, count);
+                return;
+        }
+        throw unknownEncoding(encoding);
+    }
+    
+    void encodeScaleRecords(const std::int8_t* exponents, const float* offsets, std::size_t coefficientCount, void* output)
+    {
+        auto recordSize = Dicta::recordSize(coefficientCount, FeatureEncoding::Int8);
+        auto payloadSize = recordSize - sizeof(RecordPrefix);
+        auto records = scaleRecordCount(coefficientCount);
+        auto record = static_cast<std::uint8_t*>(output);
+        std::memset(record, 0, records * recordSize);
+        
+        RecordPrefix prefix{0, 0, scaleRecordMarker, 0};
+        for (std::size_t index = 0; index != records; ++index)
+            std::memcpy(record + index * recordSize, &prefix, sizeof(RecordPrefix));
+        
+        std::memcpy(record + sizeof(RecordPrefix), exponents, coefficientCount);
+        
+        // Offsets continue from one record's coefficients to the next one's
+        auto offsetBytes = reinterpret_cast<const std::uint8_t*>(offsets);
+        for (std::size_t written = 0, size = coefficientCount * sizeof(float); written < size; written += payloadSize) {
+            record += recordSize;
+            std::memcpy(record + sizeof(RecordPrefix), offsetBytes + written, std::min(payloadSize, size - written));
+        }
+    }
+    
+    void decodeScaleRecords(const void* input, std::size_t coefficientCount, float* scales, float* offsets)
+    {
+        auto recordSize = Dicta::recordSize(coefficientCount, FeatureEncoding::Int8);
+        auto payloadSize = recordSize - sizeof(RecordPrefix);
+        auto record = static_cast<const std::uint8_t*>(input);
+        
+        auto exponents = reinterpret_cast<const std::int8_t*>(record + sizeof(RecordPrefix));
+        for (std::size_t pos = 0; pos != coefficientCount; ++pos)
+            scales[pos] = scaleOf(exponents[pos]);
+        
+        auto offsetBytes = reinterpret_cast<std::uint8_t*>(offsets);
+        for (std::size_t read = 0, size = coefficientCount * sizeof(float); read < size; read += payloadSize) {
+            record += recordSize;
+            std::memcpy(offsetBytes + read, record + sizeof(RecordPrefix), std::min(payloadSize, size - read));
+        }
+    }
+}
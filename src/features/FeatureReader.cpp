@@ -0,0 +1,162 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../include/features/FeatureReader.h"
+
+namespace Dicta
+{
+    FeatureReader::FeatureReader(const std::string& fileName) : fileName(fileName)
+    {
+        int fileDescriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fileDescriptor < 0)
+            throw std::runtime_error("FeatureReader error: Couldn't open " + fileName + ": " + std::strerror(errno));
+        
+        struct stat status;
+        if (::fstat(fileDescriptor, &status) < 0) {
+            ::close(fileDescriptor);
+            throw std::runtime_error("FeatureReader error: Couldn't stat " + fileName + ": " + std::strerror(errno));
+        }
+        this->mappedSize = static_cast<std::size_t>(status.st_size);
+        
+        if (this->mappedSize < sizeof(FeatureHeader)) {
+            ::close(fileDescriptor);
+            throw std::runtime_error("FeatureReader error: " + fileName + " is too short for a feature stream");
+        }
+        
+        // The mapping outlives the descriptor
+        void* mapping = ::mmap(nullptr, this->mappedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        ::close(fileDescriptor);
+        if (mapping == MAP_FAILED)
+            throw std::runtime_error("FeatureReader error: Couldn't map " + fileName + ": " + std::strerror(errno));
+        this->mappedFile = static_cast<const std::uint8_t*>(mapping);
+        
+        try {
+            std::memcpy(&this->header, this->mappedFile, sizeof(FeatureHeader));
+            this->header.validate();
+            if (this->header.headerSize > this->mappedSize)
+                throw std::runtime_error("FeatureReader error: " + fileName + " is too short for its header");
+        }
+        catch (...) {
+            ::munmap(const_cast<std::uint8_t*>(this->mappedFile), this->mappedSize);
+            throw;
+        }
+        
+        ::madvise(const_cast<std::uint8_t*>(this->mappedFile), this->mappedSize, MADV_SEQUENTIAL);
+        
+        auto storedCount = (this->mappedSize - this->header.headerSize) / this->header.recordSize;
+        if (this->header.encoding != FeatureEncoding::Int8) {
+            this->recordCount = storedCount;
+            this->segments.push_back(Segment{0, 0, noScales});
+            return;
+        }
+        
+        try {
+            this->indexSegments(storedCount);
+        }
+        catch (...) {
+            ::munmap(const_cast<std::uint8_t*>(this->mappedFile), this->mappedSize);
+            throw;
+        }
+    }
+    
+    void FeatureReader::indexSegments(std::size_t storedCount)
+    {
+        // Markers may come before the first scale record, data records may not
+        this->segments.push_back(Segment{0, 0, noScales});
+        auto coefficientCount = this->header.coefficientCount;
+        auto scaleRecords = scaleRecordCount(coefficientCount);
+        for (std::size_t index = 0; index != storedCount; ++index) {
+            RecordPrefix prefix;
+            std::memcpy(&prefix, this->storedRecord(index), sizeof(RecordPrefix));
+            
+            if (prefix.marker == scaleRecordMarker) {
+                // Scale records cut short by a writer still appending hide the rest of the stream, like a partial record
+                if (storedCount - index < scaleRecords)
+                    break;
+                for (std::size_t next = index + 1; next != index + scaleRecords; ++next) {
+                    std::memcpy(&prefix, this->storedRecord(next), sizeof(RecordPrefix));
+                    if (prefix.marker != scaleRecordMarker)
+                        throw std::runtime_error("FeatureReader error: Incomplete scales at record "
+                                                 + std::to_string(this->recordCount) + " of " + this->fileName);
+                }
+                
+                auto scaleOffset = this->scales.size();
+                this->segments.push_back(Segment{this->recordCount, index + scaleRecords, scaleOffset});
+                this->scales.resize(scaleOffset + 2 * coefficientCount);
+                decodeScaleRecords(this->storedRecord(index), coefficientCount, this->scales.data() + scaleOffset,
+                                   this->scales.data() + scaleOffset + coefficientCount);
+                index += scaleRecords - 1;
+                continue;
+            }
+            
+            if (prefix.marker == static_cast<std::uint32_t>(FrameMarker::None) && this->segments.back().scaleOffset == noScales)
+                throw std::runtime_error("FeatureReader error: Record " + std::to_string(this->recordCount) + " of "
+                                         + this->fileName + " has no scales");
+            ++this->recordCount;
+        }
+    }
+    
+    FeatureReader::~FeatureReader() noexcept
+    {
+        ::munmap(const_cast<std::uint8_t*>(this->mappedFile), this->mappedSize);
+    }
+    
+    FeatureRecord FeatureReader::operator[](std::size_t index) const
+    {
+        // The segment holding index, the last one starting at or before it
+        auto segment = std::prev(std::upper_bound(this->segments.begin(), this->segments.end(), index,
+                                                  [](std::size_t index, const Segment& segment) {
+                                                      return index < segment.firstRecord;
+                                                  }));
+        auto record = this->storedRecord(segment->firstStored + (index - segment->firstRecord));
+        
+        RecordPrefix prefix;
+        std::memcpy(&prefix, record, sizeof(RecordPrefix));
+        return FeatureRecord{
+                prefix.sequence,
+                prefix.timestamp,
+                static_cast<FrameMarker>(prefix.marker),
+                this->header.encoding,
+                record + sizeof(RecordPrefix),
+                this->header.coefficientCount,
+                segment->scaleOffset == noScales ? nullptr : this->scales.data() + segment->scaleOffset,
+                segment->scaleOffset == noScales ? nullptr : this->scales.data() + segment->scaleOffset + this->header.coefficientCount
+        };
+    }
+    
+    FeatureRecord FeatureReader::at(std::size_t index) const
+    {
+        if (index >= this->recordCount)
+            throw std::out_of_range("FeatureReader error: Record " + std::to_string(index) + " of "
+                                    + std::to_string(this->recordCount) + " in " + this->fileName);
+        return (*this)[index];
+    }
+    
+    std::size_t FeatureReader::decode(std::size_t first, std::size_t count, float* output) const
+    {
+        count = first < this->recordCount ? std::min(count, this->recordCount - first) : 0;
+        auto coefficientCount = this->header.coefficientCount;
+        for (std::size_t index = first; index != first + count; ++index, output += coefficientCount) {
+            auto record = (*this)[index];
+            if (record.isMarker())
+                std::fill(output, output + coefficientCount, 0.0f);
+            else
+                record.decode(output);
+        }
+        return count;
+    }
+}
@@ -0,0 +1,224 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../../include/features/FeatureWriter.h"
+
+namespace Dicta
+{
+    namespace
+    {
+        std::string errorString()
+        { return std::strerror(errno); }
+    }
+    
+    FeatureWriter::FeatureWriter(const std::string& fileName, const FeatureHeader& header, std::size_t bufferedRecords) :
+            FeatureWriter(::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644), true, header, bufferedRecords)
+    {}
+    
+    FeatureWriter::FeatureWriter(int fileDescriptor, const FeatureHeader& header, std::size_t bufferedRecords) :
+            FeatureWriter(fileDescriptor, false, header, bufferedRecords)
+    {}
+    
+    FeatureWriter::FeatureWriter(int fileDescriptor,
+                                 bool ownsDescriptor,
+                                 const FeatureHeader& header,
+                                 std::size_t bufferedRecords) :
+            fileDescriptor(fileDescriptor),
+            ownsDescriptor(ownsDescriptor),
+            header(header),
+            bufferedRecords(std::max<std::size_t>(bufferedRecords, 1)),
+            payloadSize(header.coefficientCount * bytesPerCoefficient(header.encoding))
+    {
+        if (this->fileDescriptor < 0)
+            throw std::runtime_error("FeatureWriter error: Couldn't open output: " + errorString());
+        
+        try {
+            this->header.validate();
+            
+            this->pendingFrames.reserve(this->bufferedRecords);
+            this->pendingPrefixes.reserve(this->bufferedRecords);
+            if (this->header.encoding == FeatureEncoding::Int8) {
+                this->scaleRecords = scaleRecordCount(this->header.coefficientCount);
+                this->minima.resize(this->header.coefficientCount);
+                this->maxima.resize(this->header.coefficientCount);
+                this->exponents.resize(this->header.coefficientCount);
+                this->offsets.resize(this->header.coefficientCount);
+                this->inverseScales.resize(this->header.coefficientCount);
+            }
+            if (this->header.encoding == FeatureEncoding::Float32)
+                this->iovecs.reserve(this->bufferedRecords * 3);
+            else
+                this->encodedRecords.reserve((this->bufferedRecords + this->scaleRecords) * this->header.recordSize);
+            this->zeros.resize(this->header.recordSize - sizeof(RecordPrefix));
+            
+            iovec headerVector{&this->header, sizeof(FeatureHeader)};
+            this->writeAll(&headerVector, 1);
+        }
+        catch (...) {
+            if (this->ownsDescriptor)
+                ::close(this->fileDescriptor);
+            throw;
+        }
+    }
+    
+    FeatureWriter::~FeatureWriter()
+    {
+        try {
+            this->flush();
+        }
+        catch (...) {}
+        
+        if (this->ownsDescriptor)
+            ::close(this->fileDescriptor);
+    }
+    
+    void FeatureWriter::write(Frame<float> frame)
+    {
+        if (!frame.isMarker() && frame.size() != this->header.coefficientCount)
+            throw std::invalid_argument("FeatureWriter error: Frame of " + std::to_string(frame.size())
+                                        + " coefficients on a stream of " + std::to_string(this->header.coefficientCount));
+        
+        // Int8 segments hold a single utterance, from its start marker to its end marker
+        bool segmented = this->header.encoding == FeatureEncoding::Int8;
+        if (segmented && frame.getMarker() == FrameMarker::UtteranceStart)
+            this->flush();
+        bool endsSegment = segmented && frame.isMarker() && frame.getMarker() != FrameMarker::UtteranceStart;
+        
+        this->pendingPrefixes.push_back(RecordPrefix{
+                frame.getSequence(),
+                frame.getTimestamp(),
+                static_cast<std::uint32_t>(frame.getMarker()),
+                0
+        });
+        this->pendingFrames.push_back(std::move(frame));
+        
+        if (this->pendingFrames.size() == this->bufferedRecords || endsSegment)
+            this->flush();
+    }
+    
+    void FeatureWriter::flush()
+    {
+        if (this->pendingFrames.empty())
+            return;
+        
+        if (this->header.encoding == FeatureEncoding::Float32)
+            this->writeFrames();
+        else
+            this->writeEncodedFrames();
+        
+        this->recordsWritten += this->pendingFrames.size();
+        this->pendingFrames.clear();
+        this->pendingPrefixes.clear();
+    }
+    
+    void FeatureWriter::writeFrames()
+    {
+        // Prefix, coefficients straight from the frame, padding: no record is ever copied into a buffer
+        auto paddingSize = this->zeros.size() - this->payloadSize;
+        this->iovecs.clear();
+        for (std::size_t record = 0; record != this->pendingFrames.size(); ++record) {
+            auto& frame = this->pendingFrames[record];
+            this->iovecs.push_back({&this->pendingPrefixes[record], sizeof(RecordPrefix)});
+            
+            if (frame.isMarker())
+                this->iovecs.push_back({this->zeros.data(), this->zeros.size()});
+            else {
+                this->iovecs.push_back({frame.data(), this->payloadSize});
+                if (paddingSize)
+                    this->iovecs.push_back({this->zeros.data(), paddingSize});
+            }
+        }
+        
+        for (std::size_t first = 0; first < this->iovecs.size(); first += IOV_MAX)
+            this->writeAll(this->iovecs.data() + first, std::min<std::size_t>(IOV_MAX, this->iovecs.size() - first));
+    }
+    
+    void FeatureWriter::writeEncodedFrames()
+    {
+        auto recordSize = this->header.recordSize;
+        auto dataRecords = std::count_if(this->pendingFrames.begin(), this->pendingFrames.end(),
+                                         [](const Frame<float>& frame) { return !frame.isMarker(); });
+        // A segment of markers only needs no scales
+        auto scaleRecords = dataRecords ? this->scaleRecords : 0;
+        
+        // Padding and marker coefficients stay zeroed
+        this->encodedRecords.assign((this->pendingFrames.size() + scaleRecords) * recordSize, 0);
+        auto output = this->encodedRecords.data();
+        if (scaleRecords) {
+            this->encodeScales(output);
+            output += scaleRecords * recordSize;
+        }
+        
+        for (std::size_t record = 0; record != this->pendingFrames.size(); ++record, output += recordSize) {
+            std::memcpy(output, &this->pendingPrefixes[record], sizeof(RecordPrefix));
+            auto& frame = this->pendingFrames[record];
+            if (!frame.isMarker())
+                encodeCoefficients(this->header.encoding, frame.data(), this->header.coefficientCount,
+                                   this->offsets.data(), this->inverseScales.data(), output + sizeof(RecordPrefix));
+        }
+        
+        iovec vector{this->encodedRecords.data(), this->encodedRecords.size()};
+        this->writeAll(&vector, 1);
+    }
+    
+    void FeatureWriter::encodeScales(std::uint8_t* output)
+    {
+        std::fill(this->minima.begin(), this->minima.end(), std::numeric_limits<float>::infinity());
+        std::fill(this->maxima.begin(), this->maxima.end(), -std::numeric_limits<float>::infinity());
+        for (auto& frame : this->pendingFrames)
+            if (!frame.isMarker())
+                for (std::size_t pos = 0; pos != this->minima.size(); ++pos) {
+                    this->minima[pos] = std::min(this->minima[pos], frame[pos]);
+                    this->maxima[pos] = std::max(this->maxima[pos], frame[pos]);
+                }
+        
+        // Centered on the range, the int8 steps only have to cover half of it either way
+        for (std::size_t pos = 0; pos != this->minima.size(); ++pos) {
+            this->offsets[pos] = this->minima[pos] / 2 + this->maxima[pos] / 2;
+            this->exponents[pos] = scaleExponent(std::max(this->maxima[pos] - this->offsets[pos],
+                                                          this->offsets[pos] - this->minima[pos]));
+            this->inverseScales[pos] = 1 / scaleOf(this->exponents[pos]);
+        }
+        
+        encodeScaleRecords(this->exponents.data(), this->offsets.data(), this->exponents.size(), output);
+    }
+    
+    void FeatureWriter::writeAll(iovec* vectors, std::size_t count)
+    {
+        while (count) {
+            auto written = ::writev(this->fileDescriptor, vectors, static_cast<int>(count));
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("FeatureWriter error: Couldn't write features: " + errorString());
+            }
+            
+            // Skip what went out, resuming mid vector after a short write
+            auto remaining = static_cast<std::size_t>(written);
+            while (count && remaining >= vectors->iov_len) {
+                remaining -= vectors->iov_len;
+                ++vectors;
+                --count;
+            }
+            if (count) {
+                vectors->iov_base = static_cast<char*>(vectors->iov_base) + remaining;
+                vectors->iov_len -= remaining;
+            }
+        }
+    }
+}
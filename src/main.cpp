@@ -7,27 +7,271 @@
 \*************************************************************/
 
 #include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#ifdef DICTA_WITH_SOUNDIO
 #include "../include/audio/AudioHandler.h"
+#endif
+#include "../include/audio/FileAudioSource.h"
+#include "../include/audio/Resampler.h"
+#include "../include/features/FeatureReader.h"
+#include "../include/features/FeatureWriter.h"
 #include "../include/preprocessor/PreProcessor.h"
+#include "../include/preprocessor/StreamManager.h"
+#include "../include/util/Stats.h"
+
+Dicta::SampleFormat parseSampleFormat(const std::string& name)
+{
+    if (name == "u8") return Dicta::SampleFormat::Unsigned8;
+    if (name == "s16") return Dicta::SampleFormat::Signed16;
+    if (name == "s24") return Dicta::SampleFormat::Signed24;
+    if (name == "s32") return Dicta::SampleFormat::Signed32;
+    if (name == "f32") return Dicta::SampleFormat::Float32;
+    throw std::invalid_argument("Unknown sample format: " + name);
+}
+
+Dicta::FeatureEncoding parseFeatureEncoding(const std::string& name)
+{
+    if (name == "f32") return Dicta::FeatureEncoding::Float32;
+    if (name == "f16") return Dicta::FeatureEncoding::Float16;
+    if (name == "i8") return Dicta::FeatureEncoding::Int8;
+    throw std::invalid_argument("Unknown feature encoding: " + name);
+}
+
+void printUsage(const std::string& programName)
+{
+    std::cerr << "Usage: " << programName << " [-o file.features] [-e f32|f16|i8] [-r sampleRate] [-l milliseconds | file.wav | file.raw sampleRate channels u8|s16|s24|s32|f32]"
+              << "\n       " << programName << " --streams file.wav..."
+              << "\n       " << programName << " --read file.features" << std::endl;
+}
+
+constexpr std::size_t offlineBatchSize = 32;
+constexpr std::size_t lowLatencyOutputCapacity = 32;
+
+// Featurizes every channel of every file as a stream of its own, on one worker per core.
+// Lines are prefixed with the stream index, streams numbered in file and channel order.
+int featurizeStreams(int fileCount, char** fileNames)
+{
+    std::mutex outputMutex;
+    std::vector<std::size_t> frameCounts;
+    std::unique_ptr<Dicta::StreamManager> streamManager;
+    
+    // Every file is opened and checked before any stream starts
+    try {
+        for (int file = 0; file != fileCount; ++file) {
+            auto channelCount = Dicta::FileAudioSource(fileNames[file]).getChannelCount();
+            for (int channel = 0; channel != channelCount; ++channel) {
+                auto source = std::make_unique<Dicta::FileAudioSource>(fileNames[file]);
+                source->selectChannel(channel);
+                
+                if (!streamManager)
+                    streamManager = std::make_unique<Dicta::StreamManager>(
+                            source->getSampleRate(),
+                            std::thread::hardware_concurrency(),
+                            [&](std::size_t stream, Dicta::Frame<float> frame) {
+                                if (frame.isMarker())
+                                    return;
+                                
+                                std::lock_guard<std::mutex> lock(outputMutex);
+                                for (std::size_t pos = 0; pos != frame.size(); ++pos)
+                                    std::cout << stream << " " << pos << " " << frame[pos] << "\n";
+                                std::cout << "\n";
+                                ++frameCounts[stream];
+                            }
+                    );
+                
+                auto stream = streamManager->addStream(std::move(source));
+                std::cerr << "Stream " << stream << ": " << fileNames[file] << " channel " << channel << std::endl;
+                frameCounts.push_back(0);
+            }
+        }
+    }
+    catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    
+    streamManager->start();
+    streamManager->wait();
+    
+    for (std::size_t stream = 0; stream != frameCounts.size(); ++stream)
+        std::cerr << "Stream " << stream << ": " << frameCounts[stream] << " frames" << std::endl;
+    std::cerr << Dicta::Stats::global().snapshot();
+    
+    return 0;
+}
+
+// Prints a binary feature stream the way report() prints frames, header and timestamps on stderr
+int readFeatures(const std::string& fileName)
+{
+    std::unique_ptr<Dicta::FeatureReader> featureReader;
+    try {
+        featureReader = std::make_unique<Dicta::FeatureReader>(fileName);
+    }
+    catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    
+    auto& reader = *featureReader;
+    const auto& header = reader.getHeader();
+    std::cerr << fileName << ": " << reader.size() << " records of " << header.coefficientCount << " coefficients, "
+              << header.sampleRate << "Hz, " << header.frameLength << " samples frames every " << header.hopLength
+              << " samples" << std::endl;
+    
+    std::vector<float> coefficients(header.coefficientCount);
+    for (std::size_t index = 0; index != reader.size(); ++index) {
+        auto record = reader[index];
+        if (record.isMarker()) {
+            if (record.marker != Dicta::FrameMarker::StreamEnd)
+                std::cout << (record.marker == Dicta::FrameMarker::UtteranceStart ? "# utterance start" : "# utterance end")
+                          << "\n\n";
+            continue;
+        }
+        
+        record.decode(coefficients.data());
+        for (std::size_t pos = 0; pos != coefficients.size(); ++pos)
+            std::cout << pos << " " << coefficients[pos] << "\n";
+        std::cout << "\n";
+    }
+    
+    return 0;
+}
 
 int main(int argc, char** argv)
 {
-    Dicta::AudioHandler audioHandler{};
+    std::unique_ptr<Dicta::AudioSource> audioSource;
+    Dicta::ExecutionOptions executionOptions;
+    std::string programName = argv[0];
+    
+    // No arguments: capture from the default input device
+    // One argument: featurize a WAV file
+    // Four arguments: featurize a raw PCM file with the given sample rate, channel count and format
+    // --streams and WAV files: featurize every channel of every file at once
+    // --read and a feature file: print a binary feature stream as text
+    // Any of the first three after -o file: write a binary feature stream instead of text, - being stdout
+    // Any of the first three after -e f32|f16|i8: the binary feature stream's encoding, f32 by default
+    // Any of the first three after -r rate: resample the audio to rate before featurizing it
+    // No arguments after -l milliseconds: capture in low latency mode, the device calling back that often
+    if (argc > 2 && std::string(argv[1]) == "--streams")
+        return featurizeStreams(argc - 2, argv + 2);
+    
+    if (argc == 3 && std::string(argv[1]) == "--read")
+        return readFeatures(argv[2]);
     
-    Dicta::PreProcessor preProcessor(audioHandler.getSampleRate());
+    std::string outputName;
+    auto outputEncoding = Dicta::FeatureEncoding::Float32;
+    int resampleRate = 0;
+    double latencyMilliseconds = 0;
+    try {
+        while (argc > 2 && (std::string(argv[1]) == "-o" || std::string(argv[1]) == "-e"
+                            || std::string(argv[1]) == "-r" || std::string(argv[1]) == "-l")) {
+            if (std::string(argv[1]) == "-o")
+                outputName = argv[2];
+            else if (std::string(argv[1]) == "-e")
+                outputEncoding = parseFeatureEncoding(argv[2]);
+            else if (std::string(argv[1]) == "-r")
+                resampleRate = std::stoi(argv[2]);
+            else
+                latencyMilliseconds = std::stod(argv[2]);
+            argc -= 2;
+            argv += 2;
+        }
+        
+        if (argc == 1) {
+#ifdef DICTA_WITH_SOUNDIO
+            audioSource = std::make_unique<Dicta::AudioHandler>(
+                    latencyMilliseconds > 0 ? Dicta::DeviceOptions::lowLatency(latencyMilliseconds / 1000) : Dicta::DeviceOptions{}
+            );
+#else
+            std::cerr << programName << " was built without libsoundio, it can only featurize files" << std::endl;
+            return 1;
+#endif
+        }
+        else if (argc == 2)
+            audioSource = std::make_unique<Dicta::FileAudioSource>(argv[1]);
+        else if (argc == 5)
+            audioSource = std::make_unique<Dicta::FileAudioSource>(
+                    argv[1],
+                    Dicta::RawAudioFormat{std::stoi(argv[2]), std::stoi(argv[3]), parseSampleFormat(argv[4])}
+            );
+        else {
+            printUsage(programName);
+            return 1;
+        }
+        
+        // Features tuned at one rate stay comparable across devices, and a lower rate is cheaper to featurize
+        if (resampleRate && resampleRate != audioSource->getSampleRate())
+            audioSource = std::make_unique<Dicta::ResamplingAudioSource>(std::move(audioSource), resampleRate);
+    }
+    catch (const std::exception& exception) {
+        std::cerr << programName << ": " << exception.what() << std::endl;
+        return 1;
+    }
     
-    audioHandler.startInputStream();
+    // Latency doesn't matter for files, so transform many frames at once on every core,
+    // while a live device can't wait for a slow consumer and drops its oldest frames instead
+    if (argc > 1) {
+        executionOptions.batchSize = offlineBatchSize;
+        executionOptions.workerCount = std::thread::hardware_concurrency();
+    }
+    else {
+        executionOptions.overflowPolicy = Dicta::OverflowPolicy::DropOldest;
+        // Live capture is mostly silence, only speech goes through the spectral chain
+        executionOptions.voiceActivity.enabled = true;
+        // A consumer falling behind loses frames instead of reading stale ones
+        if (latencyMilliseconds > 0)
+            executionOptions.outputCapacity = lowLatencyOutputCapacity;
+    }
+    
+    Dicta::PreProcessor preProcessor(audioSource->getSampleRate(), {}, executionOptions);
+    
+    // Opened before capture and framing start, so a bad output fails right away with nothing left running
+    std::unique_ptr<Dicta::FeatureWriter> writer;
+    if (!outputName.empty()) {
+        try {
+            auto header = preProcessor.makeFeatureHeader(outputEncoding);
+            writer = outputName == "-"
+                     ? std::make_unique<Dicta::FeatureWriter>(STDOUT_FILENO, header)
+                     : std::make_unique<Dicta::FeatureWriter>(outputName, header);
+        }
+        catch (const std::exception& exception) {
+            std::cerr << programName << ": " << exception.what() << std::endl;
+            return 1;
+        }
+    }
+    
+    audioSource->start();
     
     auto future = std::async(
             std::launch::async,
             Dicta::PreProcessor::readFrameAndWindowRecordingBuffer,
-            audioHandler.getCircularBuffer(),
+            audioSource.get(),
             &preProcessor
     );
     
-    std::cerr << audioHandler << std::endl;
+    std::cerr << *audioSource << std::endl;
+    
+    // A live device runs until killed, so its stats are dumped periodically
+    std::unique_ptr<Dicta::StatsDumper> statsDumper;
+    if (argc == 1)
+        statsDumper = std::make_unique<Dicta::StatsDumper>(std::cerr, std::chrono::seconds(10));
+    
+    if (writer)
+        preProcessor.record(*writer);
+    else
+        preProcessor.report();
+    
+    future.get();
+    
+    std::cerr << Dicta::Stats::global().snapshot();
     
-    preProcessor.report();
+    // Stays flat once the frame pools are warm, no matter how much audio went through
+    std::cerr << "Frame buffers allocated: " << Dicta::Frame<float>::getAllocationCount() << std::endl;
     
     return 0;
-}
\ No newline at end of file
+}
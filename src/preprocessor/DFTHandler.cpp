@@ -6,139 +6,206 @@
 |-------------------------------------------------------------|
 \*************************************************************/
 
+#include <algorithm>
+#include <stdexcept>
 #include "../../include/preprocessor/DFTHandler.h"
 
 namespace Dicta
 {
-    // Float version constructor
-    DFTHandler::DFTHandler(std::size_t fftSize, std::size_t dctSize, float) :
+    template <class T>
+    DFTHandler<T>::DFTHandler(std::size_t fftSize, std::size_t dctSize, std::size_t batchSize, const PlannerOptions& plannerOptions) :
             fftSize(fftSize),
             dctSize(dctSize),
             outputSize(fftSize / 2 + 1),
-            fftFloatInput(fftwf_alloc_real(fftSize)),
-            fftFloatOutput(fftwf_alloc_complex(fftSize / 2 + 1)),
-            dctFloatInput(fftwf_alloc_real(dctSize)),
-            dctFloatOutput(fftwf_alloc_real(dctSize))
+            batchSize(std::max<std::size_t>(batchSize, 1)),
+            fftInput(FFTW<T>::allocReal(fftSize)),
+            fftOutput(FFTW<T>::allocComplex(fftSize / 2 + 1)),
+            dctInput(FFTW<T>::allocReal(dctSize)),
+            dctOutput(FFTW<T>::allocReal(dctSize)),
+            spectrumPool(FramePool<T>::create(fftSize / 2 + 1)),
+            coefficientsPool(FramePool<T>::create(dctSize / 2))
     {
-        fftw_import_wisdom_from_filename(this->wisdomFloatFileName.c_str());
+        if (!this->fftInput || !this->fftOutput || !this->dctInput || !this->dctOutput)
+            throw std::runtime_error("FFTW3 error: Couldn't allocate buffers for FFT or DCT");
         
-        this->fftFloatPlan = fftwf_plan_dft_r2c_1d(fftSize, fftFloatInput, fftFloatOutput, FFTW_PATIENT | FFTW_DESTROY_INPUT);
-        this->dctFloatPlan = fftwf_plan_r2r_1d(dctSize, dctFloatInput, dctFloatOutput, FFTW_REDFT10, FFTW_PATIENT | FFTW_DESTROY_INPUT);
+        FFTWisdom wisdom(plannerOptions, fftSize, dctSize, this->batchSize, T{});
+        std::lock_guard<std::mutex> plannerLock(FFTWisdom::plannerMutex());
+        bool cached = wisdom.load();
+        unsigned flags = wisdom.planFlags() | FFTW_DESTROY_INPUT;
         
-        if (fftFloatPlan == NULL || dctFloatPlan == NULL)
+        this->fftPlan.reset(FFTW<T>::planFFT(fftSize, this->fftInput.get(), this->fftOutput.get(), flags));
+        this->dctPlan.reset(FFTW<T>::planDCT(dctSize, this->dctInput.get(), this->dctOutput.get(), flags));
+        
+        if (!this->fftPlan || !this->dctPlan)
             throw std::runtime_error("FFTW3 error: Couldn't make plans for FFT or DCT");
         
-        if (!fftw_export_wisdom_to_filename(this->wisdomFloatFileName.c_str()))
-            throw std::runtime_error("FFTW3 error: Couldn't save wisdom to file");
+        if (this->batchSize > 1) {
+            int howMany = static_cast<int>(this->batchSize);
+            
+            this->fftBatchInput.reset(FFTW<T>::allocReal(this->batchSize * fftSize));
+            this->fftBatchOutput.reset(FFTW<T>::allocComplex(this->batchSize * this->outputSize));
+            this->dctBatchInput.reset(FFTW<T>::allocReal(this->batchSize * dctSize));
+            this->dctBatchOutput.reset(FFTW<T>::allocReal(this->batchSize * dctSize));
+            
+            if (!this->fftBatchInput || !this->fftBatchOutput || !this->dctBatchInput || !this->dctBatchOutput)
+                throw std::runtime_error("FFTW3 error: Couldn't allocate batch buffers for FFT or DCT");
+            
+            this->fftBatchPlan.reset(FFTW<T>::planFFTMany(fftSize, howMany,
+                                                          this->fftBatchInput.get(), this->fftBatchOutput.get(),
+                                                          static_cast<int>(this->outputSize), flags));
+            this->dctBatchPlan.reset(FFTW<T>::planDCTMany(dctSize, howMany,
+                                                          this->dctBatchInput.get(), this->dctBatchOutput.get(),
+                                                          flags));
+            
+            if (!this->fftBatchPlan || !this->dctBatchPlan)
+                throw std::runtime_error("FFTW3 error: Couldn't make batch plans for FFT or DCT");
+        }
+        
+        // A cache that can't be written only costs planning time on the next start
+        if (!cached)
+            wisdom.save();
     }
     
-    // Double version constructor
-    DFTHandler::DFTHandler(std::size_t fftSize, std::size_t dctSize, double) :
-            fftSize(fftSize),
-            dctSize(dctSize),
-            outputSize(fftSize / 2 + 1),
-            fftDoubleInput(fftw_alloc_real(fftSize)),
-            fftDoubleOutput(fftw_alloc_complex(fftSize / 2 + 1)),
-            dctDoubleInput(fftw_alloc_real(dctSize)),
-            dctDoubleOutput(fftw_alloc_real(dctSize))
+    template <class T>
+    Frame<T> DFTHandler<T>::processFFT(const Frame<T>& input)
     {
-        fftw_import_wisdom_from_filename(this->wisdomDoubleFileName.c_str());
-        
-        this->fftDoublePlan = fftw_plan_dft_r2c_1d(fftSize, fftDoubleInput, fftDoubleOutput, FFTW_PATIENT | FFTW_DESTROY_INPUT);
-        this->dctDoublePlan = fftw_plan_r2r_1d(dctSize, dctDoubleInput, dctDoubleOutput, FFTW_REDFT10, FFTW_PATIENT | FFTW_DESTROY_INPUT);
-        
-        if (fftDoublePlan == NULL || dctDoublePlan == NULL)
-            throw std::runtime_error("FFTW3 error: Couldn't make plans for FFT or DCT");
-        
-        if (!fftw_export_wisdom_to_filename(this->wisdomDoubleFileName.c_str()))
-            throw std::runtime_error("FFTW3 error: Couldn't save wisdom to file");
+        return this->processFFT(input.data());
     }
     
-    DFTHandler::~DFTHandler()
+    // FFT over fftSize contiguous samples
+    template <class T>
+    Frame<T> DFTHandler<T>::processFFT(const T* input)
     {
-        if (!this->fftFloatInput) fftwf_free(this->fftFloatInput);
-        if (!this->fftFloatOutput) fftwf_free(this->fftFloatOutput);
-        if (!this->dctFloatInput) fftwf_free(this->dctFloatInput);
-        if (!this->dctFloatOutput) fftwf_free(this->dctFloatOutput);
-        if (!this->fftFloatPlan) fftwf_destroy_plan(this->fftFloatPlan);
-        if (!this->dctFloatPlan) fftwf_destroy_plan(this->dctFloatPlan);
-        
-        if (!this->fftDoubleInput) fftw_free(this->fftDoubleInput);
-        if (!this->fftDoubleOutput) fftw_free(this->fftDoubleOutput);
-        if (!this->dctDoubleInput) fftw_free(this->dctDoubleInput);
-        if (!this->dctDoubleOutput) fftw_free(this->dctDoubleOutput);
-        if (!this->fftDoublePlan) fftw_destroy_plan(this->fftDoublePlan);
-        if (!this->dctDoublePlan) fftw_destroy_plan(this->dctDoublePlan);
+        // Frames written in place on the input buffer don't need to be copied
+        return this->magnitudeSpectrum(this->executeFFT(input), *this->spectrumPool);
     }
     
-    // Float version FFT
-    Frame<float> DFTHandler::processFFT(const Frame<float>& input)
+    template <class T>
+    auto DFTHandler<T>::executeFFT(const T* input) -> const Complex*
     {
-        for (auto pos = 0; pos != this->fftSize; ++pos)
-            this->fftFloatInput[pos] = input[pos];
+        if (input != this->fftInput.get())
+            std::copy_n(input, this->fftSize, this->fftInput.get());
         
-        fftwf_execute(this->fftFloatPlan);
+        FFTW<T>::execute(this->fftPlan.get());
         
-        Frame<float> frame(this->outputSize);
-        float real = 0;
-        float imaginary = 0;
+        return this->fftOutput.get();
+    }
+    
+    template <class T>
+    auto DFTHandler<T>::executeFFTBatch() -> const Complex*
+    {
+        if (!this->fftBatchPlan)
+            throw std::logic_error("FFTW3 error: No batch plan, the handler was made with a batchSize of 1");
         
-        for (auto pos = 0; pos != this->outputSize; ++pos) {
-            real = this->fftFloatOutput[pos][0];
-            imaginary = this->fftFloatOutput[pos][1];
-            frame.push(std::sqrt((real * real) + (imaginary * imaginary)));
-        }
+        FFTW<T>::execute(this->fftBatchPlan.get());
         
-        return frame;
+        return this->fftBatchOutput.get();
     }
     
-    // Float version DCT
-    Frame<float> DFTHandler::processDCT(const Frame<float>& input)
+    template <class T>
+    Frame<T> DFTHandler<T>::processDCT(const Frame<T>& input)
     {
-        for (auto pos = 0; pos != this->dctSize; ++pos)
-            this->dctFloatInput[pos] = input[pos];
-        
-        fftwf_execute(this->dctFloatPlan);
+        std::copy_n(input.data(), this->dctSize, this->dctInput.get());
         
-        Frame<float> frame(this->dctSize / 2);
-        for (auto pos = 0; pos != this->dctSize / 2; ++pos)
-            frame.push(this->dctFloatOutput[pos]);
+        FFTW<T>::execute(this->dctPlan.get());
         
-        return frame;
+        return this->firstHalf(this->dctOutput.get(), *this->coefficientsPool);
     }
     
-    // Double version FFT
-    Frame<double> DFTHandler::processFFT(const Frame<double>& input)
+    template <class T>
+    void DFTHandler<T>::processFFTBatch(const T* frames, std::size_t frameCount, T* spectra)
     {
-        for (auto pos = 0; pos != this->fftSize; ++pos)
-            this->fftDoubleInput[pos] = input[pos];
-        
-        fftw_execute(this->fftDoublePlan);
+        // Without batch plans fall back to one transform per frame
+        if (!this->fftBatchPlan) {
+            for (std::size_t frame = 0; frame != frameCount; ++frame) {
+                std::copy_n(frames + frame * this->fftSize, this->fftSize, this->fftInput.get());
+                FFTW<T>::execute(this->fftPlan.get());
+                this->magnitudeSpectrum(this->fftOutput.get(), spectra + frame * this->outputSize);
+            }
+            return;
+        }
         
-        Frame<double> frame(this->outputSize);
-        double real = 0;
-        double imaginary = 0;
+        for (std::size_t first = 0; first < frameCount; first += this->batchSize) {
+            auto chunkSize = std::min(this->batchSize, frameCount - first);
+            auto chunk = frames + first * this->fftSize;
+            
+            // Frames written in place on the batch input buffer don't need to be copied
+            if (chunk != this->fftBatchInput.get())
+                std::copy_n(chunk, chunkSize * this->fftSize, this->fftBatchInput.get());
+            
+            FFTW<T>::execute(this->fftBatchPlan.get());
+            
+            for (std::size_t frame = 0; frame != chunkSize; ++frame)
+                this->magnitudeSpectrum(this->fftBatchOutput.get() + frame * this->outputSize,
+                                        spectra + (first + frame) * this->outputSize);
+        }
+    }
+    
+    template <class T>
+    void DFTHandler<T>::processDCTBatch(const T* frames, std::size_t frameCount, T* coefficients)
+    {
+        // Without batch plans fall back to one transform per frame
+        if (!this->dctBatchPlan) {
+            for (std::size_t frame = 0; frame != frameCount; ++frame) {
+                std::copy_n(frames + frame * this->dctSize, this->dctSize, this->dctInput.get());
+                FFTW<T>::execute(this->dctPlan.get());
+                this->firstHalf(this->dctOutput.get(), coefficients + frame * this->dctSize / 2);
+            }
+            return;
+        }
         
-        for (auto pos = 0; pos != this->outputSize; ++pos) {
-            real = this->fftDoubleOutput[pos][0];
-            imaginary = this->fftDoubleOutput[pos][1];
-            frame.push(std::sqrt((real * real) + (imaginary * imaginary)));
+        for (std::size_t first = 0; first < frameCount; first += this->batchSize) {
+            auto chunkSize = std::min(this->batchSize, frameCount - first);
+            auto chunk = frames + first * this->dctSize;
+            
+            if (chunk != this->dctBatchInput.get())
+                std::copy_n(chunk, chunkSize * this->dctSize, this->dctBatchInput.get());
+            
+            FFTW<T>::execute(this->dctBatchPlan.get());
+            
+            for (std::size_t frame = 0; frame != chunkSize; ++frame)
+                this->firstHalf(this->dctBatchOutput.get() + frame * this->dctSize,
+                                coefficients + (first + frame) * this->dctSize / 2);
         }
-        return frame;
     }
     
-    // Double version DCT
-    Frame<double> DFTHandler::processDCT(const Frame<double>& input)
+    template <class T>
+    void DFTHandler<T>::magnitudeSpectrum(const Complex* spectrum, T* output) const
     {
-        for (auto pos = 0; pos != this->dctSize; ++pos)
-            this->dctDoubleInput[pos] = input[pos];
+        T real = 0;
+        T imaginary = 0;
         
-        fftw_execute(this->dctDoublePlan);
+        for (std::size_t pos = 0; pos != this->outputSize; ++pos) {
+            real = spectrum[pos][0];
+            imaginary = spectrum[pos][1];
+            output[pos] = std::sqrt((real * real) + (imaginary * imaginary));
+        }
+    }
+    
+    template <class T>
+    Frame<T> DFTHandler<T>::magnitudeSpectrum(const Complex* spectrum, FramePool<T>& pool) const
+    {
+        auto frame = pool.acquire();
+        this->magnitudeSpectrum(spectrum, frame.data());
+        frame.commit(this->outputSize);
         
-        Frame<double> frame(this->dctSize / 2);
-        for (auto pos = 0; pos != this->dctSize / 2; ++pos)
-            frame.push(this->dctDoubleOutput[pos]);
+        return frame;
+    }
+    
+    template <class T>
+    void DFTHandler<T>::firstHalf(const T* coefficients, T* output) const
+    { std::copy_n(coefficients, this->dctSize / 2, output); }
+    
+    template <class T>
+    Frame<T> DFTHandler<T>::firstHalf(const T* coefficients, FramePool<T>& pool) const
+    {
+        auto frame = pool.acquire();
+        this->firstHalf(coefficients, frame.data());
+        frame.commit(this->dctSize / 2);
         
         return frame;
     }
-}
\ No newline at end of file
+    
+    template class DFTHandler<float>;
+    template class DFTHandler<double>;
+}
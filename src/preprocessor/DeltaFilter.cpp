@@ -0,0 +1,62 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <stdexcept>
+#include "../../include/preprocessor/DeltaFilter.h"
+
+namespace Dicta
+{
+    DeltaFilter::DeltaFilter(std::size_t coefficientCount, std::size_t width) :
+            coefficientCount(coefficientCount),
+            width(width),
+            ringSize(2 * width + 1),
+            statics(ringSize * coefficientCount),
+            deltas(ringSize * coefficientCount),
+            timestamps(ringSize),
+            captureTimes(ringSize),
+            outputPool(FramePool<float>::create(3 * coefficientCount))
+    {
+        if (!coefficientCount || !width)
+            throw std::invalid_argument("DeltaFilter error: Coefficient count and regression width must be positive");
+        
+        float squares = 0;
+        for (std::size_t offset = 1; offset <= width; ++offset)
+            squares += static_cast<float>(offset * offset);
+        this->normalization = 1 / (2 * squares);
+    }
+    
+    void DeltaFilter::regression(float* (DeltaFilter::*frameAt)(std::int64_t),
+                                 std::int64_t index,
+                                 std::int64_t last,
+                                 float* output)
+    {
+        std::fill_n(output, this->coefficientCount, 0.0f);
+        for (std::int64_t offset = 1; offset <= static_cast<std::int64_t>(this->width); ++offset) {
+            const float* after = (this->*frameAt)(std::min(index + offset, last));
+            const float* before = (this->*frameAt)(std::max<std::int64_t>(index - offset, 0));
+            auto weight = static_cast<float>(offset) * this->normalization;
+            for (std::size_t coefficient = 0; coefficient != this->coefficientCount; ++coefficient)
+                output[coefficient] += weight * (after[coefficient] - before[coefficient]);
+        }
+    }
+    
+    Frame<float> DeltaFilter::makeFrame(std::int64_t index, std::int64_t last)
+    {
+        auto frame = this->outputPool->acquire();
+        float* output = frame.data();
+        std::copy_n(this->staticAt(index), this->coefficientCount, output);
+        std::copy_n(this->deltaAt(index), this->coefficientCount, output + this->coefficientCount);
+        this->regression(&DeltaFilter::deltaAt, index, last, output + 2 * this->coefficientCount);
+        
+        frame.commit(this->getOutputSize());
+        frame.setTimestamp(this->timestamps[index % this->ringSize]);
+        frame.setCaptureTime(this->captureTimes[index % this->ringSize]);
+        return frame;
+    }
+}
@@ -0,0 +1,147 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <system_error>
+#include <fftw3.h>
+#include <unistd.h>
+#include "../../include/preprocessor/FFTWisdom.h"
+
+namespace Dicta
+{
+    FFTWisdom::FFTWisdom(const PlannerOptions& options, std::size_t fftSize, std::size_t dctSize, std::size_t batchSize, float) :
+            FFTWisdom(options, fftSize, dctSize, batchSize, false)
+    {}
+    
+    FFTWisdom::FFTWisdom(const PlannerOptions& options, std::size_t fftSize, std::size_t dctSize, std::size_t batchSize, double) :
+            FFTWisdom(options, fftSize, dctSize, batchSize, true)
+    {}
+    
+    FFTWisdom::FFTWisdom(const PlannerOptions& options,
+                         std::size_t fftSize,
+                         std::size_t dctSize,
+                         std::size_t batchSize,
+                         bool doublePrecision) :
+            options(options),
+            doublePrecision(doublePrecision)
+    {
+        // e.g. ~/.cache/dicta/wisdom-float-fft512-dct26-batch32-patient-avx2-fma.fftw
+        this->path = resolveDirectory(options.wisdomDirectory) + "/wisdom-"
+                     + (doublePrecision ? "double" : "float")
+                     + "-fft" + std::to_string(fftSize)
+                     + "-dct" + std::to_string(dctSize)
+                     + "-batch" + std::to_string(batchSize)
+                     + "-" + effortName(options.effort)
+                     + "-" + cpuFeatures()
+                     + ".fftw";
+    }
+    
+    std::string FFTWisdom::resolveDirectory(const std::string& directory)
+    {
+        if (!directory.empty())
+            return directory;
+        
+        if (auto dictaDirectory = std::getenv("DICTA_WISDOM_DIR"))
+            return dictaDirectory;
+        if (auto cacheHome = std::getenv("XDG_CACHE_HOME"))
+            return std::string(cacheHome) + "/dicta";
+        if (auto home = std::getenv("HOME"))
+            return std::string(home) + "/.cache/dicta";
+        
+        return ".";
+    }
+    
+    std::string FFTWisdom::effortName(PlannerEffort effort)
+    {
+        switch (effort) {
+            case PlannerEffort::Estimate:
+                return "estimate";
+            case PlannerEffort::Measure:
+                return "measure";
+            case PlannerEffort::Patient:
+                return "patient";
+            case PlannerEffort::Exhaustive:
+                return "exhaustive";
+        }
+        return "unknown";
+    }
+    
+    unsigned FFTWisdom::planFlags() const
+    {
+        double timeLimit = this->options.timeLimit < 0 ? FFTW_NO_TIMELIMIT : this->options.timeLimit;
+        if (this->doublePrecision)
+            fftw_set_timelimit(timeLimit);
+        else
+            fftwf_set_timelimit(timeLimit);
+        
+        switch (this->options.effort) {
+            case PlannerEffort::Estimate:
+                return FFTW_ESTIMATE;
+            case PlannerEffort::Measure:
+                return FFTW_MEASURE;
+            case PlannerEffort::Patient:
+                return FFTW_PATIENT;
+            case PlannerEffort::Exhaustive:
+                return FFTW_EXHAUSTIVE;
+        }
+        return FFTW_PATIENT;
+    }
+    
+    bool FFTWisdom::load() const
+    {
+        return this->doublePrecision
+               ? fftw_import_wisdom_from_filename(this->path.c_str())
+               : fftwf_import_wisdom_from_filename(this->path.c_str());
+    }
+    
+    bool FFTWisdom::save() const
+    {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(this->path).parent_path(), error);
+        
+        // Written beside the cache and renamed over it, readers see either the old or the new file
+        auto temporaryPath = this->path + ".tmp." + std::to_string(getpid());
+        int exported = this->doublePrecision
+                       ? fftw_export_wisdom_to_filename(temporaryPath.c_str())
+                       : fftwf_export_wisdom_to_filename(temporaryPath.c_str());
+        
+        if (!exported || std::rename(temporaryPath.c_str(), this->path.c_str())) {
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+    
+    std::mutex& FFTWisdom::plannerMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+    
+    std::string FFTWisdom::cpuFeatures()
+    {
+        std::string features;
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx512f"))
+            features += "avx512-";
+        if (__builtin_cpu_supports("avx2"))
+            features += "avx2-";
+        else if (__builtin_cpu_supports("avx"))
+            features += "avx-";
+        else if (__builtin_cpu_supports("sse2"))
+            features += "sse2-";
+        if (__builtin_cpu_supports("fma"))
+            features += "fma-";
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+        features += "neon-";
+#endif
+        return features.empty() ? "generic" : features.substr(0, features.size() - 1);
+    }
+}
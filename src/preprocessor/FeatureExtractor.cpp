@@ -0,0 +1,101 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "../../include/preprocessor/FeatureExtractor.h"
+#include "../../include/util/SIMD.hpp"
+
+namespace Dicta
+{
+    namespace
+    {
+        std::size_t millisecondsToSamples(std::size_t sampleRate, double milliseconds)
+        { return static_cast<std::size_t>(std::lround(sampleRate * milliseconds / 1000)); }
+    }
+    
+    FeatureExtractor::FeatureExtractor(std::size_t sampleRate,
+                                       FramingOptions framingOptions,
+                                       std::size_t deltaWidth,
+                                       const PlannerOptions& plannerOptions) :
+            sampleRate(sampleRate),
+            frameLength(framingOptions.frameMilliseconds
+                        ? millisecondsToSamples(sampleRate, framingOptions.frameMilliseconds)
+                        : nextPowerOf2(sampleRate / 100)),
+            hopLength(framingOptions.hopMilliseconds
+                      ? millisecondsToSamples(sampleRate, framingOptions.hopMilliseconds)
+                      : frameLength / 2),
+            fftSize(nextPowerOf2(frameLength)),
+            window(Framer::makeWindow(frameLength, framingOptions.windowType)),
+            dftHandler(fftSize, filterBankCount, 1, plannerOptions),
+            mfcc(sampleRate, filterBankCount, fftSize, 0, sampleRate / 2),
+            dct(filterBankCount, coefficientCount),
+            coefficientsPool(FramePool<float>::create(coefficientCount)),
+            straddling(frameLength)
+    {
+        if (!sampleRate || !this->frameLength || !this->hopLength)
+            throw std::invalid_argument("FeatureExtractor error: Sample rate, frame and hop lengths must be positive");
+        
+        if (deltaWidth)
+            this->deltaFilter = std::make_unique<DeltaFilter>(coefficientCount, deltaWidth);
+        
+        // Never more than a frame is carried over, reserved now so process() doesn't allocate
+        this->carry.reserve(this->frameLength);
+        this->nextFrameStart = this->firstFrameStart();
+    }
+    
+    Frame<float> FeatureExtractor::transform(const float* frame)
+    {
+        auto fftInput = this->dftHandler.getFFTInput();
+        {
+            StageTimer timer(Stage::Framing);
+            SIMD::clampAndMultiply(frame, this->window->data(), fftInput, this->frameLength);
+            std::fill(fftInput + this->frameLength, fftInput + this->fftSize, 0.0f);
+        }
+        
+        const DFTHandler<float>::Complex* spectrum;
+        {
+            StageTimer timer(Stage::FFT);
+            spectrum = this->dftHandler.executeFFT(fftInput);
+        }
+        
+        float energies[filterBankCount];
+        {
+            StageTimer timer(Stage::Mel);
+            this->mfcc.computeMFCC(spectrum, energies);
+        }
+        
+        auto coefficients = this->coefficientsPool->acquire();
+        {
+            StageTimer timer(Stage::DCT);
+            this->dct.compute(energies, coefficients.data());
+        }
+        coefficients.commit(coefficientCount);
+        coefficients.setTimestamp(static_cast<std::int64_t>(
+                static_cast<double>(this->framesSeen++ * this->hopLength) * 1e9 / this->sampleRate));
+        return coefficients;
+    }
+    
+    void FeatureExtractor::keepTail(const float* samples, std::size_t count)
+    {
+        auto end = this->samplesSeen + count;
+        if (this->nextFrameStart >= end)
+            this->carry.clear();
+        else if (this->nextFrameStart >= this->samplesSeen) {
+            auto first = samples + (this->nextFrameStart - this->samplesSeen);
+            this->carry.assign(first, samples + count);
+        }
+        else {
+            // The next frame still starts on the carry, this span is too short to complete it
+            this->carry.erase(this->carry.begin(), this->carry.end() - (this->samplesSeen - this->nextFrameStart));
+            this->carry.insert(this->carry.end(), samples, samples + count);
+        }
+        this->samplesSeen = end;
+    }
+}
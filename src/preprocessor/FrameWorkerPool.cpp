@@ -0,0 +1,159 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <exception>
+#include "../../include/preprocessor/FrameWorkerPool.h"
+
+namespace Dicta
+{
+    FrameWorkerPool::FrameWorkerPool(std::size_t workerCount,
+                                     std::size_t fftSize,
+                                     const TransformFactory& makeTransform,
+                                     Output output,
+                                     const ThreadOptions& threadOptions) :
+            output(std::move(output)),
+            inputPool(FramePool<float>::create(fftSize)),
+            maxInFlight(4 * std::max<std::size_t>(workerCount, 1)),
+            reorderSlots(maxInFlight),
+            slotReady(maxInFlight, 0)
+    {
+        workerCount = std::max<std::size_t>(workerCount, 1);
+        this->emitting.reserve(this->maxInFlight);
+        
+        // Every worker's transform, FFTW plans included, is made here before any thread starts
+        for (std::size_t worker = 0; worker != workerCount; ++worker)
+            this->transforms.push_back(makeTransform());
+        
+        // Workers apply their thread options first thing, a failure stopping the pool before it's used
+        std::vector<std::future<void>> started;
+        try {
+            for (std::size_t worker = 0; worker != workerCount; ++worker) {
+                std::promise<void> promise;
+                started.push_back(promise.get_future());
+                this->workers.emplace_back(&FrameWorkerPool::work, this, worker, std::cref(threadOptions), std::move(promise));
+            }
+            for (auto& future : started)
+                future.get();
+        }
+        catch (...) {
+            this->stop();
+            throw;
+        }
+    }
+    
+    FrameWorkerPool::~FrameWorkerPool()
+    { this->stop(); }
+    
+    void FrameWorkerPool::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->jobsMutex);
+            this->stopping = true;
+        }
+        this->jobsCondition.notify_all();
+        
+        for (auto& worker : this->workers)
+            worker.join();
+    }
+    
+    void FrameWorkerPool::submit(Frame<float> windowed)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->reorderMutex);
+            this->reorderCondition.wait(lock, [this] {
+                return this->nextSequence - this->nextToEmit < this->maxInFlight;
+            });
+            windowed.setSequence(this->nextSequence++);
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->jobsMutex);
+            this->jobs.push_back(std::move(windowed));
+        }
+        this->jobsCondition.notify_one();
+    }
+    
+    void FrameWorkerPool::flush()
+    {
+        std::unique_lock<std::mutex> lock(this->reorderMutex);
+        this->reorderCondition.wait(lock, [this] { return this->nextToEmit == this->nextSequence; });
+    }
+    
+    void FrameWorkerPool::work(std::size_t worker, const ThreadOptions& threadOptions, std::promise<void> started)
+    {
+        try {
+            threadOptions.apply();
+            started.set_value();
+        }
+        catch (...) {
+            started.set_exception(std::current_exception());
+            return;
+        }
+        
+        auto& transform = this->transforms[worker];
+        
+        while (true) {
+            Frame<float> windowed;
+            {
+                std::unique_lock<std::mutex> lock(this->jobsMutex);
+                this->jobsCondition.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+                if (this->jobs.empty())
+                    return;
+                
+                windowed = std::move(this->jobs.front());
+                this->jobs.pop_front();
+            }
+            
+            auto result = transform(windowed.data());
+            result.setSequence(windowed.getSequence());
+            result.setTimestamp(windowed.getTimestamp());
+            result.setCaptureTime(windowed.getCaptureTime());
+            
+            // Give the input buffer back before waiting on the reorder lock
+            windowed = Frame<float>();
+            
+            this->complete(std::move(result));
+        }
+    }
+    
+    void FrameWorkerPool::complete(Frame<float> result)
+    {
+        std::unique_lock<std::mutex> lock(this->reorderMutex);
+        auto slot = result.getSequence() % this->maxInFlight;
+        this->reorderSlots[slot] = std::move(result);
+        this->slotReady[slot] = 1;
+        
+        // The worker already draining outputs this frame too once its predecessors are in
+        if (this->draining)
+            return;
+        this->draining = true;
+        
+        while (true) {
+            // Take this frame and any successors that finished earlier, strictly in sequence order
+            while (this->slotReady[slot = this->nextToTake % this->maxInFlight]) {
+                this->slotReady[slot] = 0;
+                this->emitting.push_back(std::move(this->reorderSlots[slot]));
+                ++this->nextToTake;
+            }
+            if (this->emitting.empty())
+                break;
+            
+            lock.unlock();
+            for (auto& frame : this->emitting)
+                this->output(std::move(frame));
+            auto emitted = this->emitting.size();
+            this->emitting.clear();
+            lock.lock();
+            
+            this->nextToEmit += emitted;
+            this->reorderCondition.notify_all();
+        }
+        
+        this->draining = false;
+    }
+}
@@ -0,0 +1,101 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "../../include/preprocessor/Framer.h"
+
+namespace Dicta
+{
+    Framer::Framer(std::size_t frameLength, std::size_t hopLength, WindowType windowType, std::size_t paddedLength) :
+            Framer(frameLength, hopLength, makeWindow(frameLength, windowType), paddedLength)
+    {}
+    
+    Framer::Framer(std::size_t frameLength,
+                   std::size_t hopLength,
+                   std::shared_ptr<const std::vector<float>> window,
+                   std::size_t paddedLength) :
+            frameLength(frameLength),
+            hopLength(hopLength),
+            paddedLength(std::max(paddedLength, frameLength)),
+            window(std::move(window)),
+            history(frameLength + historyHops * hopLength)
+    {
+        if (!frameLength || !hopLength)
+            throw std::invalid_argument("Framer error: Frame and hop lengths must be positive");
+        
+        if (!this->window || this->window->size() != frameLength)
+            throw std::invalid_argument("Framer error: Window table doesn't match the frame length");
+    }
+    
+    std::shared_ptr<const std::vector<float>> Framer::makeWindow(std::size_t frameLength, WindowType windowType)
+    {
+        const double pi = std::atan(1) * 4;
+        // Hann keeps the periodic definition used so far, Hamming and Povey follow Kaldi's definitions
+        const double periodicLength = frameLength;
+        const double symmetricLength = std::max<double>(frameLength - 1, 1);
+        
+        auto window = std::make_shared<std::vector<float>>(frameLength);
+        for (std::size_t index = 0; index != frameLength; ++index) {
+            switch (windowType) {
+                case WindowType::Rectangular:
+                    (*window)[index] = 1;
+                    break;
+                case WindowType::Hann:
+                    (*window)[index] = 0.5 * (1 - std::cos((2 * pi * index) / periodicLength));
+                    break;
+                case WindowType::Hamming:
+                    (*window)[index] = 0.54 - 0.46 * std::cos((2 * pi * index) / symmetricLength);
+                    break;
+                case WindowType::Povey:
+                    (*window)[index] = std::pow(0.5 - 0.5 * std::cos((2 * pi * index) / symmetricLength), 0.85);
+                    break;
+            }
+        }
+        return window;
+    }
+    
+    void Framer::setLookbackHops(std::size_t hops)
+    {
+        this->lookbackHops = hops;
+        this->history.resize(this->frameLength + (historyHops + hops) * this->hopLength);
+    }
+    
+    float* Framer::getHopInput()
+    {
+        // Out of room: slide the samples still needed by the next frames back to the beginning
+        if (this->historyEnd + this->hopLength > this->history.size()) {
+            auto keep = std::min(this->historyEnd, this->frameLength + this->lookbackHops * this->hopLength);
+            std::copy(this->history.begin() + (this->historyEnd - keep),
+                      this->history.begin() + this->historyEnd,
+                      this->history.begin());
+            this->historyEnd = keep;
+        }
+        return this->history.data() + this->historyEnd;
+    }
+    
+    bool Framer::commitHop()
+    {
+        this->historyEnd += this->hopLength;
+        this->bufferedSamples = std::min(this->bufferedSamples + this->hopLength, this->frameLength);
+        return this->bufferedSamples == this->frameLength;
+    }
+    
+    void Framer::windowFrame(float* output, std::size_t hopsAgo) const
+    {
+        SIMD::clampAndMultiply(this->latestFrame(hopsAgo), this->window->data(), output, this->frameLength);
+        std::fill(output + this->frameLength, output + this->paddedLength, 0.0f);
+    }
+    
+    void Framer::reset()
+    {
+        this->historyEnd = 0;
+        this->bufferedSamples = 0;
+    }
+}
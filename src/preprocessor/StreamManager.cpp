@@ -0,0 +1,237 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "../../include/preprocessor/StreamManager.h"
+#include "../../include/util/Stats.h"
+
+namespace Dicta
+{
+    namespace
+    {
+        std::size_t millisecondsToSamples(std::size_t sampleRate, double milliseconds)
+        { return static_cast<std::size_t>(std::lround(sampleRate * milliseconds / 1000)); }
+    }
+    
+    StreamManager::StreamManager(std::size_t sampleRate,
+                                 std::size_t workerCount,
+                                 Output output,
+                                 FramingOptions framingOptions,
+                                 const PlannerOptions& plannerOptions,
+                                 const ThreadOptions& workerThreads) :
+            sampleRate(sampleRate),
+            frameLength(framingOptions.frameMilliseconds
+                        ? millisecondsToSamples(sampleRate, framingOptions.frameMilliseconds)
+                        : nextPowerOf2(sampleRate / 100)),
+            hopLength(framingOptions.hopMilliseconds
+                      ? millisecondsToSamples(sampleRate, framingOptions.hopMilliseconds)
+                      : frameLength / 2),
+            fftSize(nextPowerOf2(frameLength)),
+            output(std::move(output)),
+            window(Framer::makeWindow(frameLength, framingOptions.windowType)),
+            mfcc(sampleRate, filterBankCount, fftSize, 0, sampleRate / 2),
+            dct(filterBankCount, coefficientCount),
+            coefficientsPool(FramePool<float>::create(coefficientCount)),
+            workerThreads(workerThreads)
+    {
+        if (!sampleRate || !this->hopLength)
+            throw std::invalid_argument("StreamManager error: Sample rate and hop length must be positive");
+        
+        // Plans come out of the wisdom cache after the first worker, so a big pool starts fast
+        workerCount = std::max<std::size_t>(workerCount, 1);
+        for (std::size_t worker = 0; worker != workerCount; ++worker)
+            this->dftHandlers.push_back(std::make_unique<DFTHandler<float>>(this->fftSize, filterBankCount, 1, plannerOptions));
+    }
+    
+    StreamManager::~StreamManager()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->readyMutex);
+            this->stopping = true;
+        }
+        this->readyCondition.notify_all();
+        
+        for (auto& worker : this->workers)
+            if (worker.joinable())
+                worker.join();
+    }
+    
+    std::size_t StreamManager::addStream(std::unique_ptr<AudioSource> source)
+    {
+        if (!this->workers.empty())
+            throw std::logic_error("StreamManager error: Streams must be added before start()");
+        
+        if (static_cast<std::size_t>(source->getSampleRate()) != this->sampleRate)
+            throw std::invalid_argument("StreamManager error: Source at " + std::to_string(source->getSampleRate())
+                                        + "Hz on a manager at " + std::to_string(this->sampleRate) + "Hz");
+        
+        this->streams.push_back(std::make_unique<Stream>(
+                Stream{std::move(source), Framer(this->frameLength, this->hopLength, this->window, this->fftSize)}
+        ));
+        return this->streams.size() - 1;
+    }
+    
+    void StreamManager::start()
+    {
+        if (!this->workers.empty())
+            throw std::logic_error("StreamManager error: Already started");
+        
+        for (auto& stream : this->streams)
+            stream->source->start();
+        
+        {
+            std::lock_guard<std::mutex> lock(this->readyMutex);
+            for (std::size_t stream = 0; stream != this->streams.size(); ++stream)
+                this->ready.push_back(stream);
+            this->activeStreams = this->streams.size();
+        }
+        
+        for (std::size_t worker = 0; worker != this->dftHandlers.size(); ++worker)
+            this->workers.emplace_back(&StreamManager::work, this, worker);
+    }
+    
+    void StreamManager::wait()
+    {
+        for (auto& worker : this->workers)
+            if (worker.joinable())
+                worker.join();
+        
+        if (this->error)
+            std::rethrow_exception(this->error);
+    }
+    
+    void StreamManager::work(std::size_t worker)
+    {
+        auto& dftHandler = *this->dftHandlers[worker];
+        std::size_t idleTurns = 0;
+        
+        // A worker the options can't be applied to leaves the streams to the others, wait() reporting why
+        try {
+            this->workerThreads.apply();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(this->readyMutex);
+            if (!this->error)
+                this->error = std::current_exception();
+            return;
+        }
+        
+        while (true) {
+            std::size_t streamIndex;
+            {
+                std::unique_lock<std::mutex> lock(this->readyMutex);
+                this->readyCondition.wait(lock, [this] {
+                    return this->stopping || !this->ready.empty() || !this->activeStreams;
+                });
+                if (this->stopping || this->ready.empty())
+                    return;
+                
+                streamIndex = this->ready.front();
+                this->ready.pop_front();
+            }
+            
+            Turn turn;
+            bool failed = false;
+            try {
+                turn = this->runTurn(*this->streams[streamIndex], streamIndex, dftHandler);
+                if (turn == Turn::Ended)
+                    this->output(streamIndex, Frame<float>::makeMarker(FrameMarker::StreamEnd));
+            }
+            catch (...) {
+                // A failing stream ends alone, the others keep going and wait() reports the error
+                std::lock_guard<std::mutex> lock(this->readyMutex);
+                if (!this->error)
+                    this->error = std::current_exception();
+                turn = Turn::Ended;
+                failed = true;
+            }
+            if (failed) {
+                // Still tell the consumer the stream is over, unless the output itself is what failed
+                try {
+                    this->output(streamIndex, Frame<float>::makeMarker(FrameMarker::StreamEnd));
+                }
+                catch (...) {}
+            }
+            
+            bool finished = false;
+            {
+                std::lock_guard<std::mutex> lock(this->readyMutex);
+                if (turn == Turn::Ended)
+                    finished = !--this->activeStreams;
+                else
+                    this->ready.push_back(streamIndex);
+            }
+            if (finished)
+                this->readyCondition.notify_all();
+            else if (turn != Turn::Ended)
+                this->readyCondition.notify_one();
+            
+            // Only live sources run dry, after a whole round of them back off for a fraction of a hop
+            idleTurns = turn == Turn::Idle ? idleTurns + 1 : 0;
+            if (idleTurns >= this->streams.size()) {
+                std::this_thread::sleep_for(std::chrono::microseconds(this->hopLength * 250000 / this->sampleRate));
+                idleTurns = 0;
+            }
+        }
+    }
+    
+    StreamManager::Turn StreamManager::runTurn(Stream& stream, std::size_t streamIndex, DFTHandler<float>& dftHandler)
+    {
+        auto& stats = Stats::global();
+        
+        for (std::size_t hop = 0; hop != hopsPerTurn; ++hop) {
+            if (stream.source->availableSamples() < this->hopLength)
+                return hop ? Turn::Progress : Turn::Idle;
+            
+            if (stream.source->read(stream.framer.getHopInput(), this->hopLength) != this->hopLength)
+                return Turn::Ended;
+            
+            if (!stream.framer.commitHop())
+                continue;
+            
+            auto fftInput = dftHandler.getFFTInput();
+            {
+                StageTimer timer(Stage::Framing);
+                stream.framer.windowFrame(fftInput);
+            }
+            
+            const DFTHandler<float>::Complex* spectrum;
+            {
+                StageTimer timer(Stage::FFT);
+                spectrum = dftHandler.executeFFT(fftInput);
+            }
+            
+            float energies[filterBankCount];
+            {
+                StageTimer timer(Stage::Mel);
+                this->mfcc.computeMFCC(spectrum, energies);
+            }
+            
+            auto coefficients = this->coefficientsPool->acquire();
+            {
+                StageTimer timer(Stage::DCT);
+                this->dct.compute(energies, coefficients.data());
+            }
+            coefficients.commit(coefficientCount);
+            coefficients.setTimestamp(static_cast<std::int64_t>(
+                    static_cast<double>(stream.nextSequence * this->hopLength) * 1e9 / this->sampleRate));
+            coefficients.setSequence(stream.nextSequence++);
+            coefficients.setCaptureTime(stream.source->getCaptureTime());
+            stats.recordLatency(coefficients.getCaptureTime());
+            
+            this->output(streamIndex, std::move(coefficients));
+            stats.framesEmitted.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        return Turn::Progress;
+    }
+}
@@ -0,0 +1,114 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "../../include/preprocessor/VoiceActivityDetector.h"
+#include "../../include/util/SIMD.hpp"
+
+namespace Dicta
+{
+    namespace
+    {
+        std::size_t millisecondsToHops(double milliseconds, std::size_t sampleRate, std::size_t hopLength)
+        { return static_cast<std::size_t>(std::ceil(milliseconds * sampleRate / 1000 / hopLength)); }
+    }
+    
+    VoiceActivityDetector::VoiceActivityDetector(const VoiceActivityOptions& options,
+                                                 std::size_t sampleRate,
+                                                 std::size_t hopLength) :
+            options(options),
+            hopLength(hopLength),
+            startHops(std::max<std::size_t>(millisecondsToHops(options.startMilliseconds, sampleRate, hopLength), 1)),
+            hangoverHops(std::max<std::size_t>(millisecondsToHops(options.hangoverMilliseconds, sampleRate, hopLength), 1)),
+            paddingHops(millisecondsToHops(options.paddingMilliseconds, sampleRate, hopLength)),
+            blockHops(std::max<std::size_t>(
+                    millisecondsToHops(options.noiseFloorMilliseconds, sampleRate, hopLength) / noiseFloorBlocks, 1))
+    {
+        if (!sampleRate || !hopLength)
+            throw std::invalid_argument("VAD error: Sample rate and hop length must be positive");
+        if (options.stopThreshold > options.startThreshold)
+            throw std::invalid_argument("VAD error: Stop threshold must not be above the start threshold");
+        
+        this->reset();
+    }
+    
+    void VoiceActivityDetector::reset()
+    {
+        this->completedBlocks = 0;
+        this->hopsInBlock = 0;
+        this->blockMinimum = std::numeric_limits<float>::max();
+        this->speaking = false;
+        this->activeHops = 0;
+        this->silentHops = 0;
+    }
+    
+    void VoiceActivityDetector::updateNoiseFloor(float energy)
+    {
+        this->blockMinimum = std::min(this->blockMinimum, energy);
+        if (++this->hopsInBlock != this->blockHops)
+            return;
+        
+        this->blockMinima[this->completedBlocks++ % noiseFloorBlocks] = this->blockMinimum;
+        this->blockMinimum = std::numeric_limits<float>::max();
+        this->hopsInBlock = 0;
+    }
+    
+    float VoiceActivityDetector::getNoiseFloor() const
+    {
+        auto floor = this->blockMinimum;
+        auto blocks = std::min(this->completedBlocks, noiseFloorBlocks);
+        for (std::size_t block = 0; block != blocks; ++block)
+            floor = std::min(floor, this->blockMinima[block]);
+        
+        return std::max(floor, static_cast<float>(this->options.minimumEnergy));
+    }
+    
+    VoiceActivity VoiceActivityDetector::process(const float* hop)
+    {
+        // Mean square in dBFS, the tiny offset keeps digital silence finite
+        auto meanSquare = SIMD::dot(hop, hop, this->hopLength) / this->hopLength;
+        this->energy = 10 * std::log10(meanSquare + 1e-12f);
+        
+        std::size_t crossings = 0;
+        for (std::size_t sample = 1; sample != this->hopLength; ++sample)
+            crossings += (hop[sample] >= 0) != (hop[sample - 1] >= 0);
+        this->zeroCrossingRate = static_cast<float>(crossings) / this->hopLength;
+        
+        this->updateNoiseFloor(this->energy);
+        auto floor = this->getNoiseFloor();
+        bool loud = this->energy >= floor + this->options.startThreshold;
+        bool audible = this->energy >= floor + this->options.stopThreshold;
+        
+        if (!this->speaking) {
+            // Hysteresis: starting takes the start threshold, or an audible hop crossing zero often
+            bool active = loud || (audible && this->zeroCrossingRate >= this->options.zeroCrossingThreshold);
+            this->activeHops = active ? this->activeHops + 1 : 0;
+            if (this->activeHops < this->startHops)
+                return VoiceActivity::Silence;
+            
+            this->speaking = true;
+            this->silentHops = 0;
+            return VoiceActivity::UtteranceStart;
+        }
+        
+        // While speaking the stop threshold is enough, and only a whole hangover of silence ends it
+        if (audible) {
+            this->silentHops = 0;
+            return VoiceActivity::Speech;
+        }
+        if (++this->silentHops < this->hangoverHops)
+            return VoiceActivity::Speech;
+        
+        this->speaking = false;
+        this->activeHops = 0;
+        return VoiceActivity::UtteranceEnd;
+    }
+}
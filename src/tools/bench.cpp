@@ -0,0 +1,509 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+// dicta_bench: times each stage of the pipeline and the whole chain over deterministic synthetic audio,
+// or a recorded fixture, printing a table or JSON to track regressions across releases
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../include/audio/FileAudioSource.h"
+#include "../../include/audio/Resampler.h"
+#include "../../include/features/FeatureFormat.h"
+#include "../../include/preprocessor/FeatureExtractor.h"
+#include "../../include/preprocessor/PreProcessor.h"
+#include "../../include/wisard/WiSARD.h"
+
+// Every heap allocation of the process is counted, to report allocations per frame.
+// Kept out of line, otherwise GCC sees malloc'ed memory reaching operator delete (or the opposite) and complains.
+static std::atomic<std::size_t> heapAllocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    ++heapAllocations;
+    if (auto memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++heapAllocations;
+    auto align = static_cast<std::size_t>(alignment);
+    if (auto memory = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+        return memory;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* memory) noexcept
+{ std::free(memory); }
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t) noexcept
+{ std::free(memory); }
+
+__attribute__((noinline)) void operator delete(void* memory, std::align_val_t) noexcept
+{ std::free(memory); }
+
+__attribute__((noinline)) void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{ std::free(memory); }
+
+namespace
+{
+    // Rate features are usually computed at, to compare against featurizing at the input's own rate
+    constexpr int resampledRate = 16000;
+    
+    // Plays a buffer of samples as fast as the pipeline takes them
+    class MemoryAudioSource : public Dicta::AudioSource
+    {
+        private:
+        const std::vector<float>& samples;
+        int sampleRate;
+        std::size_t position = 0;
+        
+        void print(std::ostream& out) const override
+        { out << "Memory: " << this->samples.size() << " samples at " << this->sampleRate << "Hz"; }
+        
+        public:
+        MemoryAudioSource(const std::vector<float>& samples, int sampleRate) :
+                samples(samples),
+                sampleRate(sampleRate)
+        {}
+        
+        int getSampleRate() const override
+        { return this->sampleRate; }
+        
+        void start() override
+        {}
+        
+        std::size_t read(float* destination, std::size_t count) override
+        {
+            count = std::min(count, this->samples.size() - this->position);
+            std::copy_n(this->samples.data() + this->position, count, destination);
+            this->position += count;
+            return count;
+        }
+    };
+    
+    struct Result
+    {
+        std::string name;
+        std::string input;
+        std::size_t frames;
+        double seconds;
+        std::size_t allocations;
+        // Audio each frame stands for, to compute the real time factor
+        double hopSeconds;
+    };
+    
+    // Runs body once to warm up pools, caches and plans, then times it
+    Result measure(const std::string& name,
+                   const std::string& input,
+                   std::size_t frames,
+                   double hopSeconds,
+                   const std::function<void()>& body)
+    {
+        body();
+        
+        auto allocationsBefore = heapAllocations.load();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        
+        return {name, input, frames, elapsed.count(), heapAllocations.load() - allocationsBefore, hopSeconds};
+    }
+    
+    std::vector<float> makeTone(std::size_t sampleCount, int sampleRate)
+    {
+        const double pi = std::atan(1) * 4;
+        std::vector<float> samples(sampleCount);
+        for (std::size_t sample = 0; sample != sampleCount; ++sample)
+            samples[sample] = 0.5 * std::sin(2 * pi * 440 * sample / sampleRate)
+                              + 0.25 * std::sin(2 * pi * 1320 * sample / sampleRate);
+        return samples;
+    }
+    
+    std::vector<float> makeNoise(std::size_t sampleCount)
+    {
+        // Fixed seed, so every run sees the same samples
+        std::mt19937 generator(20161018);
+        std::uniform_real_distribution<float> distribution(-1, 1);
+        std::vector<float> samples(sampleCount);
+        for (auto& sample : samples)
+            sample = distribution(generator);
+        return samples;
+    }
+    
+    std::vector<float> loadFixture(const std::string& fileName, int& sampleRate)
+    {
+        Dicta::FileAudioSource source(fileName);
+        sampleRate = source.getSampleRate();
+        
+        std::vector<float> samples(source.getFrameCount());
+        samples.resize(source.read(samples.data(), samples.size()));
+        return samples;
+    }
+    
+    // Encodes and decodes features, frameSize coefficients per frame, as one segment when scaled
+    void benchmarkEncoding(Dicta::FeatureEncoding encoding,
+                           const std::string& name,
+                           const std::string& input,
+                           const std::vector<float>& features,
+                           std::size_t frameSize,
+                           double hopSeconds,
+                           std::vector<Result>& results)
+    {
+        auto frames = features.size() / frameSize;
+        auto coefficientBytes = Dicta::bytesPerCoefficient(encoding);
+        
+        // Range of each coefficient over the input, what the Int8 offsets and scales are made from
+        std::vector<float> minima(frameSize, std::numeric_limits<float>::infinity());
+        std::vector<float> maxima(frameSize, -std::numeric_limits<float>::infinity());
+        for (std::size_t frame = 0; frame != frames; ++frame)
+            for (std::size_t pos = 0; pos != frameSize; ++pos) {
+                minima[pos] = std::min(minima[pos], features[frame * frameSize + pos]);
+                maxima[pos] = std::max(maxima[pos], features[frame * frameSize + pos]);
+            }
+        
+        std::vector<float> scales(frameSize, 1), offsets(frameSize, 0), inverseScales(frameSize, 1);
+        if (encoding == Dicta::FeatureEncoding::Int8)
+            for (std::size_t pos = 0; pos != frameSize; ++pos) {
+                offsets[pos] = minima[pos] / 2 + maxima[pos] / 2;
+                scales[pos] = Dicta::scaleOf(Dicta::scaleExponent(std::max(maxima[pos] - offsets[pos], offsets[pos] - minima[pos])));
+                inverseScales[pos] = 1 / scales[pos];
+            }
+        
+        std::vector<std::uint8_t> encoded(features.size() * coefficientBytes);
+        results.push_back(measure("encode-" + name, input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame)
+                Dicta::encodeCoefficients(encoding, features.data() + frame * frameSize, frameSize, offsets.data(),
+                                          inverseScales.data(), encoded.data() + frame * frameSize * coefficientBytes);
+        }));
+        
+        std::vector<float> decoded(features.size());
+        results.push_back(measure("decode-" + name, input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame)
+                Dicta::decodeCoefficients(encoding, encoded.data() + frame * frameSize * coefficientBytes, frameSize,
+                                          scales.data(), offsets.data(), decoded.data() + frame * frameSize);
+        }));
+        
+        // Errors relative to each coefficient's range, max - min over the input, so c0 doesn't dwarf the others
+        double maximumError = 0, squaredError = 0;
+        for (std::size_t pos = 0; pos != frameSize; ++pos) {
+            double range = maxima[pos] - minima[pos];
+            for (std::size_t frame = 0; range > 0 && frame != frames; ++frame) {
+                auto index = frame * frameSize + pos;
+                double error = std::abs(decoded[index] - features[index]) / range;
+                maximumError = std::max(maximumError, error);
+                squaredError += error * error;
+            }
+        }
+        std::cerr << input << " " << name << ": " << Dicta::recordSize(frameSize, encoding) << " of "
+                  << Dicta::recordSize(frameSize, Dicta::FeatureEncoding::Float32) << " bytes per record, error "
+                  << std::sqrt(squaredError / features.size()) << " rms, " << maximumError << " max of each coefficient's range"
+                  << std::endl;
+    }
+    
+    void benchmarkInput(const std::string& input, const std::vector<float>& samples, int sampleRate, std::vector<Result>& results)
+    {
+        Dicta::PreProcessor layout(sampleRate);
+        auto frameLength = layout.getFrameLength();
+        auto hopLength = layout.getHopLength();
+        auto fftSize = layout.getSamplesPerFrame();
+        auto hopSeconds = static_cast<double>(hopLength) / sampleRate;
+        const std::size_t filterBankCount = layout.getMFCC().getFilterBanksCount();
+        
+        if (samples.size() < frameLength + hopLength)
+            throw std::invalid_argument("Benchmark error: Input is shorter than a frame");
+        std::size_t frames = (samples.size() - frameLength) / hopLength + 1;
+        
+        // Windowed frames and spectra of the whole input, so each stage can be timed on its own
+        Dicta::Framer framer(frameLength, hopLength, Dicta::WindowType::Hann, fftSize);
+        std::vector<float> windowed(frames * fftSize);
+        results.push_back(measure("window", input, frames, hopSeconds, [&] {
+            framer.reset();
+            std::size_t frame = 0;
+            for (std::size_t hop = 0; hop * hopLength + hopLength <= samples.size() && frame != frames; ++hop) {
+                std::copy_n(samples.data() + hop * hopLength, hopLength, framer.getHopInput());
+                if (framer.commitHop())
+                    framer.windowFrame(windowed.data() + fftSize * frame++);
+            }
+        }));
+        
+        Dicta::DFTHandler<float> dftHandler(fftSize, filterBankCount);
+        auto outputSize = dftHandler.getOutputSize();
+        std::vector<float> spectra(frames * outputSize);
+        results.push_back(measure("fft", input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame) {
+                auto spectrum = dftHandler.processFFT(windowed.data() + fftSize * frame);
+                std::copy_n(spectrum.data(), outputSize, spectra.data() + outputSize * frame);
+            }
+        }));
+        
+        auto& mfcc = layout.getMFCC();
+        std::vector<float> energies(frames * filterBankCount);
+        results.push_back(measure("mfcc", input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame)
+                mfcc.computeMFCC(spectra.data() + outputSize * frame, energies.data() + filterBankCount * frame);
+        }));
+        
+        auto energiesPool = Dicta::FramePool<float>::create(filterBankCount);
+        results.push_back(measure("dct", input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame) {
+                auto frameEnergies = energiesPool->acquire();
+                std::copy_n(energies.data() + filterBankCount * frame, filterBankCount, frameEnergies.data());
+                frameEnergies.commit(filterBankCount);
+                dftHandler.processDCT(frameEnergies);
+            }
+        }));
+        
+        Dicta::DCTMatrix<float> dctMatrix(filterBankCount, filterBankCount / 2);
+        std::vector<float> coefficients(frames * (filterBankCount / 2));
+        results.push_back(measure("dct-matrix", input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame)
+                dctMatrix.compute(energies.data() + filterBankCount * frame, coefficients.data() + filterBankCount / 2 * frame);
+        }));
+        
+        // FFT, filter banks and DCT as the pipeline runs them, reading the FFT output in place
+        results.push_back(measure("fused", input, frames, hopSeconds, [&] {
+            for (std::size_t frame = 0; frame != frames; ++frame) {
+                auto spectrum = dftHandler.executeFFT(windowed.data() + fftSize * frame);
+                mfcc.computeMFCC(spectrum, energies.data() + filterBankCount * frame);
+                dctMatrix.compute(energies.data() + filterBankCount * frame, coefficients.data() + filterBankCount / 2 * frame);
+            }
+        }));
+        
+        // Whole chain, from reading samples to frames reaching the consumer, setting the pipeline up included
+        auto endToEnd = [&](const std::string& name, const Dicta::ExecutionOptions& executionOptions) {
+            results.push_back(measure(name, input, frames, hopSeconds, [&] {
+                Dicta::PreProcessor preProcessor(sampleRate, {}, executionOptions);
+                MemoryAudioSource source(samples, sampleRate);
+                auto framing = std::async(std::launch::async,
+                                          Dicta::PreProcessor::readFrameAndWindowRecordingBuffer,
+                                          &source,
+                                          &preProcessor);
+                
+                // Consumed frames go back to their pools, like a real consumer's would
+                std::vector<Dicta::Frame<float>> processed;
+                processed.reserve(executionOptions.outputCapacity);
+                while (preProcessor.getProcessedFrames().drain(processed))
+                    processed.clear();
+                
+                framing.get();
+            }));
+        };
+        
+        Dicta::ExecutionOptions single;
+        endToEnd("pipeline", single);
+        
+        Dicta::ExecutionOptions batched;
+        batched.batchSize = 32;
+        endToEnd("pipeline-batch32", batched);
+        
+        Dicta::ExecutionOptions parallel;
+        parallel.workerCount = std::max(2u, std::thread::hardware_concurrency());
+        endToEnd("pipeline-workers" + std::to_string(parallel.workerCount), parallel);
+        
+        // The same chain pushed 10ms spans at a time and featurized inline, as an embedding service would
+        Dicta::FeatureExtractor extractor(sampleRate);
+        results.push_back(measure("extractor", input, frames, hopSeconds, [&] {
+            std::size_t span = sampleRate / 100;
+            for (std::size_t position = 0; position < samples.size(); position += span)
+                extractor.process(samples.data() + position,
+                                  std::min(span, samples.size() - position),
+                                  [](Dicta::Frame<float>) {});
+            extractor.finish([](Dicta::Frame<float>) {});
+        }));
+        
+        // Compact feature encodings over the extractor's output, their error going to stderr
+        std::vector<float> features;
+        auto keepFeatures = [&](Dicta::Frame<float> frame) {
+            features.insert(features.end(), frame.data(), frame.data() + frame.size());
+        };
+        extractor.process(samples.data(), samples.size(), keepFeatures);
+        extractor.finish(keepFeatures);
+        benchmarkEncoding(Dicta::FeatureEncoding::Float16, "f16", input, features, extractor.getFrameSize(), hopSeconds, results);
+        benchmarkEncoding(Dicta::FeatureEncoding::Int8, "i8", input, features, extractor.getFrameSize(), hopSeconds, results);
+        
+        if (sampleRate == resampledRate)
+            return;
+        
+        // The resampler alone, then the whole chain running at the lower rate behind it
+        results.push_back(measure("resample" + std::to_string(resampledRate / 1000) + "k", input, frames, hopSeconds, [&] {
+            Dicta::ResamplingAudioSource source(std::make_unique<MemoryAudioSource>(samples, sampleRate), resampledRate);
+            std::vector<float> resampled(hopLength);
+            while (source.read(resampled.data(), resampled.size()))
+                ;
+        }));
+        
+        Dicta::PreProcessor resampledLayout(resampledRate);
+        auto resampledHop = resampledLayout.getHopLength();
+        auto resampledFrames = (samples.size() * resampledRate / sampleRate - resampledLayout.getFrameLength()) / resampledHop + 1;
+        results.push_back(measure("pipeline-" + std::to_string(resampledRate / 1000) + "k",
+                                  input,
+                                  resampledFrames,
+                                  static_cast<double>(resampledHop) / resampledRate,
+                                  [&] {
+            Dicta::PreProcessor preProcessor(resampledRate);
+            Dicta::ResamplingAudioSource source(std::make_unique<MemoryAudioSource>(samples, sampleRate), resampledRate);
+            auto framing = std::async(std::launch::async,
+                                      Dicta::PreProcessor::readFrameAndWindowRecordingBuffer,
+                                      &source,
+                                      &preProcessor);
+            
+            std::vector<Dicta::Frame<float>> processed;
+            while (preProcessor.getProcessedFrames().drain(processed))
+                processed.clear();
+            
+            framing.get();
+        }));
+    }
+    
+    // A vocabulary of classCount words, each a random prototype of frameCount MFCC frames, uttered
+    // utterancesPerClass times with noise, quantile binarized, then trained and classified. Rows count
+    // utterances instead of frames, with no real time factor.
+    void benchmarkClassifier(std::size_t classCount, std::vector<Result>& results)
+    {
+        constexpr std::size_t utterancesPerClass = 10;
+        constexpr std::size_t frameCount = 40;
+        constexpr std::size_t coefficientCount = Dicta::PreProcessor::getCoefficientCount();
+        constexpr std::size_t featureCount = frameCount * coefficientCount;
+        constexpr std::size_t levelCount = 16;
+        
+        std::mt19937 generator(20161018);
+        std::normal_distribution<float> distribution(0, 1);
+        std::vector<float> prototypes(classCount * featureCount);
+        for (auto& value : prototypes)
+            value = 10 * distribution(generator);
+        
+        auto sampleCount = classCount * utterancesPerClass;
+        std::vector<float> features(sampleCount * featureCount);
+        std::vector<std::size_t> labels(sampleCount);
+        for (std::size_t sample = 0; sample != sampleCount; ++sample) {
+            labels[sample] = sample % classCount;
+            for (std::size_t feature = 0; feature != featureCount; ++feature)
+                features[sample * featureCount + feature] =
+                        prototypes[labels[sample] * featureCount + feature] + 3 * distribution(generator);
+        }
+        
+        auto thermometer = Dicta::Thermometer::fitQuantiles(features.data(), sampleCount, featureCount, levelCount);
+        auto inputWords = Dicta::packedWords(thermometer.getBitCount());
+        std::vector<std::uint64_t> inputs(sampleCount * inputWords);
+        for (std::size_t sample = 0; sample != sampleCount; ++sample)
+            thermometer.encode(features.data() + sample * featureCount, inputs.data() + sample * inputWords);
+        
+        auto input = std::to_string(classCount) + "w";
+        std::unique_ptr<Dicta::WiSARD> wisard;
+        results.push_back(measure("wisard-train", input, sampleCount, 0, [&] {
+            wisard = std::make_unique<Dicta::WiSARD>(thermometer.getBitCount(), classCount);
+            wisard->train(inputs.data(), labels.data(), sampleCount);
+        }));
+        
+        std::size_t correct = 0;
+        results.push_back(measure("wisard-classify", input, sampleCount, 0, [&] {
+            correct = 0;
+            for (std::size_t sample = 0; sample != sampleCount; ++sample)
+                correct += wisard->classify(inputs.data() + sample * inputWords).label == labels[sample];
+        }));
+        std::cerr << "WiSARD: " << classCount << " words, " << wisard->getRAMCount() << " RAMs, "
+                  << wisard->memoryUsage() / 1024 << "KiB, " << correct << "/" << sampleCount << " training utterances recognized"
+                  << std::endl;
+    }
+    
+    void printTable(const std::vector<Result>& results)
+    {
+        std::cout << std::left << std::setw(22) << "benchmark" << std::setw(10) << "input"
+                  << std::right << std::setw(10) << "frames" << std::setw(14) << "ns/frame"
+                  << std::setw(14) << "frames/s" << std::setw(12) << "x realtime" << std::setw(14) << "allocs/frame"
+                  << "\n";
+        
+        for (auto& result : results)
+            std::cout << std::left << std::setw(22) << result.name << std::setw(10) << result.input
+                      << std::right << std::setw(10) << result.frames
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(14) << result.seconds * 1e9 / result.frames
+                      << std::setprecision(0) << std::setw(14) << result.frames / result.seconds
+                      << std::setprecision(1) << std::setw(12) << result.frames * result.hopSeconds / result.seconds
+                      << std::setprecision(3) << std::setw(14) << static_cast<double>(result.allocations) / result.frames
+                      << "\n";
+    }
+    
+    void printJSON(const std::vector<Result>& results)
+    {
+        std::cout << "[\n";
+        for (std::size_t index = 0; index != results.size(); ++index) {
+            auto& result = results[index];
+            std::cout << "  {\"benchmark\": \"" << result.name << "\""
+                      << ", \"input\": \"" << result.input << "\""
+                      << ", \"frames\": " << result.frames
+                      << ", \"ns_per_frame\": " << result.seconds * 1e9 / result.frames
+                      << ", \"frames_per_second\": " << result.frames / result.seconds
+                      << ", \"realtime_factor\": " << result.frames * result.hopSeconds / result.seconds
+                      << ", \"allocations_per_frame\": " << static_cast<double>(result.allocations) / result.frames
+                      << "}" << (index + 1 != results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    double seconds = 60;
+    int sampleRate = 16000;
+    std::string fixture;
+    
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string option = argv[arg];
+        if (option == "--json")
+            json = true;
+        else if (option == "--seconds" && arg + 1 < argc)
+            seconds = std::stod(argv[++arg]);
+        else if (option == "--sample-rate" && arg + 1 < argc)
+            sampleRate = std::stoi(argv[++arg]);
+        else if (option == "--fixture" && arg + 1 < argc)
+            fixture = argv[++arg];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--json] [--seconds 60] [--sample-rate 16000] [--fixture file.wav]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    
+    std::vector<Result> results;
+    auto sampleCount = static_cast<std::size_t>(seconds * sampleRate);
+    
+    benchmarkInput("tone", makeTone(sampleCount, sampleRate), sampleRate, results);
+    benchmarkInput("noise", makeNoise(sampleCount), sampleRate, results);
+    
+    if (!fixture.empty()) {
+        int fixtureSampleRate = 0;
+        auto samples = loadFixture(fixture, fixtureSampleRate);
+        benchmarkInput("fixture", samples, fixtureSampleRate, results);
+    }
+    
+    benchmarkClassifier(300, results);
+    
+    if (json)
+        printJSON(results);
+    else
+        printTable(results);
+    
+    return 0;
+}
@@ -0,0 +1,348 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+// dicta-extract: featurizes every WAV file under the given directories on all cores into a FeatureCache,
+// skipping files whose features are already there, and lists each file's cache entry on stdout
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../include/audio/FileAudioSource.h"
+#include "../../include/audio/Resampler.h"
+#include "../../include/features/FeatureCache.h"
+#include "../../include/preprocessor/FeatureExtractor.h"
+
+namespace
+{
+    constexpr std::size_t readSize = 1 << 16;
+    
+    struct Options
+    {
+        std::string cacheDirectory;
+        std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+        Dicta::FeatureEncoding encoding = Dicta::FeatureEncoding::Float32;
+        // Zero featurizes every file at its own rate
+        std::size_t sampleRate = 0;
+        std::size_t deltaWidth = 0;
+        Dicta::FramingOptions framingOptions;
+    };
+    
+    // What a previous run learnt about a file, to tell it unchanged from its size and modification time alone
+    struct SourceRecord
+    {
+        std::uint64_t audioHash = 0;
+        std::size_t sampleRate = 0;
+        std::uint64_t size = 0;
+        std::int64_t modified = 0;
+    };
+    
+    using SourceIndex = std::unordered_map<std::string, SourceRecord>;
+    
+    struct Job
+    {
+        enum class Outcome
+        {
+            Failed,
+            Cached,
+            Featurized
+        };
+        
+        std::string path;
+        SourceRecord source;
+        std::string entry;
+        Outcome outcome = Outcome::Failed;
+        
+        explicit Job(std::string path) : path(std::move(path))
+        {}
+    };
+    
+    // One extractor per sample rate, each worker having its own
+    using Extractors = std::map<std::size_t, std::unique_ptr<Dicta::FeatureExtractor>>;
+    
+    Dicta::FeatureEncoding parseFeatureEncoding(const std::string& name)
+    {
+        if (name == "f32") return Dicta::FeatureEncoding::Float32;
+        if (name == "f16") return Dicta::FeatureEncoding::Float16;
+        if (name == "i8") return Dicta::FeatureEncoding::Int8;
+        throw std::invalid_argument("Unknown feature encoding: " + name);
+    }
+    
+    // The cache directory's sources file, a "hash sampleRate size modified path" line per file ever featurized
+    SourceIndex loadIndex(const std::string& fileName)
+    {
+        SourceIndex index;
+        std::ifstream file(fileName);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string hash;
+            SourceRecord record;
+            if (!(fields >> hash >> record.sampleRate >> record.size >> record.modified) || fields.get() != ' ')
+                continue;
+            
+            std::string path;
+            std::getline(fields, path);
+            try {
+                record.audioHash = Dicta::hashFromString(hash);
+                index[path] = record;
+            }
+            catch (const std::invalid_argument&) {}
+        }
+        return index;
+    }
+    
+    // Written beside the index and renamed over it, so an interrupted run leaves the old one
+    void saveIndex(const std::string& fileName, const SourceIndex& index)
+    {
+        auto temporaryName = fileName + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream file(temporaryName);
+            for (auto& [path, record] : index)
+                file << Dicta::hashToString(record.audioHash) << " " << record.sampleRate << " " << record.size << " "
+                     << record.modified << " " << path << "\n";
+            if (!file)
+                throw std::runtime_error("Couldn't write " + temporaryName);
+        }
+        if (std::rename(temporaryName.c_str(), fileName.c_str())) {
+            std::remove(temporaryName.c_str());
+            throw std::runtime_error("Couldn't replace " + fileName);
+        }
+    }
+    
+    bool isWaveFile(const std::filesystem::path& path)
+    {
+        auto extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char letter) { return std::tolower(letter); });
+        return extension == ".wav";
+    }
+    
+    // WAV files under every directory, and files given directly, sorted so runs list them in the same order
+    std::vector<std::string> findFiles(const std::vector<std::string>& arguments)
+    {
+        std::vector<std::string> files;
+        for (auto& argument : arguments) {
+            auto root = std::filesystem::absolute(argument).lexically_normal();
+            if (!std::filesystem::is_directory(root)) {
+                files.push_back(root.string());
+                continue;
+            }
+            
+            for (auto& entry : std::filesystem::recursive_directory_iterator(
+                    root, std::filesystem::directory_options::skip_permission_denied))
+                if (entry.is_regular_file() && isWaveFile(entry.path()))
+                    files.push_back(entry.path().string());
+        }
+        
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+        return files;
+    }
+    
+    Dicta::FeatureExtractor& extractorFor(std::size_t sampleRate, const Options& options, Extractors& extractors)
+    {
+        auto& extractor = extractors[sampleRate];
+        if (!extractor)
+            extractor = std::make_unique<Dicta::FeatureExtractor>(sampleRate, options.framingOptions, options.deltaWidth);
+        return *extractor;
+    }
+    
+    Dicta::FeatureConfiguration configurationOf(const Dicta::FeatureExtractor& extractor, const Options& options)
+    {
+        return Dicta::FeatureConfiguration{
+                extractor.getSampleRate(),
+                extractor.getFrameLength(),
+                extractor.getHopLength(),
+                extractor.getFFTSize(),
+                Dicta::FeatureExtractor::getFilterBankCount(),
+                options.framingOptions.windowType,
+                options.deltaWidth,
+                options.encoding
+        };
+    }
+    
+    // Featurizes job's file into the cache unless its features are there already. Files the index knows,
+    // with the same size and modification time, aren't even opened.
+    void extract(Job& job,
+                 const Options& options,
+                 const Dicta::FeatureCache& cache,
+                 const SourceIndex& index,
+                 Extractors& extractors,
+                 std::vector<float>& samples)
+    {
+        struct stat status;
+        if (::stat(job.path.c_str(), &status))
+            throw std::runtime_error(std::string("Couldn't stat: ") + std::strerror(errno));
+        job.source.size = static_cast<std::uint64_t>(status.st_size);
+        job.source.modified = static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+        
+        auto isCached = [&] {
+            auto& extractor = extractorFor(options.sampleRate ? options.sampleRate : job.source.sampleRate, options, extractors);
+            auto configuration = configurationOf(extractor, options);
+            if (!cache.contains(job.source.audioHash, configuration))
+                return false;
+            
+            job.entry = cache.entryPath(job.source.audioHash, configuration);
+            job.outcome = Job::Outcome::Cached;
+            return true;
+        };
+        
+        auto known = index.find(job.path);
+        bool unchanged = known != index.end() && known->second.size == job.source.size
+                         && known->second.modified == job.source.modified;
+        if (unchanged) {
+            job.source = known->second;
+            if (isCached())
+                return;
+        }
+        
+        std::unique_ptr<Dicta::AudioSource> audioSource = std::make_unique<Dicta::FileAudioSource>(job.path);
+        if (!unchanged) {
+            // Touched or new files are hashed, their features may be cached already, e.g. when a file was copied
+            job.source.sampleRate = static_cast<std::size_t>(audioSource->getSampleRate());
+            job.source.audioHash = Dicta::hashFile(job.path);
+            if (isCached())
+                return;
+        }
+        
+        if (options.sampleRate && options.sampleRate != job.source.sampleRate)
+            audioSource = std::make_unique<Dicta::ResamplingAudioSource>(std::move(audioSource), static_cast<int>(options.sampleRate));
+        audioSource->start();
+        
+        auto& extractor = extractorFor(static_cast<std::size_t>(audioSource->getSampleRate()), options, extractors);
+        job.entry = cache.store(job.source.audioHash,
+                                configurationOf(extractor, options),
+                                extractor.makeFeatureHeader(options.encoding),
+                                [&](Dicta::FeatureWriter& writer) {
+            auto write = [&](Dicta::Frame<float> frame) { writer.write(std::move(frame)); };
+            try {
+                std::size_t count;
+                while ((count = audioSource->read(samples.data(), samples.size()))) {
+                    extractor.process(samples.data(), count, write);
+                    if (count < samples.size())
+                        break;
+                }
+                extractor.finish(write);
+            }
+            catch (...) {
+                // Leaves the extractor ready for the next file
+                extractor.finish([](Dicta::Frame<float>) {});
+                throw;
+            }
+        });
+        job.outcome = Job::Outcome::Featurized;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    std::vector<std::string> arguments;
+    
+    try {
+        for (int arg = 1; arg < argc; ++arg) {
+            std::string option = argv[arg];
+            if (option == "-c" && arg + 1 < argc)
+                options.cacheDirectory = argv[++arg];
+            else if (option == "-j" && arg + 1 < argc)
+                options.jobs = std::max<std::size_t>(std::stoul(argv[++arg]), 1);
+            else if (option == "-e" && arg + 1 < argc)
+                options.encoding = parseFeatureEncoding(argv[++arg]);
+            else if (option == "-r" && arg + 1 < argc)
+                options.sampleRate = std::stoul(argv[++arg]);
+            else if (option == "-d" && arg + 1 < argc)
+                options.deltaWidth = std::stoul(argv[++arg]);
+            else if (!option.empty() && option[0] != '-')
+                arguments.push_back(option);
+            else
+                throw std::invalid_argument("Unknown option: " + option);
+        }
+        if (arguments.empty())
+            throw std::invalid_argument("No directory to featurize");
+    }
+    catch (const std::exception& exception) {
+        std::cerr << exception.what() << "\nUsage: " << argv[0]
+                  << " [-c cacheDirectory] [-j jobs] [-e f32|f16|i8] [-r sampleRate] [-d deltaWidth] directory|file.wav..."
+                  << std::endl;
+        return 1;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    Dicta::FeatureCache cache(options.cacheDirectory);
+    auto indexName = cache.getDirectory() + "/sources";
+    auto index = loadIndex(indexName);
+    
+    std::vector<Job> jobs;
+    for (auto& file : findFiles(arguments))
+        jobs.emplace_back(file);
+    
+    // Workers take files in order, each one hashing, featurizing and writing its own
+    std::atomic<std::size_t> nextJob{0};
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    for (std::size_t worker = 0; worker != std::min(options.jobs, jobs.size()); ++worker)
+        workers.emplace_back([&] {
+            Extractors extractors;
+            std::vector<float> samples(readSize);
+            for (auto job = nextJob++; job < jobs.size(); job = nextJob++) {
+                try {
+                    extract(jobs[job], options, cache, index, extractors, samples);
+                }
+                catch (const std::exception& exception) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    std::cerr << jobs[job].path << ": " << exception.what() << std::endl;
+                }
+            }
+        });
+    for (auto& worker : workers)
+        worker.join();
+    
+    std::size_t featurized = 0, cached = 0, failed = 0;
+    for (auto& job : jobs) {
+        if (job.outcome == Job::Outcome::Failed) {
+            ++failed;
+            continue;
+        }
+        
+        (job.outcome == Job::Outcome::Cached ? cached : featurized) += 1;
+        index[job.path] = job.source;
+        std::cout << job.entry << "\t" << job.path << "\n";
+    }
+    std::cout.flush();
+    
+    try {
+        std::filesystem::create_directories(cache.getDirectory());
+        saveIndex(indexName, index);
+    }
+    catch (const std::exception& exception) {
+        std::cerr << "Couldn't save the source index, the next run will hash every file again: " << exception.what() << std::endl;
+    }
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << jobs.size() << " files: " << featurized << " featurized, " << cached << " cached, " << failed
+              << " failed in " << elapsed.count() << "s, cache in " << cache.getDirectory() << std::endl;
+    
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+// dicta-wisdom: plans every transform Dicta uses for the given sample rates ahead of time, so the
+// wisdom cache is warm at deploy time and starting Dicta takes milliseconds instead of seconds
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../include/preprocessor/PreProcessor.h"
+
+Dicta::PlannerEffort parsePlannerEffort(const std::string& name)
+{
+    if (name == "estimate") return Dicta::PlannerEffort::Estimate;
+    if (name == "measure") return Dicta::PlannerEffort::Measure;
+    if (name == "patient") return Dicta::PlannerEffort::Patient;
+    if (name == "exhaustive") return Dicta::PlannerEffort::Exhaustive;
+    throw std::invalid_argument("Unknown planner effort: " + name);
+}
+
+int main(int argc, char** argv)
+{
+    Dicta::PlannerOptions plannerOptions;
+    std::size_t batchSize = 32;
+    std::vector<std::size_t> sampleRates;
+    
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string option = argv[arg];
+        if (option == "-e" && arg + 1 < argc)
+            plannerOptions.effort = parsePlannerEffort(argv[++arg]);
+        else if (option == "-t" && arg + 1 < argc)
+            plannerOptions.timeLimit = std::stod(argv[++arg]);
+        else if (option == "-d" && arg + 1 < argc)
+            plannerOptions.wisdomDirectory = argv[++arg];
+        else if (option == "-b" && arg + 1 < argc)
+            batchSize = std::stoul(argv[++arg]);
+        else if (!option.empty() && option[0] != '-')
+            sampleRates.push_back(std::stoul(option));
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [-e estimate|measure|patient|exhaustive] [-t seconds] [-d directory] [-b batchSize]"
+                      << " [sampleRate...]" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (sampleRates.empty())
+        sampleRates = {8000, 16000, 44100, 48000};
+    
+    // The same configurations Dicta uses: single frame transforms for devices and workers, batches for files
+    Dicta::ExecutionOptions single;
+    single.plannerOptions = plannerOptions;
+    Dicta::ExecutionOptions batched = single;
+    batched.batchSize = batchSize;
+    
+    for (auto sampleRate : sampleRates) {
+        auto start = std::chrono::steady_clock::now();
+        
+        Dicta::PreProcessor singlePreProcessor(sampleRate, {}, single);
+        Dicta::PreProcessor batchedPreProcessor(sampleRate, {}, batched);
+        
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << sampleRate << "Hz: FFT size " << singlePreProcessor.getSamplesPerFrame()
+                  << ", batch size " << batchSize << ", planned in " << elapsed.count() << "s" << std::endl;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../include/util/ContentHash.h"
+
+namespace Dicta
+{
+    namespace
+    {
+        constexpr std::uint64_t prime1 = 11400714785074694791ULL;
+        constexpr std::uint64_t prime2 = 14029467366897019727ULL;
+        constexpr std::uint64_t prime3 = 1609587929392839161ULL;
+        constexpr std::uint64_t prime4 = 9650029242287828579ULL;
+        constexpr std::uint64_t prime5 = 2870177450012600261ULL;
+        
+        inline std::uint64_t rotateLeft(std::uint64_t value, int bits)
+        { return (value << bits) | (value >> (64 - bits)); }
+        
+        // Little endian loads, unaligned
+        inline std::uint64_t read64(const std::uint8_t* bytes)
+        {
+            std::uint64_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        
+        inline std::uint32_t read32(const std::uint8_t* bytes)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        
+        inline std::uint64_t round(std::uint64_t accumulator, std::uint64_t input)
+        { return rotateLeft(accumulator + input * prime2, 31) * prime1; }
+        
+        inline std::uint64_t mergeRound(std::uint64_t hash, std::uint64_t accumulator)
+        { return (hash ^ round(0, accumulator)) * prime1 + prime4; }
+    }
+    
+    std::uint64_t contentHash(const void* data, std::size_t size, std::uint64_t seed)
+    {
+        auto bytes = static_cast<const std::uint8_t*>(data);
+        auto end = bytes + size;
+        std::uint64_t hash;
+        
+        if (size >= 32) {
+            // Four independent lanes over 32 byte stripes
+            std::uint64_t lanes[4] = {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+            for (; bytes + 32 <= end; bytes += 32)
+                for (int lane = 0; lane != 4; ++lane)
+                    lanes[lane] = round(lanes[lane], read64(bytes + 8 * lane));
+            
+            hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+            for (auto lane : lanes)
+                hash = mergeRound(hash, lane);
+        }
+        else
+            hash = seed + prime5;
+        
+        hash += size;
+        
+        for (; bytes + 8 <= end; bytes += 8)
+            hash = rotateLeft(hash ^ round(0, read64(bytes)), 27) * prime1 + prime4;
+        if (bytes + 4 <= end) {
+            hash = rotateLeft(hash ^ (read32(bytes) * prime1), 23) * prime2 + prime3;
+            bytes += 4;
+        }
+        for (; bytes != end; ++bytes)
+            hash = rotateLeft(hash ^ (*bytes * prime5), 11) * prime1;
+        
+        // Avalanche
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        hash *= prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+    
+    std::uint64_t hashFile(const std::string& fileName)
+    {
+        int fileDescriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fileDescriptor < 0)
+            throw std::runtime_error("ContentHash error: Couldn't open " + fileName + ": " + std::strerror(errno));
+        
+        struct stat status;
+        if (::fstat(fileDescriptor, &status) < 0) {
+            ::close(fileDescriptor);
+            throw std::runtime_error("ContentHash error: Couldn't stat " + fileName + ": " + std::strerror(errno));
+        }
+        auto size = static_cast<std::size_t>(status.st_size);
+        if (!size) {
+            ::close(fileDescriptor);
+            return contentHash(nullptr, 0);
+        }
+        
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        ::close(fileDescriptor);
+        if (mapping == MAP_FAILED)
+            throw std::runtime_error("ContentHash error: Couldn't map " + fileName + ": " + std::strerror(errno));
+        
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+        auto hash = contentHash(mapping, size);
+        ::munmap(mapping, size);
+        return hash;
+    }
+    
+    std::string hashToString(std::uint64_t hash)
+    {
+        static constexpr char digits[] = "0123456789abcdef";
+        std::string text(16, '0');
+        for (int digit = 15; digit >= 0; --digit, hash >>= 4)
+            text[digit] = digits[hash & 0xf];
+        return text;
+    }
+    
+    std::uint64_t hashFromString(const std::string& text)
+    {
+        if (text.size() != 16 || text.find_first_not_of("0123456789abcdef") != std::string::npos)
+            throw std::invalid_argument("ContentHash error: Not a hash: " + text);
+        return std::stoull(text, nullptr, 16);
+    }
+}
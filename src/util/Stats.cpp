@@ -0,0 +1,274 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <utility>
+#include <vector>
+#include "../../include/util/Stats.h"
+
+namespace Dicta
+{
+    const char* stageName(Stage stage)
+    {
+        switch (stage) {
+            case Stage::Callback:
+                return "callback";
+            case Stage::Framing:
+                return "framing";
+            case Stage::FFT:
+                return "fft";
+            case Stage::Mel:
+                return "mel";
+            case Stage::DCT:
+                return "dct";
+            case Stage::QueueWait:
+                return "queue-wait";
+            case Stage::Latency:
+                return "latency";
+            case Stage::Count:
+                break;
+        }
+        return "unknown";
+    }
+    
+    std::size_t LatencyHistogram::bucketOf(std::uint64_t nanoseconds)
+    {
+        nanoseconds = std::min<std::uint64_t>(nanoseconds, (std::uint64_t{1} << valueBits) - 1);
+        
+        // Small values get a bucket each, bigger ones keep their subBucketBits + 1 most significant bits
+        if (nanoseconds < subBuckets)
+            return nanoseconds;
+        
+        std::size_t mostSignificantBit = 63 - __builtin_clzll(nanoseconds);
+        std::size_t shift = mostSignificantBit - subBucketBits;
+        return subBuckets + shift * subBuckets + ((nanoseconds >> shift) - subBuckets);
+    }
+    
+    std::uint64_t LatencyHistogram::bucketValue(std::size_t bucket)
+    {
+        if (bucket < subBuckets)
+            return bucket;
+        
+        std::size_t shift = (bucket - subBuckets) / subBuckets;
+        std::uint64_t subBucket = (bucket - subBuckets) % subBuckets;
+        return ((subBuckets + subBucket + 1) << shift) - 1;
+    }
+    
+    void LatencyHistogram::record(std::uint64_t nanoseconds, std::uint64_t times)
+    {
+        auto& bucket = this->buckets[bucketOf(nanoseconds)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + times, std::memory_order_relaxed);
+        this->total.store(this->total.load(std::memory_order_relaxed) + nanoseconds * times, std::memory_order_relaxed);
+        this->count.store(this->count.load(std::memory_order_relaxed) + times, std::memory_order_relaxed);
+        
+        if (nanoseconds > this->maximum.load(std::memory_order_relaxed))
+            this->maximum.store(nanoseconds, std::memory_order_relaxed);
+    }
+    
+    void LatencyHistogram::recordShared(std::uint64_t nanoseconds, std::uint64_t times)
+    {
+        this->buckets[bucketOf(nanoseconds)].fetch_add(times, std::memory_order_relaxed);
+        this->total.fetch_add(nanoseconds * times, std::memory_order_relaxed);
+        this->count.fetch_add(times, std::memory_order_relaxed);
+        
+        auto maximum = this->maximum.load(std::memory_order_relaxed);
+        while (nanoseconds > maximum && !this->maximum.compare_exchange_weak(maximum, nanoseconds, std::memory_order_relaxed));
+    }
+    
+    void HistogramSnapshot::merge(const LatencyHistogram& histogram)
+    {
+        for (std::size_t bucket = 0; bucket != LatencyHistogram::bucketCount; ++bucket)
+            this->buckets[bucket] += histogram.buckets[bucket].load(std::memory_order_relaxed);
+        
+        this->total += histogram.total.load(std::memory_order_relaxed);
+        this->count += histogram.count.load(std::memory_order_relaxed);
+        this->maximum = std::max(this->maximum, histogram.maximum.load(std::memory_order_relaxed));
+    }
+    
+    std::uint64_t HistogramSnapshot::percentile(double percent) const
+    {
+        if (!this->count)
+            return 0;
+        
+        auto target = std::max<std::uint64_t>(std::ceil(std::clamp(percent, 0.0, 100.0) / 100 * this->count), 1);
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket != LatencyHistogram::bucketCount; ++bucket) {
+            seen += this->buckets[bucket];
+            if (seen >= target)
+                return std::min(LatencyHistogram::bucketValue(bucket), this->maximum);
+        }
+        return this->maximum;
+    }
+    
+    std::ostream& operator<<(std::ostream& out, const StatsSnapshot& snapshot)
+    {
+        out << std::left << std::setw(12) << "stage" << std::right << std::setw(12) << "count"
+            << std::setw(12) << "mean(ns)" << std::setw(12) << "p50(ns)" << std::setw(12) << "p99(ns)"
+            << std::setw(12) << "p99.9(ns)" << std::setw(12) << "max(ns)" << "\n";
+        
+        for (std::size_t stage = 0; stage != static_cast<std::size_t>(Stage::Count); ++stage) {
+            auto& histogram = snapshot.stages[stage];
+            out << std::left << std::setw(12) << stageName(static_cast<Stage>(stage)) << std::right
+                << std::setw(12) << histogram.getCount()
+                << std::setw(12) << static_cast<std::uint64_t>(histogram.getMean())
+                << std::setw(12) << histogram.percentile(50)
+                << std::setw(12) << histogram.percentile(99)
+                << std::setw(12) << histogram.percentile(99.9)
+                << std::setw(12) << histogram.getMaximum() << "\n";
+        }
+        
+        return out << "overflow holes: " << snapshot.overflowHoles << " (" << snapshot.holeSamples << " samples)"
+                   << ", device overflows: " << snapshot.deviceOverflows
+                   << ", stream errors: " << snapshot.streamErrors
+                   << ", dropped samples: " << snapshot.droppedSamples
+                   << ", frames emitted: " << snapshot.framesEmitted
+                   << ", frames dropped: " << snapshot.framesDropped
+                   << ", frames skipped: " << snapshot.framesSkipped
+                   << ", queue depth: " << snapshot.queueDepth << "\n";
+    }
+    
+    namespace
+    {
+        // Starts at 1, a zero instance marks a free ThreadBlock
+        std::atomic<std::uint64_t> nextInstance{1};
+        
+        // The block the calling thread records on for a Stats instance. Trivially destructible and constant
+        // initialized, so finding it never runs a thread local constructor nor registers a destructor.
+        struct ThreadBlock
+        {
+            std::uint64_t instance;
+            Stats::ThreadHistograms* histograms;
+        };
+        
+        thread_local std::array<ThreadBlock, 4> threadBlocks{};
+        thread_local bool realtimeThread = false;
+        
+        // Releases the calling thread's blocks on exit, keeping their storage alive until then
+        struct ThreadExitHook
+        {
+            std::vector<std::pair<std::shared_ptr<Stats::ThreadHistograms[]>, Stats::ThreadHistograms*>> blocks;
+            
+            ~ThreadExitHook()
+            {
+                for (auto& block : this->blocks)
+                    block.second->inUse.store(false, std::memory_order_release);
+            }
+        };
+        
+        // Never reached from realtime threads, registering the hook allocates
+        void releaseOnExit(std::shared_ptr<Stats::ThreadHistograms[]> threads, Stats::ThreadHistograms* histograms)
+        {
+            thread_local ThreadExitHook hook;
+            hook.blocks.emplace_back(std::move(threads), histograms);
+        }
+    }
+    
+    // Enough blocks for every worker plus the audio, framing, consumer and dumper threads, and spares for
+    // threads that come and go
+    Stats::Stats() :
+            instance(nextInstance.fetch_add(1, std::memory_order_relaxed)),
+            threadCount(std::thread::hardware_concurrency() + 16),
+            threads(new ThreadHistograms[this->threadCount])
+    {}
+    
+    void Stats::markRealtimeThread()
+    {
+        realtimeThread = true;
+    }
+    
+    Stats::ThreadHistograms& Stats::threadHistograms()
+    {
+        for (auto& block : threadBlocks) {
+            if (block.instance == this->instance)
+                return *block.histograms;
+            if (!block.instance) {
+                block = {this->instance, &this->claimThreadHistograms()};
+                return *block.histograms;
+            }
+        }
+        
+        // Threads recording on more instances than they keep blocks for share the fallback histograms
+        return this->sharedHistograms;
+    }
+    
+    Stats::ThreadHistograms& Stats::claimThreadHistograms()
+    {
+        for (std::size_t index = 0; index != this->threadCount; ++index) {
+            auto& histograms = this->threads[index];
+            bool inUse = false;
+            if (!histograms.inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire, std::memory_order_relaxed))
+                continue;
+            
+            auto used = this->threadsUsed.load(std::memory_order_relaxed);
+            while (used <= index && !this->threadsUsed.compare_exchange_weak(used, index + 1, std::memory_order_release, std::memory_order_relaxed));
+            
+            if (!realtimeThread)
+                releaseOnExit(this->threads, &histograms);
+            return histograms;
+        }
+        
+        return this->sharedHistograms;
+    }
+    
+    Stats& Stats::global()
+    {
+        static Stats stats;
+        return stats;
+    }
+    
+    StatsSnapshot Stats::snapshot() const
+    {
+        StatsSnapshot snapshot;
+        auto merge = [&snapshot](const ThreadHistograms& histograms) {
+            for (std::size_t stage = 0; stage != static_cast<std::size_t>(Stage::Count); ++stage)
+                snapshot.stages[stage].merge(histograms.stages[stage]);
+        };
+        
+        // Lock free, recording threads never wait on a merge
+        auto used = this->threadsUsed.load(std::memory_order_acquire);
+        for (std::size_t index = 0; index != used; ++index)
+            merge(this->threads[index]);
+        merge(this->sharedHistograms);
+        
+        snapshot.overflowHoles = this->overflowHoles.load(std::memory_order_relaxed);
+        snapshot.holeSamples = this->holeSamples.load(std::memory_order_relaxed);
+        snapshot.deviceOverflows = this->deviceOverflows.load(std::memory_order_relaxed);
+        snapshot.streamErrors = this->streamErrors.load(std::memory_order_relaxed);
+        snapshot.droppedSamples = this->droppedSamples.load(std::memory_order_relaxed);
+        snapshot.framesEmitted = this->framesEmitted.load(std::memory_order_relaxed);
+        snapshot.framesDropped = this->framesDropped.load(std::memory_order_relaxed);
+        snapshot.framesSkipped = this->framesSkipped.load(std::memory_order_relaxed);
+        snapshot.queueDepth = this->queueDepth.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+    
+    StatsDumper::StatsDumper(std::ostream& out, std::chrono::milliseconds interval) :
+            out(out),
+            interval(interval),
+            thread(&StatsDumper::run, this)
+    {}
+    
+    StatsDumper::~StatsDumper()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->stopCondition.notify_all();
+        this->thread.join();
+    }
+    
+    void StatsDumper::run()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (!this->stopCondition.wait_for(lock, this->interval, [this] { return this->stopping; }))
+            this->out << Stats::global().snapshot() << std::endl;
+    }
+}
@@ -0,0 +1,75 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../../include/util/ThreadOptions.h"
+
+namespace Dicta
+{
+    void ThreadOptions::apply() const
+    {
+        if (!this->cpus.empty()) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (auto cpu : this->cpus) {
+                if (cpu < 0 || cpu >= CPU_SETSIZE)
+                    throw std::invalid_argument("ThreadOptions error: No CPU " + std::to_string(cpu));
+                CPU_SET(cpu, &cpuSet);
+            }
+            if (int error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet))
+                throw std::system_error(error, std::generic_category(), "ThreadOptions error: Unable to set CPU affinity");
+        }
+        
+        if (this->realtimePriority) {
+            sched_param parameters{};
+            parameters.sched_priority = this->realtimePriority;
+            if (int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters))
+                throw std::system_error(error, std::generic_category(), "ThreadOptions error: Unable to set SCHED_FIFO priority");
+        }
+        else if (this->niceness) {
+            // Linux keeps niceness per thread, addressed by its kernel id
+            auto threadId = static_cast<id_t>(syscall(SYS_gettid));
+            if (setpriority(PRIO_PROCESS, threadId, this->niceness))
+                throw std::system_error(errno, std::generic_category(), "ThreadOptions error: Unable to set niceness");
+        }
+    }
+    
+    std::vector<int> ThreadOptions::parseCpuList(const std::string& list)
+    {
+        std::vector<int> cpus;
+        std::size_t position = 0;
+        while (position < list.size()) {
+            auto end = list.find(',', position);
+            if (end == std::string::npos)
+                end = list.size();
+            
+            auto range = list.substr(position, end - position);
+            auto dash = range.find('-');
+            try {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                if (first < 0 || last < first)
+                    throw std::invalid_argument(range);
+                for (int cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+            catch (const std::logic_error&) {
+                throw std::invalid_argument("ThreadOptions error: Bad CPU list " + list);
+            }
+            position = end + 1;
+        }
+        return cpus;
+    }
+}
@@ -0,0 +1,116 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "../../include/wisard/Thermometer.h"
+
+namespace Dicta
+{
+    Thermometer::Thermometer(std::size_t featureCount, std::size_t levelCount, float minimum, float maximum) :
+            featureCount(featureCount),
+            levelCount(levelCount),
+            thresholds(featureCount * levelCount)
+    {
+        if (!featureCount || !levelCount)
+            throw std::invalid_argument("Thermometer error: Feature and level counts must be positive");
+        if (!(minimum < maximum))
+            throw std::invalid_argument("Thermometer error: Minimum must be below maximum");
+        
+        // levelCount thresholds split the range in levelCount + 1 equal parts
+        for (std::size_t feature = 0; feature != featureCount; ++feature)
+            for (std::size_t level = 0; level != levelCount; ++level)
+                this->thresholds[feature * levelCount + level] =
+                        minimum + (maximum - minimum) * static_cast<float>(level + 1) / static_cast<float>(levelCount + 1);
+    }
+    
+    Thermometer Thermometer::fitQuantiles(const float* samples,
+                                          std::size_t sampleCount,
+                                          std::size_t featureCount,
+                                          std::size_t levelCount)
+    {
+        if (!sampleCount)
+            throw std::invalid_argument("Thermometer error: Quantiles need training samples");
+        
+        Thermometer thermometer(featureCount, levelCount, 0, 1);
+        std::vector<float> values(sampleCount);
+        for (std::size_t feature = 0; feature != featureCount; ++feature) {
+            for (std::size_t sample = 0; sample != sampleCount; ++sample)
+                values[sample] = samples[sample * featureCount + feature];
+            
+            // Quantiles (level + 1) / (levelCount + 1), each selection only sorting the part after the last one
+            auto begin = values.begin();
+            for (std::size_t level = 0; level != levelCount; ++level) {
+                auto rank = (level + 1) * sampleCount / (levelCount + 1);
+                auto quantile = values.begin() + std::min(rank, sampleCount - 1);
+                std::nth_element(begin, quantile, values.end());
+                thermometer.thresholds[feature * levelCount + level] = *quantile;
+                begin = quantile;
+            }
+        }
+        return thermometer;
+    }
+    
+    void Thermometer::encode(const float* features, std::uint64_t* bits) const
+    {
+        std::memset(bits, 0, packedWords(this->getBitCount()) * sizeof(std::uint64_t));
+        
+        for (std::size_t feature = 0; feature != this->featureCount; ++feature) {
+            const float* levels = this->getThresholds(feature);
+            std::size_t set = 0;
+            for (std::size_t level = 0; level != this->levelCount; ++level)
+                set += features[feature] > levels[level];
+            
+            // Set bits [first, first + set), at most a couple of words at a time
+            std::size_t first = feature * this->levelCount;
+            while (set) {
+                std::size_t offset = first % 64;
+                std::size_t run = std::min<std::size_t>(set, 64 - offset);
+                std::uint64_t mask = run == 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << run) - 1);
+                bits[first / 64] |= mask << offset;
+                first += run;
+                set -= run;
+            }
+        }
+    }
+    
+    void stretchFrames(const std::vector<Frame<float>>& frames,
+                       std::size_t coefficientCount,
+                       std::size_t frameCount,
+                       float* output)
+    {
+        std::vector<const float*> sources;
+        sources.reserve(frames.size());
+        for (const auto& frame : frames) {
+            if (frame.isMarker())
+                continue;
+            if (frame.size() != coefficientCount)
+                throw std::invalid_argument("Thermometer error: Frames of different sizes on an utterance");
+            sources.push_back(frame.data());
+        }
+        
+        if (sources.empty()) {
+            std::fill(output, output + frameCount * coefficientCount, 0.0f);
+            return;
+        }
+        
+        // Output frame i sits at the same relative position as source position i * (sources - 1) / (frameCount - 1)
+        double step = frameCount > 1 ? static_cast<double>(sources.size() - 1) / (frameCount - 1) : 0;
+        for (std::size_t frame = 0; frame != frameCount; ++frame) {
+            double position = frame * step;
+            auto before = std::min(static_cast<std::size_t>(position), sources.size() - 1);
+            auto after = std::min(before + 1, sources.size() - 1);
+            auto weight = static_cast<float>(position - before);
+            
+            for (std::size_t coefficient = 0; coefficient != coefficientCount; ++coefficient)
+                output[frame * coefficientCount + coefficient] =
+                        sources[before][coefficient] + weight * (sources[after][coefficient] - sources[before][coefficient]);
+        }
+    }
+}
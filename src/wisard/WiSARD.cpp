@@ -0,0 +1,188 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../../include/util/SIMD.hpp"
+#include "../../include/wisard/WiSARD.h"
+
+namespace Dicta
+{
+    std::size_t Discriminator::memoryUsage() const
+    {
+        std::size_t total = 0;
+        for (const auto& ram : this->rams)
+            total += ram.memoryUsage();
+        return total;
+    }
+    
+    WiSARD::WiSARD(std::size_t inputBits, std::size_t classCount, const WiSARDOptions& options) :
+            inputBits(inputBits),
+            options(options),
+            ramCount(options.tupleSize ? (inputBits + options.tupleSize - 1) / options.tupleSize : 0)
+    {
+        if (!inputBits || !classCount)
+            throw std::invalid_argument("WiSARD error: Input bits and class count must be positive");
+        if (!options.tupleSize || options.tupleSize > 32)
+            throw std::invalid_argument("WiSARD error: Tuple size must be between 1 and 32 bits");
+        
+        // Every input bit feeds one RAM, the last RAM topping its tuple up with bits already used.
+        // Shuffled with an explicit Fisher-Yates, std::shuffle differs across standard libraries.
+        this->mapping.resize(this->ramCount * options.tupleSize);
+        for (std::size_t bit = 0; bit != this->mapping.size(); ++bit)
+            this->mapping[bit] = static_cast<std::uint32_t>(bit % inputBits);
+        
+        std::mt19937_64 generator(options.seed);
+        for (std::size_t bit = this->mapping.size() - 1; bit; --bit)
+            std::swap(this->mapping[bit], this->mapping[generator() % (bit + 1)]);
+        
+        this->discriminators.assign(classCount, Discriminator(this->ramCount));
+        
+        if (!this->options.workerCount)
+            this->options.workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    
+    std::size_t WiSARD::memoryUsage() const
+    {
+        std::size_t total = this->mapping.size() * sizeof(std::uint32_t);
+        for (const auto& discriminator : this->discriminators)
+            total += discriminator.memoryUsage();
+        return total;
+    }
+    
+    void WiSARD::mapAddresses(const std::uint64_t* input, std::uint32_t* addresses) const
+    {
+        const std::uint32_t* bits = this->mapping.data();
+        for (std::size_t ram = 0; ram != this->ramCount; ++ram) {
+            std::uint32_t address = 0;
+            for (std::size_t bit = 0; bit != this->options.tupleSize; ++bit, ++bits)
+                address |= static_cast<std::uint32_t>((input[*bits / 64] >> (*bits % 64)) & 1) << bit;
+            addresses[ram] = address;
+        }
+    }
+    
+    void WiSARD::train(const std::uint64_t* input, std::size_t label)
+    {
+        if (label >= this->discriminators.size())
+            throw std::out_of_range("WiSARD error: Label " + std::to_string(label) + " of a classifier of "
+                                    + std::to_string(this->discriminators.size()) + " classes");
+        
+        std::vector<std::uint32_t> addresses(this->ramCount);
+        this->mapAddresses(input, addresses.data());
+        this->discriminators[label].train(addresses.data());
+    }
+    
+    void WiSARD::train(const std::uint64_t* inputs, const std::size_t* labels, std::size_t sampleCount)
+    {
+        // Samples of each class, so every worker trains whole discriminators and never shares a RAM
+        std::vector<std::vector<std::size_t>> samplesOf(this->discriminators.size());
+        for (std::size_t sample = 0; sample != sampleCount; ++sample) {
+            if (labels[sample] >= this->discriminators.size())
+                throw std::out_of_range("WiSARD error: Label " + std::to_string(labels[sample]) + " of a classifier of "
+                                        + std::to_string(this->discriminators.size()) + " classes");
+            samplesOf[labels[sample]].push_back(sample);
+        }
+        
+        std::atomic<std::size_t> nextClass{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        auto work = [&] {
+            try {
+                std::vector<std::uint32_t> addresses(this->ramCount);
+                for (auto label = nextClass++; label < samplesOf.size(); label = nextClass++)
+                    for (auto sample : samplesOf[label]) {
+                        this->mapAddresses(inputs + sample * this->getInputWords(), addresses.data());
+                        this->discriminators[label].train(addresses.data());
+                    }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        };
+        
+        auto workerCount = std::min(this->options.workerCount, samplesOf.size());
+        std::vector<std::thread> workers;
+        for (std::size_t worker = 1; worker < workerCount; ++worker)
+            workers.emplace_back(work);
+        work();
+        for (auto& worker : workers)
+            worker.join();
+        
+        if (error)
+            std::rethrow_exception(error);
+    }
+    
+    std::vector<std::size_t> WiSARD::score(const std::uint64_t* input, std::uint16_t threshold) const
+    {
+        std::vector<std::uint32_t> addresses(this->ramCount);
+        std::vector<std::uint16_t> counts(this->ramCount);
+        this->mapAddresses(input, addresses.data());
+        
+        std::vector<std::size_t> scores(this->discriminators.size());
+        for (std::size_t label = 0; label != this->discriminators.size(); ++label) {
+            this->discriminators[label].recall(addresses.data(), counts.data());
+            scores[label] = threshold ? SIMD::countAtLeast(counts.data(), this->ramCount, threshold) : this->ramCount;
+        }
+        return scores;
+    }
+    
+    Prediction WiSARD::classify(const std::uint64_t* input) const
+    {
+        auto classCount = this->discriminators.size();
+        std::vector<std::uint32_t> addresses(this->ramCount);
+        this->mapAddresses(input, addresses.data());
+        
+        // Each class's RAM responses as one row, fetched once for every bleaching round
+        std::vector<std::uint16_t> counts(classCount * this->ramCount);
+        for (std::size_t label = 0; label != classCount; ++label)
+            this->discriminators[label].recall(addresses.data(), counts.data() + label * this->ramCount);
+        std::uint16_t highestCount = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+        
+        // Winner and runner up scores at a threshold, ties going to the lowest label
+        auto round = [&](std::uint16_t threshold) {
+            Prediction prediction{0, 0, threshold, 0};
+            std::size_t runnerUp = 0;
+            for (std::size_t label = 0; label != classCount; ++label) {
+                auto score = SIMD::countAtLeast(counts.data() + label * this->ramCount, this->ramCount, threshold);
+                if (score > prediction.score) {
+                    runnerUp = prediction.score;
+                    prediction.label = label;
+                    prediction.score = score;
+                }
+                else if (score > runnerUp)
+                    runnerUp = score;
+            }
+            prediction.confidence = prediction.score
+                                    ? static_cast<double>(prediction.score - runnerUp) / prediction.score
+                                    : 0;
+            return prediction;
+        };
+        
+        auto prediction = round(1);
+        if (!this->options.bleaching)
+            return prediction;
+        
+        // Tied winners are told apart by how often their RAMs saw the input's addresses, stopping before
+        // a threshold no RAM reaches
+        for (std::size_t threshold = 2; threshold <= highestCount && prediction.score && !prediction.confidence; ++threshold) {
+            auto bleached = round(static_cast<std::uint16_t>(threshold));
+            if (!bleached.score)
+                break;
+            prediction = bleached;
+        }
+        return prediction;
+    }
+}
@@ -0,0 +1,128 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Test.h"
+#include "../include/preprocessor/DeltaFilter.h"
+
+namespace
+{
+    // Pushes frames of 2 coefficients, t and 5 - 2t for frame t, then finishes the segment
+    std::vector<std::vector<float>> filterRamp(Dicta::DeltaFilter& filter, std::size_t frameCount,
+                                               std::vector<std::int64_t>& timestamps, std::size_t& outputsWhilePushing)
+    {
+        auto pool = Dicta::FramePool<float>::create(2);
+        std::vector<std::vector<float>> outputs;
+        auto output = [&](Dicta::Frame<float> frame) {
+            outputs.emplace_back(frame.data(), frame.data() + frame.size());
+            timestamps.push_back(frame.getTimestamp());
+        };
+        
+        for (std::size_t index = 0; index != frameCount; ++index) {
+            auto frame = pool->acquire();
+            frame.push(static_cast<float>(index));
+            frame.push(5 - 2 * static_cast<float>(index));
+            frame.setTimestamp(static_cast<std::int64_t>(index) * 1000);
+            filter.push(frame, output);
+        }
+        outputsWhilePushing = outputs.size();
+        filter.finish(output);
+        return outputs;
+    }
+    
+    // The regression over values, repeating the first and last past the edges
+    std::vector<float> regression(const std::vector<float>& values, std::int64_t width)
+    {
+        auto last = static_cast<std::int64_t>(values.size()) - 1;
+        float squares = 0;
+        for (std::int64_t offset = 1; offset <= width; ++offset)
+            squares += static_cast<float>(offset * offset);
+        
+        std::vector<float> result(values.size());
+        for (std::int64_t index = 0; index <= last; ++index)
+            for (std::int64_t offset = 1; offset <= width; ++offset)
+                result[index] += offset * (values[std::min(index + offset, last)] - values[std::max<std::int64_t>(index - offset, 0)])
+                                 / (2 * squares);
+        return result;
+    }
+}
+
+TEST(DeltaFilter, RampDeltasWithClampedEdges)
+{
+    Dicta::DeltaFilter filter(2, 2);
+    REQUIRE(filter.getOutputSize() == 6);
+    REQUIRE(filter.getLatency() == 4);
+    
+    std::vector<std::int64_t> timestamps;
+    std::size_t outputsWhilePushing;
+    auto outputs = filterRamp(filter, 10, timestamps, outputsWhilePushing);
+    REQUIRE(outputs.size() == 10);
+    CHECK(outputsWhilePushing == 6);
+    
+    // Slope 1 inside, the repeated edge frames flattening the first and last two
+    std::vector<float> expectedDeltas = {0.5f, 0.8f, 1, 1, 1, 1, 1, 1, 0.8f, 0.5f};
+    std::vector<float> deltas;
+    for (std::size_t index = 0; index != outputs.size(); ++index) {
+        CHECK(timestamps[index] == static_cast<std::int64_t>(index) * 1000);
+        CHECK_NEAR(outputs[index][0], static_cast<double>(index), 0);
+        CHECK_NEAR(outputs[index][1], 5 - 2.0 * index, 0);
+        CHECK_NEAR(outputs[index][2], expectedDeltas[index], 1e-6);
+        CHECK_NEAR(outputs[index][3], -2 * expectedDeltas[index], 1e-6);
+        deltas.push_back(outputs[index][2]);
+    }
+    
+    // Delta-deltas are the same regression over the deltas, zero where the ramp's deltas are flat
+    auto deltaDeltas = regression(deltas, 2);
+    for (std::size_t index = 0; index != outputs.size(); ++index) {
+        CHECK_NEAR(outputs[index][4], deltaDeltas[index], 1e-6);
+        CHECK_NEAR(outputs[index][5], -2 * deltaDeltas[index], 1e-6);
+    }
+    CHECK_NEAR(outputs[0][4], 0.13, 1e-6);
+    CHECK_NEAR(outputs[4][4], 0, 1e-6);
+    CHECK_NEAR(outputs[5][4], 0, 1e-6);
+}
+
+TEST(DeltaFilter, SegmentsShorterThanTheLatency)
+{
+    Dicta::DeltaFilter filter(2, 2);
+    std::vector<std::int64_t> timestamps;
+    std::size_t outputsWhilePushing;
+    
+    // A single frame has nothing to regress over
+    auto outputs = filterRamp(filter, 1, timestamps, outputsWhilePushing);
+    REQUIRE(outputs.size() == 1);
+    CHECK(outputsWhilePushing == 0);
+    for (std::size_t coefficient = 2; coefficient != 6; ++coefficient)
+        CHECK_NEAR(outputs[0][coefficient], 0, 0);
+    
+    outputs = filterRamp(filter, 3, timestamps, outputsWhilePushing);
+    REQUIRE(outputs.size() == 3);
+    CHECK(outputsWhilePushing == 0);
+    auto deltas = regression({0, 1, 2}, 2);
+    for (std::size_t index = 0; index != 3; ++index)
+        CHECK_NEAR(outputs[index][2], deltas[index], 1e-6);
+}
+
+TEST(DeltaFilter, SegmentsDoNotShareFrames)
+{
+    Dicta::DeltaFilter filter(2, 1);
+    std::vector<std::int64_t> timestamps;
+    std::size_t outputsWhilePushing;
+    filterRamp(filter, 5, timestamps, outputsWhilePushing);
+    
+    // The second segment starts over at t = 0, its first frame regressed only against itself and the next one
+    timestamps.clear();
+    auto outputs = filterRamp(filter, 5, timestamps, outputsWhilePushing);
+    REQUIRE(outputs.size() == 5);
+    CHECK(timestamps.front() == 0);
+    CHECK_NEAR(outputs[0][2], 0.5, 1e-6);
+    CHECK_NEAR(outputs[2][2], 1, 1e-6);
+    CHECK_NEAR(outputs[4][2], 0.5, 1e-6);
+}
@@ -0,0 +1,179 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include "Test.h"
+#include "../include/features/FeatureCache.h"
+#include "../include/util/ContentHash.h"
+
+namespace
+{
+    Dicta::FeatureConfiguration makeConfiguration()
+    {
+        return Dicta::FeatureConfiguration{16000, 256, 128, 256, 26, Dicta::WindowType::Hann, 0, Dicta::FeatureEncoding::Float32};
+    }
+    
+    // Stores frameCount frames of 13 coefficients, coefficient k of frame n being value + n + k
+    std::string storeFrames(const Dicta::FeatureCache& cache,
+                            std::uint64_t audioHash,
+                            const Dicta::FeatureConfiguration& configuration,
+                            std::size_t frameCount,
+                            float value)
+    {
+        auto header = Dicta::FeatureHeader::make(16000, 256, 128, 13, configuration.encoding);
+        return cache.store(audioHash, configuration, header, [&](Dicta::FeatureWriter& writer) {
+            auto pool = Dicta::FramePool<float>::create(13);
+            for (std::size_t index = 0; index != frameCount; ++index) {
+                auto frame = pool->acquire();
+                for (std::size_t coefficient = 0; coefficient != 13; ++coefficient)
+                    frame.push(value + index + coefficient);
+                frame.setSequence(index);
+                writer.write(std::move(frame));
+            }
+        });
+    }
+    
+    std::size_t countFiles(const std::filesystem::path& directory)
+    {
+        std::size_t count = 0;
+        for (auto& entry : std::filesystem::recursive_directory_iterator(directory))
+            count += entry.is_regular_file();
+        return count;
+    }
+}
+
+TEST(FeatureCache, ContentHashMatchesXXH64)
+{
+    CHECK(Dicta::contentHash("") == 0xef46db3751d8e999ull);
+    CHECK(Dicta::contentHash("abc") == 0x44bc2cf5ad770999ull);
+    
+    // Long enough for the 32 byte stripes, and the same through a file
+    std::string text;
+    for (int line = 0; line != 100; ++line)
+        text += "line " + std::to_string(line) + " of some audio standing text\n";
+    CHECK(Dicta::contentHash(text) != Dicta::contentHash(text.substr(1)));
+    CHECK(Dicta::contentHash(text.data(), text.size(), 1) != Dicta::contentHash(text));
+    
+    Dicta::Testing::TemporaryDirectory directory;
+    std::ofstream(directory / "text", std::ios::binary) << text;
+    CHECK(Dicta::hashFile(directory / "text") == Dicta::contentHash(text));
+    
+    CHECK(Dicta::hashToString(0x0123456789abcdefull) == "0123456789abcdef");
+    CHECK(Dicta::hashFromString("0123456789abcdef") == 0x0123456789abcdefull);
+    bool threw = false;
+    try {
+        Dicta::hashFromString("0123456789abcdeg");
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST(FeatureCache, HitsOnlyTheStoredConfiguration)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    Dicta::FeatureCache cache(directory.getPath().string());
+    auto configuration = makeConfiguration();
+    auto audioHash = Dicta::contentHash("some audio");
+    
+    CHECK(!cache.contains(audioHash, configuration));
+    CHECK(!cache.open(audioHash, configuration));
+    
+    auto path = storeFrames(cache, audioHash, configuration, 20, 1);
+    CHECK(path == cache.entryPath(audioHash, configuration));
+    CHECK(cache.contains(audioHash, configuration));
+    
+    auto reader = cache.open(audioHash, configuration);
+    REQUIRE(reader);
+    REQUIRE(reader->size() == 20);
+    CHECK(reader->at(19)[12] == 1 + 19 + 12);
+    
+    // Any change to what features depend on misses, as does other audio
+    auto changed = configuration;
+    changed.hopLength = 160;
+    CHECK(!cache.contains(audioHash, changed));
+    CHECK(cache.entryPath(audioHash, changed) != path);
+    changed = configuration;
+    changed.encoding = Dicta::FeatureEncoding::Float16;
+    CHECK(!cache.contains(audioHash, changed));
+    changed = configuration;
+    changed.deltaWidth = 2;
+    CHECK(!cache.contains(audioHash, changed));
+    changed = configuration;
+    changed.windowType = Dicta::WindowType::Hamming;
+    CHECK(!cache.contains(audioHash, changed));
+    CHECK(!cache.contains(Dicta::contentHash("other audio"), configuration));
+    
+    // Each configuration's directory describes it
+    auto configurationPath = std::filesystem::path(path).parent_path().parent_path() / "configuration";
+    std::ifstream configurationFile(configurationPath);
+    std::string description((std::istreambuf_iterator<char>(configurationFile)), std::istreambuf_iterator<char>());
+    CHECK(description == configuration.describe() + "\n");
+}
+
+TEST(FeatureCache, StoringReplacesWholeEntries)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    Dicta::FeatureCache cache(directory.getPath().string());
+    auto configuration = makeConfiguration();
+    auto audioHash = Dicta::contentHash("some audio");
+    
+    storeFrames(cache, audioHash, configuration, 20, 1);
+    storeFrames(cache, audioHash, configuration, 5, 100);
+    auto reader = cache.open(audioHash, configuration);
+    REQUIRE(reader);
+    CHECK(reader->size() == 5);
+    CHECK(reader->at(0)[0] == 100);
+    
+    // A failed store leaves the entry as it was and no temporary file behind
+    bool threw = false;
+    try {
+        cache.store(audioHash, configuration, reader->getHeader(), [](Dicta::FeatureWriter&) {
+            throw std::runtime_error("featurizing failed");
+        });
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(cache.open(audioHash, configuration)->size() == 5);
+    CHECK(countFiles(directory.getPath()) == 2);
+}
+
+TEST(FeatureCache, DirectoryFromTheEnvironment)
+{
+    // Put back as they were for the tests after this one
+    auto restore = [](const char* name, const char* value) {
+        if (value)
+            ::setenv(name, value, 1);
+        else
+            ::unsetenv(name);
+    };
+    auto dictaDirectory = std::getenv("DICTA_CACHE_DIR");
+    std::string savedDicta = dictaDirectory ? dictaDirectory : "";
+    auto cacheHome = std::getenv("XDG_CACHE_HOME");
+    std::string savedCacheHome = cacheHome ? cacheHome : "";
+    
+    CHECK(Dicta::FeatureCache("/explicit").getDirectory() == "/explicit");
+    
+    ::setenv("DICTA_CACHE_DIR", "/from/dicta", 1);
+    ::setenv("XDG_CACHE_HOME", "/from/xdg", 1);
+    CHECK(Dicta::FeatureCache().getDirectory() == "/from/dicta");
+    ::unsetenv("DICTA_CACHE_DIR");
+    CHECK(Dicta::FeatureCache().getDirectory() == "/from/xdg/dicta/features");
+    
+    restore("DICTA_CACHE_DIR", dictaDirectory ? savedDicta.c_str() : nullptr);
+    restore("XDG_CACHE_HOME", cacheHome ? savedCacheHome.c_str() : nullptr);
+}
@@ -0,0 +1,268 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "Test.h"
+#include "../include/features/FeatureReader.h"
+#include "../include/features/FeatureWriter.h"
+
+namespace
+{
+    using Dicta::FrameMarker;
+    
+    constexpr std::uint32_t coefficientCount = 13;
+    
+    // Every record written, coefficients zeroed for markers
+    struct Stream
+    {
+        std::vector<FrameMarker> markers;
+        std::vector<float> coefficients;
+    };
+    
+    // Coefficient k of data frame n, exact in half precision. The first one sits far from zero, like log energies.
+    float coefficientValue(std::size_t frame, std::size_t coefficient)
+    {
+        if (!coefficient)
+            return static_cast<float>(frame * 37 % 256) / 4 + 200;
+        return static_cast<float>((frame * 37 + coefficient * 101) % 2048) / 64 - 16;
+    }
+    
+    // Writes utterances of frameCount data frames between start and end markers, then a stream end,
+    // sequence and timestamp following the record index
+    Stream writeStream(const std::string& fileName,
+                       Dicta::FeatureEncoding encoding,
+                       std::size_t utterances,
+                       std::size_t frameCount,
+                       std::size_t bufferedRecords)
+    {
+        Stream stream;
+        auto pool = Dicta::FramePool<float>::create(coefficientCount);
+        Dicta::FeatureWriter writer(fileName, Dicta::FeatureHeader::make(16000, 400, 160, coefficientCount, encoding),
+                                    bufferedRecords);
+        
+        std::size_t dataFrames = 0;
+        auto write = [&](Dicta::Frame<float> frame) {
+            auto index = stream.markers.size();
+            frame.setSequence(index);
+            frame.setTimestamp(static_cast<std::int64_t>(index) * 10000000);
+            stream.markers.push_back(frame.getMarker());
+            for (std::size_t coefficient = 0; coefficient != coefficientCount; ++coefficient)
+                stream.coefficients.push_back(frame.isMarker() ? 0 : frame[coefficient]);
+            writer.write(std::move(frame));
+        };
+        
+        for (std::size_t utterance = 0; utterance != utterances; ++utterance) {
+            write(Dicta::Frame<float>::makeMarker(FrameMarker::UtteranceStart));
+            for (std::size_t frame = 0; frame != frameCount; ++frame, ++dataFrames) {
+                auto coefficients = pool->acquire();
+                for (std::size_t coefficient = 0; coefficient != coefficientCount; ++coefficient)
+                    coefficients[coefficient] = coefficientValue(dataFrames, coefficient);
+                coefficients.commit(coefficientCount);
+                write(std::move(coefficients));
+            }
+            write(Dicta::Frame<float>::makeMarker(FrameMarker::UtteranceEnd));
+        }
+        write(Dicta::Frame<float>::makeMarker(FrameMarker::StreamEnd));
+        writer.flush();
+        CHECK(writer.getRecordsWritten() == stream.markers.size());
+        return stream;
+    }
+    
+    // Writes the records a reader decodes back as a new stream of the same encoding
+    void rewriteStream(const Dicta::FeatureReader& reader, const std::string& fileName)
+    {
+        auto pool = Dicta::FramePool<float>::create(coefficientCount);
+        Dicta::FeatureWriter writer(fileName, reader.getHeader());
+        for (std::size_t index = 0; index != reader.size(); ++index) {
+            auto record = reader[index];
+            auto frame = record.isMarker() ? Dicta::Frame<float>::makeMarker(record.marker) : pool->acquire();
+            if (!record.isMarker()) {
+                record.decode(frame.data());
+                frame.commit(coefficientCount);
+            }
+            frame.setSequence(record.sequence);
+            frame.setTimestamp(record.timestamp);
+            writer.write(std::move(frame));
+        }
+    }
+    
+    std::vector<char> readBytes(const std::string& fileName)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    
+    // Checks the records' prefixes against what was written, returning the decoded coefficients
+    std::vector<float> readStream(const Dicta::FeatureReader& reader, const Stream& stream)
+    {
+        std::vector<float> decoded(reader.size() * coefficientCount);
+        if (!CHECK(reader.size() == stream.markers.size()))
+            return decoded;
+        
+        CHECK(reader.decode(0, reader.size() + 5, decoded.data()) == reader.size());
+        for (std::size_t index = 0; index != reader.size(); ++index) {
+            auto record = reader[index];
+            CHECK(record.sequence == index);
+            CHECK(record.timestamp == static_cast<std::int64_t>(index) * 10000000);
+            CHECK(record.marker == stream.markers[index]);
+            CHECK(record.size() == coefficientCount);
+            // Single coefficients decode like whole records
+            if (!record.isMarker())
+                CHECK(record[coefficientCount - 1] == decoded[index * coefficientCount + coefficientCount - 1]);
+        }
+        return decoded;
+    }
+}
+
+TEST(FeatureStream, Float32RoundTripsByteForByte)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    auto stream = writeStream(directory / "written.features", Dicta::FeatureEncoding::Float32, 3, 10, 4);
+    
+    Dicta::FeatureReader reader(directory / "written.features");
+    CHECK(reader.getHeader().encoding == Dicta::FeatureEncoding::Float32);
+    CHECK(reader.getHeader().coefficientCount == coefficientCount);
+    CHECK(reader.getHeader().recordSize == 80);
+    CHECK(readStream(reader, stream) == stream.coefficients);
+    
+    rewriteStream(reader, directory / "rewritten.features");
+    CHECK(readBytes(directory / "written.features") == readBytes(directory / "rewritten.features"));
+}
+
+TEST(FeatureStream, ReaderSeesWholeRecordsOnly)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    auto fileName = directory / "partial.features";
+    writeStream(fileName, Dicta::FeatureEncoding::Float32, 1, 10, 256);
+    
+    // As if the writer were still halfway through its third record
+    REQUIRE(::truncate(fileName.c_str(), sizeof(Dicta::FeatureHeader) + 80 * 2 + 40) == 0);
+    Dicta::FeatureReader reader(fileName);
+    CHECK(reader.size() == 2);
+    CHECK(reader.at(1).sequence == 1);
+    
+    bool threw = false;
+    try {
+        reader.at(2);
+    }
+    catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST(FeatureStream, RejectsMismatchedInput)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    Dicta::FeatureWriter writer(directory / "written.features", Dicta::FeatureHeader::make(16000, 400, 160, coefficientCount));
+    
+    auto pool = Dicta::FramePool<float>::create(coefficientCount + 1);
+    auto frame = pool->acquire();
+    frame.commit(coefficientCount + 1);
+    bool threw = false;
+    try {
+        writer.write(std::move(frame));
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    
+    std::ofstream(directory / "text.features") << "not a feature stream, though long enough for a header of 64 bytes";
+    threw = false;
+    try {
+        Dicta::FeatureReader reader(directory / "text.features");
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST(FeatureStream, Float16RoundTripsByteForByte)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    auto stream = writeStream(directory / "written.features", Dicta::FeatureEncoding::Float16, 3, 10, 4);
+    
+    Dicta::FeatureReader reader(directory / "written.features");
+    CHECK(reader.getHeader().recordSize == 56);
+    CHECK(readStream(reader, stream) == stream.coefficients);
+    
+    rewriteStream(reader, directory / "rewritten.features");
+    CHECK(readBytes(directory / "written.features") == readBytes(directory / "rewritten.features"));
+}
+
+TEST(FeatureStream, Int8StaysWithinItsStepOfTheRange)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    // Segments split both at utterances and every few records
+    auto stream = writeStream(directory / "written.features", Dicta::FeatureEncoding::Int8, 3, 40, 16);
+    
+    Dicta::FeatureReader reader(directory / "written.features");
+    CHECK(reader.getHeader().recordSize == 40);
+    auto decoded = readStream(reader, stream);
+    REQUIRE(decoded.size() == stream.coefficients.size());
+    
+    // A segment's step is at most 2^(1/8) / 254 of its range, itself within its utterance's range
+    std::size_t utteranceStart = 0;
+    for (std::size_t index = 0; index != stream.markers.size(); ++index) {
+        if (stream.markers[index] == FrameMarker::UtteranceStart)
+            utteranceStart = index + 1;
+        if (stream.markers[index] != FrameMarker::UtteranceEnd)
+            continue;
+        
+        for (std::size_t coefficient = 0; coefficient != coefficientCount; ++coefficient) {
+            float minimum = stream.coefficients[utteranceStart * coefficientCount + coefficient], maximum = minimum;
+            for (auto frame = utteranceStart; frame != index; ++frame) {
+                minimum = std::min(minimum, stream.coefficients[frame * coefficientCount + coefficient]);
+                maximum = std::max(maximum, stream.coefficients[frame * coefficientCount + coefficient]);
+            }
+            
+            auto tolerance = (maximum - minimum) * std::exp2(1.0 / 8) / 508 + 1e-5;
+            for (auto frame = utteranceStart; frame != index; ++frame) {
+                auto at = frame * coefficientCount + coefficient;
+                CHECK_NEAR(decoded[at], stream.coefficients[at], tolerance);
+            }
+        }
+    }
+    
+    for (std::size_t index = 0; index != stream.markers.size(); ++index)
+        if (stream.markers[index] != FrameMarker::None)
+            for (std::size_t coefficient = 0; coefficient != coefficientCount; ++coefficient)
+                CHECK(decoded[index * coefficientCount + coefficient] == 0);
+}
+
+TEST(FeatureStream, Int8ScaleRecordsCutShortHideTheirSegment)
+{
+    Dicta::Testing::TemporaryDirectory directory;
+    auto fileName = directory / "partial.features";
+    auto stream = writeStream(fileName, Dicta::FeatureEncoding::Int8, 2, 10, 256);
+    
+    // Utterance start marker, data frames and end marker per segment, after its scale records
+    auto scaleRecords = Dicta::scaleRecordCount(coefficientCount);
+    CHECK(scaleRecords == 5);
+    auto firstSegment = scaleRecords + 12;
+    {
+        Dicta::FeatureReader reader(fileName);
+        CHECK(reader.size() == stream.markers.size());
+    }
+    
+    // Halfway through the second segment's scale records nothing of it is visible yet
+    REQUIRE(::truncate(fileName.c_str(), sizeof(Dicta::FeatureHeader) + 40 * (firstSegment + 2)) == 0);
+    Dicta::FeatureReader reader(fileName);
+    CHECK(reader.size() == 12);
+    CHECK(reader.at(11).marker == FrameMarker::UtteranceEnd);
+}
@@ -0,0 +1,99 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "Test.h"
+#include "../include/audio/Resampler.h"
+
+namespace
+{
+    // Pushes input chunkSize samples at a time, pulling whatever is ready in between, then finishes
+    std::vector<float> resample(std::size_t inputRate, std::size_t outputRate, const std::vector<float>& input, std::size_t chunkSize)
+    {
+        Dicta::PolyphaseResampler resampler(inputRate, outputRate);
+        std::vector<float> output;
+        std::vector<float> pulled(4096);
+        auto drain = [&] {
+            while (auto count = resampler.pull(pulled.data(), pulled.size()))
+                output.insert(output.end(), pulled.begin(), pulled.begin() + count);
+        };
+        
+        for (std::size_t first = 0; first < input.size(); first += chunkSize) {
+            auto count = std::min(chunkSize, input.size() - first);
+            // Everything ready is pulled each time, so what the next push allows is exactly what comes out
+            auto available = resampler.availableWith(count);
+            auto pulledBefore = output.size();
+            resampler.push(input.data() + first, count);
+            drain();
+            CHECK(output.size() - pulledBefore == available);
+        }
+        resampler.finish();
+        drain();
+        return output;
+    }
+    
+    std::vector<float> tone(std::size_t sampleRate, double frequency, std::size_t count)
+    {
+        std::vector<float> samples(count);
+        for (std::size_t sample = 0; sample != count; ++sample)
+            samples[sample] = static_cast<float>(std::sin(2 * M_PI * frequency * sample / sampleRate));
+        return samples;
+    }
+    
+    double rms(const std::vector<float>& samples, std::size_t first, std::size_t last)
+    {
+        double sum = 0;
+        for (auto sample = first; sample != last; ++sample)
+            sum += static_cast<double>(samples[sample]) * samples[sample];
+        return std::sqrt(sum / (last - first));
+    }
+}
+
+TEST(Resampler, DCGainAndLength)
+{
+    const std::pair<std::size_t, std::size_t> rates[] = {{48000, 16000}, {44100, 16000}, {16000, 48000}, {22050, 16000}};
+    for (auto [inputRate, outputRate] : rates) {
+        std::vector<float> input(inputRate / 2, 0.5f);
+        auto output = resample(inputRate, outputRate, input, 1000);
+        
+        // Every output up to the input's last sample, ceil(count * up / down)
+        auto expected = (input.size() * outputRate + inputRate - 1) / inputRate;
+        CHECK(output.size() == expected);
+        
+        // Flat away from the edges, where the filter runs into the zeros around the input
+        Dicta::PolyphaseResampler resampler(inputRate, outputRate);
+        auto edge = 2 * resampler.getTapsPerPhase();
+        REQUIRE(output.size() > 2 * edge);
+        for (auto sample = edge; sample != output.size() - edge; ++sample)
+            CHECK_NEAR(output[sample], 0.5, 0.5 * 1e-3);
+    }
+}
+
+TEST(Resampler, ChunkingDoesNotChangeTheOutput)
+{
+    auto input = tone(44100, 440, 44100 / 4);
+    auto whole = resample(44100, 16000, input, input.size());
+    CHECK(resample(44100, 16000, input, 1) == whole);
+    CHECK(resample(44100, 16000, input, 333) == whole);
+}
+
+TEST(Resampler, KeepsThePassbandAndRejectsAliases)
+{
+    Dicta::PolyphaseResampler resampler(48000, 16000);
+    auto edge = 2 * resampler.getTapsPerPhase();
+    
+    auto passed = resample(48000, 16000, tone(48000, 1000, 48000), 4096);
+    CHECK_NEAR(rms(passed, edge, passed.size() - edge), std::sqrt(0.5), std::sqrt(0.5) * 1e-2);
+    
+    // 10 kHz would fold to 6 kHz at 16 kHz, it has to be gone instead
+    auto rejected = resample(48000, 16000, tone(48000, 10000, 48000), 4096);
+    CHECK(rms(rejected, edge, rejected.size() - edge) < std::sqrt(0.5) * 1e-3);
+}
@@ -0,0 +1,123 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#ifndef DICTA_TEST_H
+#define DICTA_TEST_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Just enough of a test framework: TEST(Suite, Name) registers a test, CHECK and CHECK_NEAR report a failed
+// condition and let the test go on, REQUIRE returns from it. The tests binary runs the suites named on its
+// command line, every suite without arguments, and CTest runs each suite on its own.
+namespace Dicta
+{
+    namespace Testing
+    {
+        struct TestCase
+        {
+            const char* suite;
+            const char* name;
+            void (*run)();
+        };
+        
+        inline std::vector<TestCase>& testCases()
+        {
+            static std::vector<TestCase> cases;
+            return cases;
+        }
+        
+        // Failed checks of the test running
+        inline std::size_t& failures()
+        {
+            static std::size_t count = 0;
+            return count;
+        }
+        
+        struct Registration
+        {
+            Registration(const char* suite, const char* name, void (*run)())
+            { testCases().push_back(TestCase{suite, name, run}); }
+        };
+        
+        inline bool check(bool passed, const char* expression, const char* file, int line)
+        {
+            if (!passed) {
+                ++failures();
+                std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+            }
+            return passed;
+        }
+        
+        inline bool checkNear(double actual, double expected, double tolerance, const char* expression, const char* file, int line)
+        {
+            bool passed = std::abs(actual - expected) <= tolerance;
+            if (!passed) {
+                ++failures();
+                std::cerr << file << ":" << line << ": check failed: " << expression << ", " << actual << " is not within "
+                          << tolerance << " of " << expected << std::endl;
+            }
+            return passed;
+        }
+        
+        // A fresh directory under the system's temporary one, removed with everything in it when destroyed
+        class TemporaryDirectory
+        {
+            private:
+            std::filesystem::path path;
+            
+            public:
+            TemporaryDirectory()
+            {
+                auto pattern = (std::filesystem::temp_directory_path() / "dicta-tests-XXXXXX").string();
+                if (!::mkdtemp(pattern.data()))
+                    throw std::runtime_error("TemporaryDirectory error: Couldn't create " + pattern);
+                this->path = pattern;
+            }
+            
+            ~TemporaryDirectory()
+            {
+                std::error_code error;
+                std::filesystem::remove_all(this->path, error);
+            }
+            
+            // Deleted copy and move constructors and operators
+            TemporaryDirectory(const TemporaryDirectory&) = delete;
+            TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+            TemporaryDirectory(TemporaryDirectory&&) = delete;
+            TemporaryDirectory& operator=(TemporaryDirectory&&) = delete;
+            
+            auto& getPath() const
+            { return this->path; }
+            
+            std::string operator/(const std::string& fileName) const
+            { return (this->path / fileName).string(); }
+        };
+    }
+}
+
+#define TEST(suite, name) \
+    static void suite##_##name(); \
+    static const Dicta::Testing::Registration suite##_##name##_registration(#suite, #name, &suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition) Dicta::Testing::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    Dicta::Testing::checkNear((actual), (expected), (tolerance), #actual " ~ " #expected, __FILE__, __LINE__)
+
+#define REQUIRE(condition) \
+    do { if (!CHECK(condition)) return; } while (false)
+
+#endif //DICTA_TEST_H
@@ -0,0 +1,187 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Test.h"
+#include "../include/audio/AudioSource.h"
+#include "../include/preprocessor/PreProcessor.h"
+#include "../include/preprocessor/VoiceActivityDetector.h"
+
+namespace
+{
+    using Dicta::VoiceActivity;
+    
+    constexpr std::size_t sampleRate = 16000;
+    constexpr std::size_t hopLength = 160;
+    
+    // A hop of a 100 Hz sine, one period, at level dBFS, crossing zero too rarely to count as unvoiced
+    std::vector<float> hopAt(double level)
+    {
+        auto amplitude = std::sqrt(2 * std::pow(10.0, level / 10));
+        std::vector<float> hop(hopLength);
+        for (std::size_t sample = 0; sample != hopLength; ++sample)
+            hop[sample] = static_cast<float>(amplitude * std::sin(2 * M_PI * 100 * sample / sampleRate));
+        return hop;
+    }
+    
+    // Runs count hops, checking every one but the last is classified as expected, returning the last one's
+    VoiceActivity run(Dicta::VoiceActivityDetector& detector, const std::vector<float>& hop, std::size_t count, VoiceActivity expected)
+    {
+        for (std::size_t index = 0; index + 1 < count; ++index)
+            CHECK(detector.process(hop.data()) == expected);
+        return detector.process(hop.data());
+    }
+    
+    // Plays samples from memory
+    class MemoryAudioSource : public Dicta::AudioSource
+    {
+        private:
+        std::vector<float> samples;
+        std::size_t position = 0;
+        
+        void print(std::ostream& out) const override
+        { out << "Memory, " << this->samples.size() << " samples\n"; }
+        
+        public:
+        explicit MemoryAudioSource(std::vector<float> samples) : samples(std::move(samples))
+        {}
+        
+        int getSampleRate() const override
+        { return static_cast<int>(sampleRate); }
+        
+        void start() override
+        {}
+        
+        std::size_t read(float* destination, std::size_t count) override
+        {
+            count = std::min(count, this->samples.size() - this->position);
+            std::copy_n(this->samples.data() + this->position, count, destination);
+            this->position += count;
+            return count;
+        }
+    };
+}
+
+TEST(VoiceActivityDetector, HysteresisAndHangover)
+{
+    // 10 ms hops: starting takes 3 loud hops, ending 25 quiet ones, padding adds 10 hops of lookback
+    Dicta::VoiceActivityOptions options;
+    options.enabled = true;
+    Dicta::VoiceActivityDetector detector(options, sampleRate, hopLength);
+    CHECK(detector.getLookbackHops() == 12);
+    
+    std::vector<float> silence(hopLength, 0.0f);
+    auto loud = hopAt(-40);
+    auto between = hopAt(-51);
+    
+    // Digital silence puts the noise floor at the minimum energy, -60 dBFS
+    CHECK(run(detector, silence, 50, VoiceActivity::Silence) == VoiceActivity::Silence);
+    CHECK_NEAR(detector.getNoiseFloor(), -60, 1e-3);
+    
+    // 9 dB over the floor, between the thresholds, doesn't start an utterance however long it lasts
+    CHECK(run(detector, between, 20, VoiceActivity::Silence) == VoiceActivity::Silence);
+    CHECK_NEAR(detector.getEnergy(), -51, 0.1);
+    
+    CHECK(run(detector, loud, 3, VoiceActivity::Silence) == VoiceActivity::UtteranceStart);
+    CHECK(detector.isSpeaking());
+    
+    // but keeps one going
+    CHECK(run(detector, between, 40, VoiceActivity::Speech) == VoiceActivity::Speech);
+    
+    // Pauses shorter than the hangover don't split it
+    CHECK(run(detector, silence, 24, VoiceActivity::Speech) == VoiceActivity::Speech);
+    CHECK(run(detector, loud, 1, VoiceActivity::Speech) == VoiceActivity::Speech);
+    CHECK(run(detector, silence, 25, VoiceActivity::Speech) == VoiceActivity::UtteranceEnd);
+    CHECK(!detector.isSpeaking());
+    CHECK(run(detector, silence, 5, VoiceActivity::Silence) == VoiceActivity::Silence);
+}
+
+TEST(VoiceActivityDetector, ShortBurstsDoNotStartUtterances)
+{
+    Dicta::VoiceActivityOptions options;
+    options.enabled = true;
+    Dicta::VoiceActivityDetector detector(options, sampleRate, hopLength);
+    
+    std::vector<float> silence(hopLength, 0.0f);
+    auto loud = hopAt(-30);
+    run(detector, silence, 10, VoiceActivity::Silence);
+    
+    // Onsets must be consecutive, a quiet hop starts the count over
+    for (int burst = 0; burst != 5; ++burst) {
+        CHECK(run(detector, loud, 2, VoiceActivity::Silence) == VoiceActivity::Silence);
+        CHECK(run(detector, silence, 1, VoiceActivity::Silence) == VoiceActivity::Silence);
+    }
+    CHECK(run(detector, loud, 3, VoiceActivity::Silence) == VoiceActivity::UtteranceStart);
+}
+
+TEST(VoiceActivityDetector, LookbackFollowsTheOptions)
+{
+    Dicta::VoiceActivityOptions options;
+    options.startMilliseconds = 50;
+    options.paddingMilliseconds = 0;
+    CHECK(Dicta::VoiceActivityDetector(options, sampleRate, hopLength).getLookbackHops() == 4);
+    
+    // Partial hops round up
+    options.startMilliseconds = 1;
+    options.paddingMilliseconds = 25;
+    CHECK(Dicta::VoiceActivityDetector(options, sampleRate, hopLength).getLookbackHops() == 3);
+    
+    options.stopThreshold = options.startThreshold + 1;
+    bool threw = false;
+    try {
+        Dicta::VoiceActivityDetector detector(options, sampleRate, hopLength);
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST(VoiceActivityDetector, UtterancesStartWithTheirLookback)
+{
+    // A second of silence, half a second of tone from 1 s on, then silence again
+    std::vector<float> samples(sampleRate * 5 / 2, 0.0f);
+    for (std::size_t sample = sampleRate; sample != sampleRate * 3 / 2; ++sample)
+        samples[sample] = static_cast<float>(0.1 * std::sin(2 * M_PI * 100 * sample / sampleRate));
+    MemoryAudioSource source(std::move(samples));
+    
+    Dicta::Testing::TemporaryDirectory directory;
+    Dicta::ExecutionOptions options;
+    options.plannerOptions.effort = Dicta::PlannerEffort::Estimate;
+    options.plannerOptions.wisdomDirectory = directory.getPath().string();
+    options.voiceActivity.enabled = true;
+    Dicta::PreProcessor preProcessor(sampleRate, {}, options);
+    Dicta::PreProcessor::readFrameAndWindowRecordingBuffer(&source, &preProcessor);
+    
+    std::vector<Dicta::Frame<float>> frames;
+    Dicta::Frame<float> frame;
+    while (preProcessor.getProcessedFrames().pop(frame))
+        frames.push_back(std::move(frame));
+    REQUIRE(frames.size() > 2);
+    REQUIRE(frames.front().getMarker() == Dicta::FrameMarker::UtteranceStart);
+    
+    // Onset and padding frames come first, the utterance starting at the marker's time, padding before the tone
+    auto nanoseconds = [](std::size_t samples) { return static_cast<std::int64_t>(samples * 1000000000 / sampleRate); };
+    auto hopNanoseconds = nanoseconds(preProcessor.getHopLength());
+    auto start = frames.front().getTimestamp();
+    CHECK(start <= 1000000000 - 100000000);
+    CHECK(start >= 1000000000 - 100000000 - 2 * hopNanoseconds - nanoseconds(preProcessor.getFrameLength()));
+    
+    std::size_t dataFrames = 0;
+    for (std::size_t index = 1; index != frames.size() && !frames[index].isMarker(); ++index, ++dataFrames)
+        CHECK(frames[index].getTimestamp() == start + static_cast<std::int64_t>(dataFrames) * hopNanoseconds);
+    CHECK(static_cast<std::int64_t>(dataFrames) > 500000000 / hopNanoseconds);
+    
+    REQUIRE(1 + dataFrames < frames.size());
+    CHECK(frames[1 + dataFrames].getMarker() == Dicta::FrameMarker::UtteranceEnd);
+}
@@ -0,0 +1,142 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "../include/wisard/WiSARD.h"
+
+namespace
+{
+    constexpr std::size_t inputBits = 128;
+    
+    // Class 0 sets mostly the low half of the bits and class 1 mostly the high half, flipping a few at random
+    std::vector<std::uint64_t> makeSample(std::size_t label, std::mt19937& generator)
+    {
+        std::vector<std::uint64_t> sample(Dicta::packedWords(inputBits), 0);
+        std::uniform_int_distribution<std::size_t> flip(0, 15);
+        for (std::size_t bit = 0; bit != inputBits; ++bit) {
+            bool set = (bit < inputBits / 2) == (label == 0);
+            if (!flip(generator))
+                set = !set;
+            if (set)
+                sample[bit / 64] |= std::uint64_t{1} << (bit % 64);
+        }
+        return sample;
+    }
+}
+
+TEST(WiSARD, ClassifiesSeparableClasses)
+{
+    Dicta::WiSARDOptions options;
+    options.tupleSize = 8;
+    options.workerCount = 2;
+    Dicta::WiSARD wisard(inputBits, 2, options);
+    REQUIRE(wisard.getRAMCount() == inputBits / 8);
+    
+    std::mt19937 generator(7);
+    std::vector<std::uint64_t> inputs;
+    std::vector<std::size_t> labels;
+    for (std::size_t sample = 0; sample != 64; ++sample) {
+        auto input = makeSample(sample % 2, generator);
+        inputs.insert(inputs.end(), input.begin(), input.end());
+        labels.push_back(sample % 2);
+    }
+    wisard.train(inputs.data(), labels.data(), labels.size());
+    CHECK(wisard.getDiscriminator(0).getTrainedCount() == 32);
+    CHECK(wisard.getDiscriminator(1).getTrainedCount() == 32);
+    
+    std::size_t correct = 0;
+    for (std::size_t sample = 0; sample != 100; ++sample) {
+        auto input = makeSample(sample % 2, generator);
+        auto prediction = wisard.classify(input.data());
+        correct += prediction.label == sample % 2;
+        CHECK(prediction.score <= wisard.getRAMCount());
+    }
+    CHECK(correct >= 95);
+}
+
+TEST(WiSARD, TrainedInputIsFullyRecognized)
+{
+    Dicta::WiSARDOptions options;
+    options.tupleSize = 8;
+    options.bleaching = false;
+    Dicta::WiSARD wisard(inputBits, 3, options);
+    
+    std::mt19937 generator(11);
+    auto input = makeSample(0, generator);
+    wisard.train(input.data(), 2);
+    
+    auto scores = wisard.score(input.data());
+    CHECK(scores[0] == 0);
+    CHECK(scores[1] == 0);
+    CHECK(scores[2] == wisard.getRAMCount());
+    
+    auto prediction = wisard.classify(input.data());
+    CHECK(prediction.label == 2);
+    CHECK(prediction.threshold == 1);
+    CHECK_NEAR(prediction.confidence, 1.0, 0.0);
+}
+
+TEST(WiSARD, BleachingBreaksTies)
+{
+    std::mt19937 generator(13);
+    auto input = makeSample(1, generator);
+    
+    // Both classes recognize every address of the input, class 1 having seen it twice
+    Dicta::WiSARDOptions options;
+    options.tupleSize = 8;
+    Dicta::WiSARD bleached(inputBits, 2, options);
+    bleached.train(input.data(), 0);
+    bleached.train(input.data(), 1);
+    bleached.train(input.data(), 1);
+    
+    auto scores = bleached.score(input.data());
+    CHECK(scores[0] == scores[1]);
+    CHECK(bleached.score(input.data(), 2)[0] == 0);
+    
+    auto prediction = bleached.classify(input.data());
+    CHECK(prediction.label == 1);
+    CHECK(prediction.threshold == 2);
+    CHECK(prediction.score == bleached.getRAMCount());
+    CHECK_NEAR(prediction.confidence, 1.0, 0.0);
+    
+    // Without bleaching the tie stands and goes to the lowest label
+    options.bleaching = false;
+    Dicta::WiSARD plain(inputBits, 2, options);
+    plain.train(input.data(), 0);
+    plain.train(input.data(), 1);
+    plain.train(input.data(), 1);
+    
+    prediction = plain.classify(input.data());
+    CHECK(prediction.label == 0);
+    CHECK(prediction.threshold == 1);
+    CHECK_NEAR(prediction.confidence, 0.0, 0.0);
+}
+
+TEST(WiSARD, BleachingStopsWhenNoRAMAnswers)
+{
+    std::mt19937 generator(17);
+    auto input = makeSample(0, generator);
+    
+    // An exact tie at every threshold keeps the threshold at the highest count any RAM reached
+    Dicta::WiSARDOptions options;
+    options.tupleSize = 8;
+    Dicta::WiSARD wisard(inputBits, 2, options);
+    for (std::size_t label = 0; label != 2; ++label) {
+        wisard.train(input.data(), label);
+        wisard.train(input.data(), label);
+    }
+    
+    auto prediction = wisard.classify(input.data());
+    CHECK(prediction.label == 0);
+    CHECK(prediction.threshold == 2);
+    CHECK(prediction.score == wisard.getRAMCount());
+    CHECK_NEAR(prediction.confidence, 0.0, 0.0);
+}
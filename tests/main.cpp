@@ -0,0 +1,46 @@
+/*************************************************************\
+|-------------------------------------------------------------|
+|         Created by Ericson "Fogo" Soares on 18/10/26        |
+|-------------------------------------------------------------|
+|                 https://github.com/fogodev                  |
+|-------------------------------------------------------------|
+\*************************************************************/
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string>
+#include "Test.h"
+
+int main(int argc, char* argv[])
+{
+    using namespace Dicta::Testing;
+    
+    std::vector<std::string> suites(argv + 1, argv + argc);
+    std::size_t ran = 0, failed = 0;
+    for (auto& test : testCases()) {
+        if (!suites.empty() && std::find(suites.begin(), suites.end(), test.suite) == suites.end())
+            continue;
+        
+        failures() = 0;
+        try {
+            test.run();
+        }
+        catch (const std::exception& exception) {
+            ++failures();
+            std::cerr << test.suite << "." << test.name << ": threw " << exception.what() << std::endl;
+        }
+        
+        ++ran;
+        if (failures())
+            ++failed;
+        std::cout << (failures() ? "FAIL " : "ok   ") << test.suite << "." << test.name << std::endl;
+    }
+    
+    if (!ran) {
+        std::cerr << "No tests match" << std::endl;
+        return 1;
+    }
+    std::cout << ran - failed << " of " << ran << " tests passed" << std::endl;
+    return failed ? 1 : 0;
+}